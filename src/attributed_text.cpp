@@ -0,0 +1,351 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstring>
+#include "attributed_text.h"
+#include "basic_parser.h"
+
+namespace Bypass {
+
+	const uint32_t AttributedRun::NO_LINK;
+
+	/*!
+	 \brief Builds an `AttributedText` from the callbacks of `BasicParser`.
+
+	 The libsoldout buffers hold segments of text with their styles:
+
+	     \0 'R' style link length text
+
+	 where every number is a native uint32_t. A span restyles the segments
+	 of its content, so nesting is kept. Bytes that libsoldout copies to the
+	 output on its own, such as entities, are read as unstyled text up to
+	 the next segment.
+	 */
+	class AttributedBuilder {
+	public:
+		AttributedBuilder(AttributedText& attributedText);
+
+		void parsedBlockCode(struct buf *ob, struct buf *text);
+		void parsedBlock(Type type, struct buf *ob, struct buf *text, int extra);
+		void parsedSpan(Type type, struct buf *ob, struct buf *text, struct buf *link, struct buf *title);
+		void parsedCodeSpan(struct buf *ob, struct buf *text);
+		void parsedLinebreak(struct buf *ob);
+		void parsedNormalText(struct buf *ob, struct buf *text);
+		void parsedTopLevel(struct buf *ob, size_t offset);
+	private:
+		struct Segment {
+			uint32_t style;
+			uint32_t link;
+			const char* data;
+			size_t length;
+		};
+
+		AttributedText& attributedText;
+		std::vector<std::string> links;
+		Type blockType;
+		int blockLevel;
+		struct buf *segmentBuffer;
+		size_t segmentStart;
+		size_t segmentEnd;
+
+		static const char* readSegment(const char* at, const char* end, Segment& segment);
+		static bool endsWithNewline(struct buf *text);
+		void putSegment(struct buf *ob, uint32_t style, uint32_t link, const char* data, size_t length);
+		void restyle(struct buf *ob, struct buf *text, uint32_t style, uint32_t link);
+		uint32_t addLink(struct buf *link);
+	};
+
+	static const size_t SEGMENT_HEADER_SIZE = 2 + 3 * sizeof(uint32_t);
+
+	static uint32_t read32(const char* data) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static void put32(struct buf *ob, uint32_t value) {
+		bufput(ob, &value, sizeof(value));
+	}
+
+	AttributedBuilder::AttributedBuilder(AttributedText& attributedText)
+	: attributedText(attributedText)
+	, links()
+	, segmentBuffer(NULL)
+	{
+		blockType = PARAGRAPH;
+		blockLevel = 0;
+		segmentStart = 0;
+		segmentEnd = 0;
+	}
+
+	const char* AttributedBuilder::readSegment(const char* at, const char* end, Segment& segment) {
+		if (*at != '\0') {
+			const char* stop = static_cast<const char*>(memchr(at, '\0', end - at));
+			stop = stop ? stop : end;
+			segment.style = 0;
+			segment.link = AttributedRun::NO_LINK;
+			segment.data = at;
+			segment.length = stop - at;
+			return stop;
+		}
+
+		segment.style = read32(at + 2);
+		segment.link = read32(at + 6);
+		segment.length = read32(at + 10);
+		segment.data = at + SEGMENT_HEADER_SIZE;
+		return segment.data + segment.length;
+	}
+
+	bool AttributedBuilder::endsWithNewline(struct buf *text) {
+		const char* at = text->data;
+		const char* end = text->data + text->size;
+		char last = '\n';
+		Segment segment;
+
+		while (at < end) {
+			at = readSegment(at, end, segment);
+
+			if (segment.length > 0) {
+				last = segment.data[segment.length - 1];
+			}
+		}
+
+		return last == '\n';
+	}
+
+	void AttributedBuilder::putSegment(struct buf *ob, uint32_t style, uint32_t link, const char* data, size_t length) {
+		if (length == 0) {
+			return;
+		}
+
+		bufputc(ob, '\0');
+		bufputc(ob, 'R');
+		put32(ob, style);
+		put32(ob, link);
+		put32(ob, length);
+		segmentBuffer = ob;
+		segmentStart = ob->size;
+		bufput(ob, data, length);
+		segmentEnd = ob->size;
+	}
+
+	void AttributedBuilder::restyle(struct buf *ob, struct buf *text, uint32_t style, uint32_t link) {
+		if (!text) {
+			return;
+		}
+
+		const char* at = text->data;
+		const char* end = text->data + text->size;
+		Segment segment;
+
+		while (at < end) {
+			at = readSegment(at, end, segment);
+			putSegment(ob, segment.style | style, segment.link == AttributedRun::NO_LINK ? link : segment.link,
+				segment.data, segment.length);
+		}
+	}
+
+	uint32_t AttributedBuilder::addLink(struct buf *link) {
+		links.push_back(link ? std::string(link->data, link->size) : std::string());
+		return links.size() - 1;
+	}
+
+	// Block Element Callbacks
+
+	void AttributedBuilder::parsedBlockCode(struct buf *ob, struct buf *text) {
+		blockType = BLOCK_CODE;
+		blockLevel = 0;
+
+		if (text && text->size > 0) {
+			size_t length = text->size;
+
+			if (text->data[length - 1] == '\n') {
+				length--;
+			}
+
+			putSegment(ob, STYLE_CODE, AttributedRun::NO_LINK, text->data, length);
+			putSegment(ob, 0, AttributedRun::NO_LINK, "\n", 1);
+		}
+	}
+
+	void AttributedBuilder::parsedBlock(Type type, struct buf *ob, struct buf *text, int extra) {
+		blockType = type;
+		blockLevel = type == HEADER ? extra : 0;
+
+		if (text && text->size > 0) {
+			bufput(ob, text->data, text->size);
+
+			if (!endsWithNewline(text)) {
+				putSegment(ob, 0, AttributedRun::NO_LINK, "\n", 1);
+			}
+		}
+	}
+
+	// Span Element Callbacks
+
+	void AttributedBuilder::parsedSpan(Type type, struct buf *ob, struct buf *text, struct buf *link, struct buf *title) {
+		switch (type) {
+			case AUTOLINK:
+				if (text) {
+					putSegment(ob, STYLE_LINK, addLink(text), text->data, text->size);
+				}
+				break;
+			case LINK:
+				restyle(ob, text, STYLE_LINK, addLink(link));
+				break;
+			case DOUBLE_EMPHASIS:
+				restyle(ob, text, STYLE_BOLD, AttributedRun::NO_LINK);
+				break;
+			case EMPHASIS:
+				restyle(ob, text, STYLE_ITALIC, AttributedRun::NO_LINK);
+				break;
+			case TRIPLE_EMPHASIS:
+				restyle(ob, text, STYLE_BOLD | STYLE_ITALIC, AttributedRun::NO_LINK);
+				break;
+			case STRIKETHROUGH:
+				restyle(ob, text, STYLE_STRIKETHROUGH, AttributedRun::NO_LINK);
+				break;
+			default:
+				restyle(ob, text, 0, AttributedRun::NO_LINK);
+				break;
+		}
+	}
+
+	void AttributedBuilder::parsedCodeSpan(struct buf *ob, struct buf *text) {
+		if (text) {
+			putSegment(ob, STYLE_CODE, AttributedRun::NO_LINK, text->data, text->size);
+		}
+	}
+
+	void AttributedBuilder::parsedLinebreak(struct buf *ob) {
+		// The spaces that make the break are trimmed from the text right
+		// before it; libsoldout has already dropped the last byte of the
+		// output when it was a space.
+
+		if (segmentBuffer == ob && segmentStart >= SEGMENT_HEADER_SIZE
+			&& (ob->size == segmentEnd || ob->size + 1 == segmentEnd)
+			&& ob->data[segmentStart - SEGMENT_HEADER_SIZE] == '\0'
+			&& ob->data[segmentStart - SEGMENT_HEADER_SIZE + 1] == 'R') {
+			size_t end = ob->size;
+
+			while (end > segmentStart && ob->data[end - 1] == ' ') {
+				end--;
+			}
+
+			uint32_t length = end - segmentStart;
+			memcpy(ob->data + segmentStart - sizeof(length), &length, sizeof(length));
+			ob->size = end;
+		}
+
+		putSegment(ob, 0, AttributedRun::NO_LINK, "\n", 1);
+	}
+
+	// Low Level Callbacks
+
+	void AttributedBuilder::parsedNormalText(struct buf *ob, struct buf *text) {
+		if (text) {
+			putSegment(ob, 0, AttributedRun::NO_LINK, text->data, text->size);
+		}
+	}
+
+	void AttributedBuilder::parsedTopLevel(struct buf *ob, size_t offset) {
+		if (ob->size == 0) {
+			links.clear();
+			return;
+		}
+
+		attributedText.blocks.push_back(AttributedBlock());
+		AttributedBlock& block = attributedText.blocks.back();
+		block.type = blockType;
+		block.level = blockLevel;
+		block.links.swap(links);
+
+		const char* at = ob->data;
+		const char* end = ob->data + ob->size;
+		Segment segment;
+
+		while (at < end) {
+			at = readSegment(at, end, segment);
+
+			if (segment.length == 0) {
+				continue;
+			}
+
+			uint32_t start = block.text.size();
+			block.text.append(segment.data, segment.length);
+			block.utf16.append(segment.data, segment.length);
+
+			if (segment.style == 0 && segment.link == AttributedRun::NO_LINK) {
+				continue;
+			}
+
+			if (!block.runs.empty()) {
+				AttributedRun& last = block.runs.back();
+
+				if (last.end == start && last.style == segment.style && last.link == segment.link) {
+					last.end = block.text.size();
+					continue;
+				}
+			}
+
+			AttributedRun run = { start, (uint32_t) block.text.size(), segment.style, segment.link };
+			block.runs.push_back(run);
+		}
+
+		// Only the blocks inside are separated.
+
+		if (!block.text.empty() && block.text[block.text.size() - 1] == '\n') {
+			block.text.resize(block.text.size() - 1);
+			block.utf16.truncate(block.text.data(), block.text.size());
+
+			if (!block.runs.empty() && block.runs.back().end > block.text.size()) {
+				block.runs.back().end = block.text.size();
+
+				if (block.runs.back().start == block.runs.back().end) {
+					block.runs.pop_back();
+				}
+			}
+		}
+	}
+
+	// AttributedText
+
+	AttributedText::AttributedText()
+	: blocks()
+	{
+
+	}
+
+	AttributedText AttributedText::parse(const char* markdown) {
+		AttributedText attributedText;
+		AttributedBuilder builder(attributedText);
+		BasicParser<AttributedBuilder>(builder).parse(markdown);
+		return attributedText;
+	}
+
+	AttributedText AttributedText::parse(const std::string& markdown) {
+		return parse(markdown.c_str());
+	}
+
+	size_t AttributedText::size() const {
+		return blocks.size();
+	}
+
+	const AttributedBlock& AttributedText::operator[](size_t i) const {
+		return blocks.at(i);
+	}
+
+}
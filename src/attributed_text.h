@@ -0,0 +1,115 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_ATTRIBUTED_TEXT_H
+#define BYPASS_ATTRIBUTED_TEXT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "element.h"
+#include "utf16.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief The styles of an `AttributedRun`, as bits that combine.
+	 */
+	enum TextStyle {
+		STYLE_BOLD          = 1 << 0,
+		STYLE_ITALIC        = 1 << 1,
+		STYLE_CODE          = 1 << 2,
+		STYLE_LINK          = 1 << 3,
+		STYLE_STRIKETHROUGH = 1 << 4
+	};
+
+	/*!
+	 \brief A styled range of the text of an `AttributedBlock`.
+
+	 Offsets are in bytes of UTF-8. Four 32-bit fields and nothing else, so
+	 that an array of runs can be handed to the platform as an array of
+	 integers.
+	 */
+	struct AttributedRun {
+		static const uint32_t NO_LINK = 0xFFFFFFFF;
+
+		uint32_t start;
+		uint32_t end;
+		uint32_t style;
+		uint32_t link;
+	};
+
+	/*!
+	 \brief The text of a top-level block with its styles, flattened.
+
+	 Nested blocks, such as list items and quoted paragraphs, are separated
+	 by newlines, and so are line breaks. The runs are sorted, do not
+	 overlap, and only cover styled text: a span inside another has the
+	 styles of both, and neighbouring runs of the same style and link are
+	 merged. `link` indexes `links`. Entities such as `&amp;` are kept as
+	 written, as they are by `Parser`, and are not decoded.
+
+	 `utf16` is built as the text is copied, so that run boundaries convert
+	 to UTF-16 offsets in constant time:
+
+	     block.utf16.toUtf16(block.text.data(), run.start)
+	 */
+	struct AttributedBlock {
+		Type type;
+		int level;
+		std::string text;
+		std::vector<AttributedRun> runs;
+		std::vector<std::string> links;
+		Utf16Index utf16;
+	};
+
+	class AttributedBuilder;
+
+	/*!
+	 \brief A markdown document as blocks of attributed text, ready for
+	        native text layout.
+
+	 Spans are nested as written rather than as `Parser` builds them, so
+	 `**a *b* c**` is bold throughout.
+	 */
+	class AttributedText {
+	public:
+		AttributedText();
+
+		/*!
+		 \brief Parses markdown into attributed text.
+		 \param markdown The textual representation of the markdown as a
+		                 character array.
+		 */
+		static AttributedText parse(const char* markdown);
+
+		/*!
+		 \brief Parses markdown into attributed text.
+		 \param markdown The textual representation of the markdown as a string.
+		 */
+		static AttributedText parse(const std::string& markdown);
+
+		size_t size() const;
+		const AttributedBlock& operator[](size_t i) const;
+	private:
+		friend class AttributedBuilder;
+
+		std::vector<AttributedBlock> blocks;
+	};
+
+}
+
+#endif // BYPASS_ATTRIBUTED_TEXT_H
@@ -0,0 +1,271 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_BASIC_PARSER_H
+#define BYPASS_BASIC_PARSER_H
+
+#include <string>
+#include "element.h"
+
+extern "C" {
+#include "soldout/markdown.h"
+}
+
+#define BASIC_INPUT_UNIT 1024
+#define BASIC_OUTPUT_UNIT 64
+
+namespace Bypass {
+
+	/*!
+	 \brief Runs libsoldout over markdown and hands every callback to a
+	        builder chosen at compile time.
+
+	 The builder decides what the markdown turns into: see `TreeBuilder`,
+	 `FlatBuilder`, `EventBuilder` and `NullBuilder` in builders.h. Calls are
+	 resolved statically, so a deployment only pays for the backend it
+	 uses. A builder provides:
+
+	     void parsedBlockCode(struct buf *ob, struct buf *text);
+	     void parsedBlock(Type type, struct buf *ob, struct buf *text, int extra);
+	     void parsedSpan(Type type, struct buf *ob, struct buf *text,
+	                     struct buf *link, struct buf *title);
+	     void parsedCodeSpan(struct buf *ob, struct buf *text);
+	     void parsedLinebreak(struct buf *ob);
+	     void parsedNormalText(struct buf *ob, struct buf *text);
+	     void parsedTopLevel(struct buf *ob, size_t offset);
+
+	 The first six mirror the libsoldout callbacks, with the syntax Bypass
+	 does not support already filtered out: a single `~` is not a span, and
+	 `~~` is reported as `STRIKETHROUGH`. `extra` is the level of a `HEADER`
+	 and the libsoldout flags of a `LIST`, such as `MKD_LIST_ORDERED`. The
+	 `link` of an `AUTOLINK` is its target, with `mailto:` added to a bare
+	 e-mail address. `parsedTopLevel` receives the
+	 output of each top-level step together with where it started in the
+	 input, and the buffer is emptied after it returns.
+
+	 `Parser` does not use this template: it also carries the parse limits,
+	 the caches, lazy inline parsing and incremental reparsing.
+	 */
+	template <class Builder>
+	class BasicParser {
+	public:
+
+		/*!
+		 \brief Creates a `BasicParser` that feeds the given builder.
+		 \param builder The builder. It must outlive the parser.
+		 */
+		BasicParser(Builder& builder)
+		: builder(builder)
+		{
+
+		}
+
+		/*!
+		 \brief Parses the given markdown into the builder.
+		 \param markdown The textual representation of the markdown as a
+		                 character array.
+		 */
+		void parse(const char* markdown) {
+			if (!markdown) {
+				return;
+			}
+
+			struct buf *ib = bufnew(BASIC_INPUT_UNIT);
+			bufputs(ib, markdown);
+
+			struct mkd_renderer callbacks = getCallbacks();
+			callbacks.opaque = &builder;
+			struct mkd_document *document = mkd_document_new(ib, &callbacks);
+			bufrelease(ib);
+
+			struct buf *ob = bufnew(BASIC_OUTPUT_UNIT);
+
+			while (mkd_document_remaining(document)) {
+				size_t offset = mkd_document_offset(document);
+				mkd_document_step(ob, document, 0);
+				builder.parsedTopLevel(ob, offset);
+				ob->size = 0;
+			}
+
+			bufrelease(ob);
+			mkd_document_free(document);
+		}
+
+		/*!
+		 \brief Parses the given markdown into the builder.
+		 \param markdown The textual representation of the markdown as a string.
+		 */
+		void parse(const std::string& markdown) {
+			parse(markdown.c_str());
+		}
+
+		/*!
+		 \brief Gets the builder.
+		 */
+		Builder& getBuilder() {
+			return builder;
+		}
+	private:
+		Builder& builder;
+
+		static Builder& from(void *opaque) {
+			return *static_cast<Builder*>(opaque);
+		}
+
+		// Block Element callbacks
+
+		static void blockCode(struct buf *ob, struct buf *text, void *opaque) {
+			from(opaque).parsedBlockCode(ob, text);
+		}
+
+		static void blockQuote(struct buf *ob, struct buf *text, void *opaque) {
+			from(opaque).parsedBlock(BLOCK_QUOTE, ob, text, 0);
+		}
+
+		static void header(struct buf *ob, struct buf *text, int level, void *opaque) {
+			from(opaque).parsedBlock(HEADER, ob, text, level);
+		}
+
+		static void list(struct buf *ob, struct buf *text, int flags, void *opaque) {
+			from(opaque).parsedBlock(LIST, ob, text, flags);
+		}
+
+		static void listItem(struct buf *ob, struct buf *text, int flags, void *opaque) {
+			from(opaque).parsedBlock(LIST_ITEM, ob, text, 0);
+		}
+
+		static void paragraph(struct buf *ob, struct buf *text, void *opaque) {
+			from(opaque).parsedBlock(PARAGRAPH, ob, text, 0);
+		}
+
+		// Span Element callbacks
+
+		static int autolink(struct buf *ob, struct buf *link, enum mkd_autolink type, void *opaque) {
+			if (type == MKDA_NOT_AUTOLINK) {
+				return 0;
+			}
+
+			if (type != MKDA_IMPLICIT_EMAIL) {
+				from(opaque).parsedSpan(AUTOLINK, ob, link, link, NULL);
+				return 1;
+			}
+
+			struct buf *target = bufnew(BASIC_OUTPUT_UNIT);
+			BUFPUTSL(target, "mailto:");
+			bufput(target, link->data, link->size);
+			from(opaque).parsedSpan(AUTOLINK, ob, link, target, NULL);
+			bufrelease(target);
+			return 1;
+		}
+
+		static int codeSpan(struct buf *ob, struct buf *text, void *opaque) {
+			from(opaque).parsedCodeSpan(ob, text);
+			return 1;
+		}
+
+		static int doubleEmphasis(struct buf *ob, struct buf *text, char c, void *opaque) {
+			from(opaque).parsedSpan(c == '~' ? STRIKETHROUGH : DOUBLE_EMPHASIS, ob, text, NULL, NULL);
+			return 1;
+		}
+
+		static int emphasis(struct buf *ob, struct buf *text, char c, void *opaque) {
+			if (c == '~') {
+				return 0;
+			}
+
+			from(opaque).parsedSpan(EMPHASIS, ob, text, NULL, NULL);
+			return 1;
+		}
+
+		static int linebreak(struct buf *ob, void *opaque) {
+			from(opaque).parsedLinebreak(ob);
+			return 1;
+		}
+
+		static int link(struct buf *ob, struct buf *link, struct buf *title, struct buf *content, void *opaque) {
+			from(opaque).parsedSpan(LINK, ob, content, link, title);
+			return 1;
+		}
+
+		static int tripleEmphasis(struct buf *ob, struct buf *text, char c, void *opaque) {
+			if (c == '~') {
+				return 0;
+			}
+
+			from(opaque).parsedSpan(TRIPLE_EMPHASIS, ob, text, NULL, NULL);
+			return 1;
+		}
+
+		// Low Level Callbacks
+
+		static void normalText(struct buf *ob, struct buf *text, void *opaque) {
+			from(opaque).parsedNormalText(ob, text);
+		}
+
+		static struct mkd_renderer getCallbacks() {
+			struct mkd_renderer callbacks = {
+				/* document-level callbacks */
+				NULL,                 // prolog
+				NULL,                 // epilogue
+
+				/* block-level callbacks */
+				blockCode,            // block code
+				blockQuote,           // block quote
+				NULL,                 // block html
+				header,               // header
+				NULL,                 // hrule
+				list,                 // list
+				listItem,             // listitem
+				paragraph,            // paragraph
+				NULL,                 // table
+				NULL,                 // table cell
+				NULL,                 // table row
+
+				/* span-level callbacks */
+				autolink,             // autolink
+				codeSpan,             // codespan
+				doubleEmphasis,       // double emphasis
+				emphasis,             // emphasis
+				NULL,                 // image
+				linebreak,            // line break
+				link,                 // link
+				NULL,                 // raw html tag
+				tripleEmphasis,       // triple emphasis
+
+				/* low-level callbacks */
+				NULL,                 // entity
+				normalText,           // normal text
+
+				/* control callbacks */
+				NULL,                 // halt
+				NULL,                 // defer inline
+
+				/* position callback */
+				NULL,                 // source
+
+				/* renderer data */
+				64, // max stack
+				"*_~",
+				NULL // opaque
+			};
+
+			return callbacks;
+		}
+	};
+
+}
+
+#endif // BYPASS_BASIC_PARSER_H
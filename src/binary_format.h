@@ -0,0 +1,74 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_BINARY_FORMAT_H
+#define BYPASS_BINARY_FORMAT_H
+
+#include <stdint.h>
+
+/*
+ The binary form of a `Document`, written by `DocumentWriter` and read in
+ place by `DocumentView`. Every integer is an unsigned 32-bit little-endian
+ value and every section starts on a 4-byte boundary, so the whole file can
+ be mapped into memory and read without being decoded first.
+
+     header   "BYPD", version, 0, 0
+     frame    one per top-level block, in document order:
+                nodeCount, attributeCount, stringsSize, 0
+                nodes       nodeCount x 7 values:
+                              type, textOffset, textLength, firstChild,
+                              childCount, firstAttribute, attributeCount
+                attributes  attributeCount x 3 values:
+                              key, valueOffset, valueLength
+                strings     stringsSize bytes, padded to 4
+              Node 0 of a frame is the block itself, and the children of a
+              node are stored next to each other (breadth first). Child,
+              attribute and string offsets are relative to the frame.
+     keys     keyCount, then keyCount x (offset, length) into the key bytes
+              that follow, padded to 4. Attribute keys are indices into this
+              table, so each distinct key is stored once.
+     index    blockCount x 3 values: frame offset, id, source offset
+     trailer  blockCount, index offset, keys offset, status, version, "BYPE"
+ */
+
+#define BINARY_VERSION 1
+#define BINARY_HEADER_SIZE 16
+#define BINARY_FRAME_HEADER_SIZE 16
+#define BINARY_NODE_SIZE 28
+#define BINARY_ATTRIBUTE_SIZE 12
+#define BINARY_INDEX_ENTRY_SIZE 12
+#define BINARY_TRAILER_SIZE 24
+
+// The deepest frame a reader accepts, well past what libsoldout nests to
+// with its work stack of 64, so that reading a frame recursively is safe.
+#define BINARY_MAX_DEPTH 128
+
+namespace Bypass {
+
+	inline uint32_t readBinary32(const unsigned char* data) {
+		return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+	}
+
+	inline void writeBinary32(unsigned char* data, uint32_t value) {
+		data[0] = value & 0xFF;
+		data[1] = (value >> 8) & 0xFF;
+		data[2] = (value >> 16) & 0xFF;
+		data[3] = (value >> 24) & 0xFF;
+	}
+
+}
+
+#endif // BYPASS_BINARY_FORMAT_H
@@ -0,0 +1,124 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "block_cache.h"
+#include "hash.h"
+
+namespace Bypass {
+
+	// The cost of an entry on top of its markdown and elements: the list
+	// node and the index node, estimated.
+	const static size_t ENTRY_OVERHEAD = sizeof(void*) * 8;
+
+	BlockCache::BlockCache(size_t budget)
+	: mutex()
+	, entries()
+	, index()
+	, budget(budget)
+	{
+		bytes = 0;
+		hits = 0;
+		misses = 0;
+		evictions = 0;
+	}
+
+	BlockCache::~BlockCache() {
+
+	}
+
+	bool BlockCache::find(const char* data, size_t length, uint64_t context, std::vector<std::shared_ptr<const Element> >& blocks) {
+		uint64_t key = hash64(data, length, context);
+		std::lock_guard<std::mutex> lock(mutex);
+		std::unordered_map<uint64_t, EntryList::iterator>::iterator it = index.find(key);
+
+		if (it == index.end() || it->second->context != context
+			|| it->second->markdown.compare(0, std::string::npos, data, length) != 0) {
+			misses++;
+			return false;
+		}
+
+		entries.splice(entries.begin(), entries, it->second);
+		blocks = it->second->blocks;
+		hits++;
+		return true;
+	}
+
+	void BlockCache::store(const char* data, size_t length, uint64_t context, const std::vector<std::shared_ptr<const Element> >& blocks) {
+		size_t footprint = sizeof(Entry) + ENTRY_OVERHEAD + length
+			+ blocks.size() * sizeof(std::shared_ptr<const Element>);
+
+		for (size_t i = 0; i < blocks.size(); i++) {
+			footprint += blocks[i]->getFootprint();
+		}
+
+		if (footprint > budget) {
+			return;
+		}
+
+		Entry entry;
+		entry.key = hash64(data, length, context);
+		entry.context = context;
+		entry.markdown.assign(data, length);
+		entry.blocks = blocks;
+		entry.footprint = footprint;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		std::unordered_map<uint64_t, EntryList::iterator>::iterator it = index.find(entry.key);
+
+		if (it != index.end()) {
+			erase(it->second);
+		}
+
+		entries.push_front(entry);
+		index[entry.key] = entries.begin();
+		bytes += footprint;
+
+		while (bytes > budget) {
+			erase(--entries.end());
+			evictions++;
+		}
+	}
+
+	void BlockCache::clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.clear();
+		index.clear();
+		bytes = 0;
+	}
+
+	BlockCache::Statistics BlockCache::getStatistics() {
+		std::lock_guard<std::mutex> lock(mutex);
+		Statistics statistics;
+		statistics.hits = hits;
+		statistics.misses = misses;
+		statistics.evictions = evictions;
+		statistics.entries = entries.size();
+		statistics.bytes = bytes;
+		return statistics;
+	}
+
+	double BlockCache::getHitRate() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return hits + misses ? (double) hits / (hits + misses) : 0;
+	}
+
+	void BlockCache::erase(EntryList::iterator entry) {
+		bytes -= entry->footprint;
+		index.erase(entry->key);
+		entries.erase(entry);
+	}
+
+}
@@ -0,0 +1,127 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_BLOCK_CACHE_H
+#define BYPASS_BLOCK_CACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "element.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief A cache of parsed top-level blocks, for input that repeats the
+	        same blocks over and over.
+
+	 Set `ParseOptions::blockCache` to use it. Before a top-level block is
+	 parsed, the parser looks up its normalized markdown (references and
+	 carriage returns removed) together with a fingerprint of the reference
+	 definitions in effect. On a hit the cached elements are shared instead
+	 of being parsed again. Entries are evicted least recently used first once
+	 the memory budget is exceeded.
+
+	 A `BlockCache` may be shared by parsers on several threads.
+	 */
+	class BlockCache {
+	public:
+
+		/*!
+		 \brief Counters describing how a `BlockCache` has been used.
+		 */
+		struct Statistics {
+			size_t hits;
+			size_t misses;
+			size_t evictions;
+			size_t entries;
+			size_t bytes;
+		};
+
+		/*!
+		 \brief Creates an empty `BlockCache`.
+		 \param budget The number of bytes the cache may hold, as estimated by
+		               `Element::getFootprint` plus the cached markdown.
+		 */
+		BlockCache(size_t budget);
+
+		/*!
+		 \brief Destroys the `BlockCache`. Elements still used by a `Document`
+		        stay alive.
+		 */
+		~BlockCache();
+
+		/*!
+		 \brief Looks up the elements parsed from a block of markdown.
+		 \param data The normalized markdown of the block.
+		 \param length The length of the markdown in bytes.
+		 \param context The fingerprint of the reference definitions and of
+		                anything else the parse depends on.
+		 \param blocks Receives the cached elements on a hit.
+		 \return Whether or not the block was found.
+		 */
+		bool find(const char* data, size_t length, uint64_t context, std::vector<std::shared_ptr<const Element> >& blocks);
+
+		/*!
+		 \brief Adds the elements parsed from a block of markdown, evicting
+		        older entries as needed. Entries larger than the whole budget
+		        are not kept.
+		 */
+		void store(const char* data, size_t length, uint64_t context, const std::vector<std::shared_ptr<const Element> >& blocks);
+
+		/*!
+		 \brief Drops every entry. The counters are kept.
+		 */
+		void clear();
+
+		/*!
+		 \brief Gets the counters of this cache.
+		 */
+		Statistics getStatistics();
+
+		/*!
+		 \brief The share of lookups that were hits, or 0 before any lookup.
+		 */
+		double getHitRate();
+
+	private:
+		struct Entry {
+			uint64_t key;
+			uint64_t context;
+			std::string markdown;
+			std::vector<std::shared_ptr<const Element> > blocks;
+			size_t footprint;
+		};
+
+		typedef std::list<Entry> EntryList;
+
+		std::mutex mutex;
+		EntryList entries;
+		std::unordered_map<uint64_t, EntryList::iterator> index;
+		size_t budget;
+		size_t bytes;
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		void erase(EntryList::iterator entry);
+	};
+
+}
+
+#endif // BYPASS_BLOCK_CACHE_H
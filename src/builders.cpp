@@ -0,0 +1,439 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdint.h>
+#include "builders.h"
+
+namespace Bypass {
+
+	const size_t FlatNode::NO_PARENT;
+
+	static uint32_t read32(const char* data) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static void put32(struct buf *ob, uint32_t value) {
+		bufput(ob, &value, sizeof(value));
+	}
+
+	static void putString(struct buf *ob, const char* data, size_t length) {
+		put32(ob, length);
+		bufput(ob, data, length);
+	}
+
+	static void putTag(struct buf *ob, char tag) {
+		bufputc(ob, '\0');
+		bufputc(ob, tag);
+	}
+
+	static const char* skipAttributes(const char* at) {
+		uint32_t count = read32(at);
+		at += 4;
+
+		for (uint32_t i = 0; i < 2 * count; i++) {
+			at += 4 + read32(at);
+		}
+
+		return at;
+	}
+
+	const char* RecordBuilder::readRecord(const char* at, const char* end, Record& record) {
+		record.attributes = NULL;
+
+		if (*at != '\0') {
+			const char* stop = static_cast<const char*>(memchr(at, '\0', end - at));
+			stop = stop ? stop : end;
+			record.tag = 'T';
+			record.text = TextView(at, stop - at);
+			return stop;
+		}
+
+		record.tag = at[1];
+		at += 2;
+
+		if (record.tag != 'T') {
+			record.type = (Type) read32(at);
+			at += 4;
+		}
+
+		if (record.tag == 'B') {
+			record.attributes = at;
+			at = skipAttributes(at);
+			record.content = at + 4;
+			record.contentEnd = record.content + read32(at);
+			return record.contentEnd;
+		}
+
+		record.text = TextView(at + 4, read32(at));
+		at += 4 + record.text.length;
+
+		if (record.tag == 'S') {
+			record.attributes = at;
+			at = skipAttributes(at);
+		}
+
+		return at;
+	}
+
+	static bool equals(const TextView& a, const TextView& b) {
+		return a.length == b.length && memcmp(a.data, b.data, a.length) == 0;
+	}
+
+	static bool precedes(const TextView& a, const TextView& b) {
+		int order = memcmp(a.data, b.data, std::min(a.length, b.length));
+		return order < 0 || (order == 0 && a.length < b.length);
+	}
+
+	// Writes a span with the attributes of an existing record plus the given
+	// ones, which replace any of the same name, in name order. Spans carry
+	// at most a link and a title, so a few slots are enough.
+	static void putSpan(struct buf *ob, Type type, const TextView& text, const Attributes& attributes,
+		const TextView* names = NULL, const TextView* values = NULL, size_t added = 0) {
+		const size_t SLOTS = 8;
+		TextView slotNames[SLOTS];
+		TextView slotValues[SLOTS];
+		size_t count = 0;
+
+		for (size_t i = 0; i < attributes.size() && count < SLOTS; i++) {
+			bool replaced = false;
+
+			for (size_t j = 0; j < added; j++) {
+				replaced = replaced || equals(attributes.getName(i), names[j]);
+			}
+
+			if (!replaced) {
+				slotNames[count] = attributes.getName(i);
+				slotValues[count++] = attributes.getValue(i);
+			}
+		}
+
+		for (size_t j = 0; j < added && count < SLOTS; j++) {
+			slotNames[count] = names[j];
+			slotValues[count++] = values[j];
+		}
+
+		for (size_t i = 1; i < count; i++) {
+			for (size_t k = i; k > 0 && precedes(slotNames[k], slotNames[k - 1]); k--) {
+				std::swap(slotNames[k], slotNames[k - 1]);
+				std::swap(slotValues[k], slotValues[k - 1]);
+			}
+		}
+
+		putTag(ob, 'S');
+		put32(ob, type);
+		putString(ob, text.data, text.length);
+		put32(ob, count);
+
+		for (size_t i = 0; i < count; i++) {
+			putString(ob, slotNames[i].data, slotNames[i].length);
+			putString(ob, slotValues[i].data, slotValues[i].length);
+		}
+	}
+
+	// RecordBuilder
+
+	RecordBuilder::RecordBuilder()
+	: textBuffer(NULL)
+	{
+		textStart = 0;
+		textEnd = 0;
+	}
+
+	void RecordBuilder::putText(struct buf *ob, const char* data, size_t length) {
+		putTag(ob, 'T');
+		textStart = ob->size;
+		putString(ob, data, length);
+		textBuffer = ob;
+		textEnd = ob->size;
+	}
+
+	// Block Element Callbacks
+
+	void RecordBuilder::parsedBlockCode(struct buf *ob, struct buf *text) {
+		if (!text) return;
+
+		putTag(ob, 'B');
+		put32(ob, BLOCK_CODE);
+		put32(ob, 0);
+
+		if (text->size > 0) {
+			size_t length = text->size;
+
+			if (text->data[length - 1] == '\n') {
+				length--;
+			}
+
+			put32(ob, 2 + 4 + length);
+			putText(ob, text->data, length);
+		} else {
+			put32(ob, 0);
+		}
+	}
+
+	void RecordBuilder::parsedBlock(Type type, struct buf *ob, struct buf *text, int extra) {
+		putTag(ob, 'B');
+		put32(ob, type);
+
+		if (type == HEADER) {
+			char levelStr[2];
+			snprintf(levelStr, 2, "%d", extra);
+			put32(ob, 1);
+			putString(ob, "level", 5);
+			putString(ob, levelStr, 1);
+		} else {
+			put32(ob, 0);
+		}
+
+		if (text) {
+			putString(ob, text->data, text->size);
+		} else {
+			put32(ob, 0);
+		}
+	}
+
+	// Span Element Callbacks
+
+	void RecordBuilder::parsedSpan(Type type, struct buf *ob, struct buf *text, struct buf *link, struct buf *title) {
+		if (type == AUTOLINK) {
+			TextView name("link", 4);
+			TextView value = text ? TextView(text->data, text->size) : TextView();
+			putSpan(ob, type, value, Attributes(), &name, &value, 1);
+		} else if (!text) {
+			putSpan(ob, type, TextView(), Attributes());
+		} else if (text->size > 0) {
+			// Like Parser, the span takes over the text and attributes of the
+			// first span inside it; the others follow it as siblings.
+
+			Record first;
+			const char* end = text->data + text->size;
+			const char* rest = readRecord(text->data, end, first);
+			TextView names[2];
+			TextView values[2];
+			size_t added = 0;
+
+			if (type == LINK && link && link->size) {
+				names[added] = TextView("link", 4);
+				values[added++] = TextView(link->data, link->size);
+			}
+
+			if (type == LINK && title && title->size) {
+				names[added] = TextView("title", 5);
+				values[added++] = TextView(title->data, title->size);
+			}
+
+			putSpan(ob, type, first.text, Attributes(first.attributes), names, values, added);
+			bufput(ob, rest, end - rest);
+		}
+	}
+
+	void RecordBuilder::parsedCodeSpan(struct buf *ob, struct buf *text) {
+		if (text && text->size > 0) {
+			putSpan(ob, CODE_SPAN, TextView(text->data, text->size), Attributes());
+		}
+	}
+
+	void RecordBuilder::parsedLinebreak(struct buf *ob) {
+		// The two spaces that make the break are trimmed from the text right
+		// before it; libsoldout has already dropped the last byte of the
+		// output when it was a space.
+
+		if (textBuffer == ob && textStart >= 2 && (ob->size == textEnd || ob->size + 1 == textEnd)
+			&& ob->data[textStart - 2] == '\0' && ob->data[textStart - 1] == 'T') {
+			uint32_t length = read32(ob->data + textStart);
+
+			if (length >= 2 && textStart + 4 + length == textEnd && memcmp(ob->data + textEnd - 2, "  ", 2) == 0) {
+				length -= 2;
+				memcpy(ob->data + textStart, &length, sizeof(length));
+				ob->size = textStart + 4 + length;
+			}
+		}
+
+		putSpan(ob, LINEBREAK, TextView(), Attributes());
+	}
+
+	// Low Level Callbacks
+
+	void RecordBuilder::parsedNormalText(struct buf *ob, struct buf *text) {
+		if (text && text->size > 0) {
+			putText(ob, text->data, text->size);
+		}
+	}
+
+	// EventBuilder
+
+	EventBuilder::EventBuilder(Handler& handler)
+	: handler(handler)
+	{
+
+	}
+
+	void EventBuilder::parsedTopLevel(struct buf *ob, size_t offset) {
+		replay(ob->data, ob->data + ob->size);
+	}
+
+	void EventBuilder::replay(const char* at, const char* end) {
+		Record record;
+
+		while (at < end) {
+			at = readRecord(at, end, record);
+
+			switch (record.tag) {
+				case 'T':
+					handler.text(record.text);
+					break;
+				case 'S':
+					handler.span(record.type, record.text, Attributes(record.attributes));
+					break;
+				case 'B':
+					handler.enterBlock(record.type, Attributes(record.attributes));
+					replay(record.content, record.contentEnd);
+					handler.exitBlock(record.type);
+					break;
+			}
+		}
+	}
+
+	// TreeBuilder
+
+	TreeBuilder::TreeBuilder()
+	: document()
+	{
+
+	}
+
+	void TreeBuilder::parsedTopLevel(struct buf *ob, size_t offset) {
+		const char* at = ob->data;
+		const char* end = ob->data + ob->size;
+		Record record;
+
+		while (at < end) {
+			at = readRecord(at, end, record);
+			Element* element = new Element();
+			build(record, *element);
+			element->updateHash();
+			document.append(std::shared_ptr<const Element>(element), document.nextId, offset);
+		}
+	}
+
+	Document& TreeBuilder::getDocument() {
+		return document;
+	}
+
+	void TreeBuilder::build(const Record& record, Element& element) {
+		Attributes attributes(record.attributes);
+		element.type = record.tag == 'T' ? TEXT : record.type;
+
+		if (record.tag != 'B') {
+			element.text.assign(record.text.data, record.text.length);
+		}
+
+		for (size_t i = 0; i < attributes.size(); i++) {
+			element.addAttribute(attributes.getName(i).toString(), attributes.getValue(i).toString());
+		}
+
+		if (record.tag == 'B') {
+			const char* at = record.content;
+			Record child;
+
+			while (at < record.contentEnd) {
+				at = readRecord(at, record.contentEnd, child);
+				element.children.push_back(Element());
+				build(child, element.children.back());
+				element.children.back().updateHash();
+			}
+		}
+	}
+
+	// FlatBuilder
+
+	FlatBuilder::FlatBuilder()
+	: nodes()
+	, attributes()
+	, strings()
+	{
+
+	}
+
+	void FlatBuilder::parsedTopLevel(struct buf *ob, size_t offset) {
+		const char* at = ob->data;
+		const char* end = ob->data + ob->size;
+		Record record;
+
+		while (at < end) {
+			at = readRecord(at, end, record);
+			flatten(record, FlatNode::NO_PARENT);
+		}
+	}
+
+	const std::vector<FlatNode>& FlatBuilder::getNodes() const {
+		return nodes;
+	}
+
+	const std::vector<FlatAttribute>& FlatBuilder::getAttributes() const {
+		return attributes;
+	}
+
+	const std::string& FlatBuilder::getStrings() const {
+		return strings;
+	}
+
+	void FlatBuilder::flatten(const Record& record, size_t parent) {
+		Attributes recordAttributes(record.attributes);
+		size_t index = nodes.size();
+		FlatNode node;
+		node.type = record.tag == 'T' ? TEXT : record.type;
+		node.parent = parent;
+		node.textOffset = strings.size();
+		node.textLength = record.tag == 'B' ? 0 : record.text.length;
+		node.firstAttribute = attributes.size();
+		node.attributeCount = recordAttributes.size();
+		strings.append(record.text.data, node.textLength);
+
+		for (size_t i = 0; i < recordAttributes.size(); i++) {
+			TextView name = recordAttributes.getName(i);
+			TextView value = recordAttributes.getValue(i);
+			FlatAttribute attribute;
+			attribute.nameOffset = strings.size();
+			attribute.nameLength = name.length;
+			strings.append(name.data, name.length);
+			attribute.valueOffset = strings.size();
+			attribute.valueLength = value.length;
+			strings.append(value.data, value.length);
+			attributes.push_back(attribute);
+		}
+
+		nodes.push_back(node);
+
+		if (record.tag == 'B') {
+			const char* at = record.content;
+			Record child;
+
+			while (at < record.contentEnd) {
+				at = readRecord(at, record.contentEnd, child);
+				flatten(child, index);
+			}
+		}
+
+		nodes[index].end = nodes.size();
+	}
+
+}
@@ -0,0 +1,191 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_BUILDERS_H
+#define BYPASS_BUILDERS_H
+
+#include <string>
+#include <vector>
+#include "document.h"
+#include "element.h"
+#include "handler.h"
+
+extern "C" {
+#include "soldout/markdown.h"
+}
+
+namespace Bypass {
+
+	/*!
+	 \brief The builders for `BasicParser` that keep what they are given as
+	        compact records in the libsoldout buffers.
+
+	 Records are written in place of the output libsoldout would render:
+
+	     text   \0 'T' text
+	     span   \0 'S' type text attributes
+	     block  \0 'B' type attributes length content
+
+	 Every number is a native uint32_t, every string is preceded by its
+	 length, attributes are encoded as read by `Attributes`, and the content
+	 of a block is the records of its children. Bytes that libsoldout copies
+	 to the output on its own, such as entities, are read as text up to the
+	 next record.
+
+	 Spans are built the way `Parser` builds them: a span takes over the
+	 text and attributes of the first span inside it, and the others follow
+	 it as siblings. Subclasses decide what becomes of each top-level block.
+	 */
+	class RecordBuilder {
+	public:
+		RecordBuilder();
+
+		void parsedBlockCode(struct buf *ob, struct buf *text);
+		void parsedBlock(Type type, struct buf *ob, struct buf *text, int extra);
+		void parsedSpan(Type type, struct buf *ob, struct buf *text, struct buf *link, struct buf *title);
+		void parsedCodeSpan(struct buf *ob, struct buf *text);
+		void parsedLinebreak(struct buf *ob);
+		void parsedNormalText(struct buf *ob, struct buf *text);
+	protected:
+		/*!
+		 \brief A record read back from a buffer.
+		 */
+		struct Record {
+			char tag;
+			Type type;
+			TextView text;
+			const char* attributes;
+			const char* content;
+			const char* contentEnd;
+		};
+
+		/*!
+		 \brief Reads the record at `at`, returning where the next one starts.
+		 */
+		static const char* readRecord(const char* at, const char* end, Record& record);
+	private:
+		struct buf *textBuffer;
+		size_t textStart;
+		size_t textEnd;
+		void putText(struct buf *ob, const char* data, size_t length);
+	};
+
+	/*!
+	 \brief Reports each top-level block to a `Handler` as it is parsed.
+	 */
+	class EventBuilder : public RecordBuilder {
+	public:
+		/*!
+		 \brief Creates an `EventBuilder`.
+		 \param handler The handler that receives the events. It must outlive
+		                the builder.
+		 */
+		EventBuilder(Handler& handler);
+
+		void parsedTopLevel(struct buf *ob, size_t offset);
+	private:
+		Handler& handler;
+		void replay(const char* at, const char* end);
+	};
+
+	/*!
+	 \brief Builds a `Document`, the way `Parser::parse` does.
+	 */
+	class TreeBuilder : public RecordBuilder {
+	public:
+		TreeBuilder();
+
+		void parsedTopLevel(struct buf *ob, size_t offset);
+
+		/*!
+		 \brief Gets the `Document` built so far.
+		 */
+		Document& getDocument();
+	private:
+		Document document;
+		void build(const Record& record, Element& element);
+	};
+
+	/*!
+	 \brief A node of the flat array built by `FlatBuilder`.
+
+	 Nodes are stored in document order, each followed by its descendants,
+	 so the first child of node `i` is `i + 1` when `i + 1 < end`, and the
+	 next sibling of a node is at its `end`.
+	 */
+	struct FlatNode {
+		static const size_t NO_PARENT = (size_t) -1;
+
+		Type type;
+		size_t parent;
+		size_t end;
+		size_t textOffset;
+		size_t textLength;
+		size_t firstAttribute;
+		size_t attributeCount;
+	};
+
+	/*!
+	 \brief An attribute of a `FlatNode`, as ranges of the string pool.
+	 */
+	struct FlatAttribute {
+		size_t nameOffset;
+		size_t nameLength;
+		size_t valueOffset;
+		size_t valueLength;
+	};
+
+	/*!
+	 \brief Builds a flat array of nodes sharing one string pool, rather than
+	        a tree of `Element`s.
+	 */
+	class FlatBuilder : public RecordBuilder {
+	public:
+		FlatBuilder();
+
+		void parsedTopLevel(struct buf *ob, size_t offset);
+
+		const std::vector<FlatNode>& getNodes() const;
+		const std::vector<FlatAttribute>& getAttributes() const;
+
+		/*!
+		 \brief Gets the pool that node text and attributes point into.
+		 */
+		const std::string& getStrings() const;
+	private:
+		std::vector<FlatNode> nodes;
+		std::vector<FlatAttribute> attributes;
+		std::string strings;
+		void flatten(const Record& record, size_t parent);
+	};
+
+	/*!
+	 \brief Builds nothing, which measures libsoldout on its own.
+	 */
+	class NullBuilder {
+	public:
+		void parsedBlockCode(struct buf *ob, struct buf *text) {}
+		void parsedBlock(Type type, struct buf *ob, struct buf *text, int extra) {}
+		void parsedSpan(Type type, struct buf *ob, struct buf *text, struct buf *link, struct buf *title) {}
+		void parsedCodeSpan(struct buf *ob, struct buf *text) {}
+		void parsedLinebreak(struct buf *ob) {}
+		void parsedNormalText(struct buf *ob, struct buf *text) {}
+		void parsedTopLevel(struct buf *ob, size_t offset) {}
+	};
+
+}
+
+#endif // BYPASS_BUILDERS_H
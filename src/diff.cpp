@@ -0,0 +1,254 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include "diff.h"
+
+namespace Bypass {
+
+	const static size_t NO_INDEX = (size_t) -1;
+
+	std::vector<DiffOperation> diff(const Document& old, const Document& neu) {
+		std::vector<DiffOperation> operations;
+		Differ(operations).diffDocuments(old, neu);
+		return operations;
+	}
+
+	Differ::Differ(std::vector<DiffOperation>& operations)
+	: operations(operations)
+	, oldPath()
+	, newPath()
+	{
+
+	}
+
+	void Differ::diffDocuments(const Document& old, const Document& neu) {
+		std::vector<const Element*> oldChildren, newChildren;
+
+		for (size_t i = 0; i < old.blocks.size(); i++) {
+			oldChildren.push_back(old.blocks[i].element.get());
+		}
+
+		for (size_t i = 0; i < neu.blocks.size(); i++) {
+			newChildren.push_back(neu.blocks[i].element.get());
+		}
+
+		diffChildren(oldChildren, newChildren);
+	}
+
+	void Differ::diffChildren(const std::vector<const Element*>& oldChildren, const std::vector<const Element*>& newChildren) {
+		size_t oldSize = oldChildren.size();
+		size_t newSize = newChildren.size();
+		size_t prefix = 0, suffix = 0;
+
+		// Unchanged runs at either end are skipped without looking any deeper
+		// than the hashes.
+
+		while (prefix < oldSize && prefix < newSize
+			&& oldChildren[prefix]->hash == newChildren[prefix]->hash) {
+			prefix++;
+		}
+
+		while (suffix < oldSize - prefix && suffix < newSize - prefix
+			&& oldChildren[oldSize - 1 - suffix]->hash == newChildren[newSize - 1 - suffix]->hash) {
+			suffix++;
+		}
+
+		size_t oldEnd = oldSize - suffix;
+		size_t newEnd = newSize - suffix;
+
+		if (prefix == oldEnd && prefix == newEnd) {
+			return;
+		}
+
+		// Pair up equal subtrees in the middle, first come first served.
+
+		std::map<uint64_t, std::deque<size_t> > unmatched;
+		std::vector<size_t> oldMatch(oldSize, NO_INDEX);
+		std::vector<size_t> newMatch(newSize, NO_INDEX);
+
+		for (size_t i = prefix; i < oldEnd; i++) {
+			unmatched[oldChildren[i]->hash].push_back(i);
+		}
+
+		for (size_t j = prefix; j < newEnd; j++) {
+			std::map<uint64_t, std::deque<size_t> >::iterator it = unmatched.find(newChildren[j]->hash);
+
+			if (it != unmatched.end() && !it->second.empty()) {
+				newMatch[j] = it->second.front();
+				oldMatch[it->second.front()] = j;
+				it->second.pop_front();
+			}
+		}
+
+		// The longest run of pairs that kept their relative order stays put;
+		// every other pair is a move.
+
+		std::vector<size_t> pairs;
+
+		for (size_t j = prefix; j < newEnd; j++) {
+			if (newMatch[j] != NO_INDEX) {
+				pairs.push_back(j);
+			}
+		}
+
+		std::vector<size_t> tails;
+		std::vector<size_t> previous(pairs.size(), NO_INDEX);
+
+		for (size_t k = 0; k < pairs.size(); k++) {
+			size_t pos = 0, count = tails.size();
+
+			while (count > 0) {
+				size_t half = count / 2;
+
+				if (newMatch[pairs[tails[pos + half]]] < newMatch[pairs[k]]) {
+					pos += half + 1;
+					count -= half + 1;
+				} else {
+					count = half;
+				}
+			}
+
+			previous[k] = pos > 0 ? tails[pos - 1] : NO_INDEX;
+
+			if (pos == tails.size()) {
+				tails.push_back(k);
+			} else {
+				tails[pos] = k;
+			}
+		}
+
+		std::vector<bool> anchored(newSize, false);
+
+		for (size_t k = tails.empty() ? NO_INDEX : tails.back(); k != NO_INDEX; k = previous[k]) {
+			anchored[pairs[k]] = true;
+		}
+
+		// Between two anchors, what is left on either side is paired up in
+		// order and diffed in place when compatible.
+
+		size_t oldIndex = prefix;
+		size_t newIndex = prefix;
+
+		while (oldIndex < oldEnd || newIndex < newEnd) {
+			std::vector<size_t> oldGap, newGap;
+
+			for (; oldIndex < oldEnd; oldIndex++) {
+				if (oldMatch[oldIndex] == NO_INDEX) {
+					oldGap.push_back(oldIndex);
+				} else if (anchored[oldMatch[oldIndex]]) {
+					break;
+				}
+			}
+
+			for (; newIndex < newEnd && !anchored[newIndex]; newIndex++) {
+				if (newMatch[newIndex] == NO_INDEX) {
+					newGap.push_back(newIndex);
+				}
+			}
+
+			size_t paired = std::min(oldGap.size(), newGap.size());
+
+			for (size_t k = 0; k < paired; k++) {
+				const Element& oldChild = *oldChildren[oldGap[k]];
+				const Element& newChild = *newChildren[newGap[k]];
+
+				if (isUpdatable(oldChild, newChild)) {
+					oldPath.push_back(oldGap[k]);
+					newPath.push_back(newGap[k]);
+					diffElements(oldChild, newChild);
+					oldPath.pop_back();
+					newPath.pop_back();
+				} else {
+					emit(DIFF_REMOVE, oldGap[k], NO_INDEX);
+					emit(DIFF_INSERT, NO_INDEX, newGap[k]);
+				}
+			}
+
+			for (size_t k = paired; k < oldGap.size(); k++) {
+				emit(DIFF_REMOVE, oldGap[k], NO_INDEX);
+			}
+
+			for (size_t k = paired; k < newGap.size(); k++) {
+				emit(DIFF_INSERT, NO_INDEX, newGap[k]);
+			}
+
+			// Step over the anchor that ended this gap.
+
+			oldIndex++;
+			newIndex++;
+		}
+
+		for (size_t k = 0; k < pairs.size(); k++) {
+			if (!anchored[pairs[k]]) {
+				emit(DIFF_MOVE, newMatch[pairs[k]], pairs[k]);
+			}
+		}
+	}
+
+	void Differ::diffElements(const Element& old, const Element& neu) {
+		if (old.hash == neu.hash) {
+			return;
+		}
+
+		if (old.text != neu.text) {
+			emit(DIFF_UPDATE_TEXT, NO_INDEX, NO_INDEX);
+		}
+
+		std::vector<const Element*> oldChildren, newChildren;
+		collectChildren(oldChildren, old);
+		collectChildren(newChildren, neu);
+		diffChildren(oldChildren, newChildren);
+	}
+
+	void Differ::emit(DiffType type, size_t oldIndex, size_t newIndex) {
+		DiffOperation operation;
+		operation.type = type;
+
+		if (type != DIFF_INSERT) {
+			operation.oldPath = oldPath;
+
+			if (oldIndex != NO_INDEX) {
+				operation.oldPath.push_back(oldIndex);
+			}
+		}
+
+		if (type != DIFF_REMOVE) {
+			operation.newPath = newPath;
+
+			if (newIndex != NO_INDEX) {
+				operation.newPath.push_back(newIndex);
+			}
+		}
+
+		operations.push_back(operation);
+	}
+
+	bool Differ::isUpdatable(const Element& old, const Element& neu) {
+		return old.type == neu.type && old.attributes == neu.attributes;
+	}
+
+	void Differ::collectChildren(std::vector<const Element*>& out, const Element& element) {
+		const std::vector<Element>& children = element.getChildren();
+
+		for (size_t i = 0; i < children.size(); i++) {
+			out.push_back(&children[i]);
+		}
+	}
+
+}
@@ -0,0 +1,89 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_DIFF_H
+#define BYPASS_DIFF_H
+
+#include <vector>
+#include "document.h"
+#include "element.h"
+
+namespace Bypass {
+
+	enum DiffType {
+		DIFF_INSERT,
+		DIFF_REMOVE,
+		DIFF_MOVE,
+		DIFF_UPDATE_TEXT
+	};
+
+	/*!
+	 \brief One change needed to turn an old `Document` into a new one.
+
+	 Paths are the child indices leading from the document to an element, so
+	 `{2, 0}` is the first child of the third top-level element. `oldPath` is a
+	 path in the old document and `newPath` one in the new document.
+
+	 - `DIFF_INSERT` adds the element at `newPath`; `oldPath` is empty.
+	 - `DIFF_REMOVE` drops the element at `oldPath`; `newPath` is empty.
+	 - `DIFF_MOVE` moves the unchanged element at `oldPath` to `newPath`.
+	 - `DIFF_UPDATE_TEXT` replaces the text of the element at `oldPath` with
+	   the text of the element at `newPath`. Its children are diffed on their
+	   own.
+	 */
+	struct DiffOperation {
+		DiffType type;
+		std::vector<size_t> oldPath;
+		std::vector<size_t> newPath;
+	};
+
+	/*!
+	 \brief Computes the operations that turn one `Document` into another.
+
+	 Subtrees are compared by their content hashes, so unchanged subtrees are
+	 matched without being walked and the work done is proportional to what
+	 changed. Elements are only diffed further when their type and attributes
+	 match; otherwise the old one is removed and the new one inserted.
+
+	 \param old The document as it was.
+	 \param neu The document as it is now.
+	 \return The operations, or an empty vector if the documents are equal.
+	 */
+	std::vector<DiffOperation> diff(const Document& old, const Document& neu);
+
+	/*!
+	 \brief Does the work for `diff`.
+	 */
+	class Differ {
+	public:
+		Differ(std::vector<DiffOperation>& operations);
+
+		void diffDocuments(const Document& old, const Document& neu);
+	private:
+		std::vector<DiffOperation>& operations;
+		std::vector<size_t> oldPath;
+		std::vector<size_t> newPath;
+
+		void diffChildren(const std::vector<const Element*>& oldChildren, const std::vector<const Element*>& newChildren);
+		void diffElements(const Element& old, const Element& neu);
+		void emit(DiffType type, size_t oldIndex, size_t newIndex);
+		static bool isUpdatable(const Element& old, const Element& neu);
+		static void collectChildren(std::vector<const Element*>& out, const Element& element);
+	};
+
+}
+
+#endif // BYPASS_DIFF_H
@@ -18,8 +18,15 @@
 
 namespace Bypass {
 
+	const size_t Document::TYPE_COUNT;
+
 	Document::Document()
-	: elements()
+	: blocks()
+	, status(PARSE_COMPLETE)
+	, nextId(0)
+	, references()
+	, referenceRanges()
+	, types()
 	{
 
 	}
@@ -29,15 +36,98 @@ namespace Bypass {
 	}
 
 	void Document::append(const Element& element) {
-		elements.push_back(Element(element));
+		Element* copy = new Element(element);
+		copy->updateHash();
+		append(std::shared_ptr<const Element>(copy), nextId, 0);
+	}
+
+	void Document::append(const std::shared_ptr<const Element>& element, size_t id, size_t offset) {
+		Block block;
+		block.element = element;
+		block.id = id;
+		block.offset = offset;
+		blocks.push_back(block);
+
+		if (id >= nextId) {
+			nextId = id + 1;
+		}
 	}
 
 	size_t Document::size() {
-		return elements.size();
+		return blocks.size();
 	}
 
 	Element Document::operator[](size_t i) {
-		return elements[i];
+		return *blocks[i].element;
+	}
+
+	void Document::setStatus(ParseStatus status) {
+		this->status = status;
+	}
+
+	ParseStatus Document::getStatus() {
+		return status;
+	}
+
+	size_t Document::getId(size_t i) {
+		return blocks[i].id;
+	}
+
+	size_t Document::getOffset(size_t i) {
+		return blocks[i].offset;
+	}
+
+	const std::vector<const Element*>& Document::getElementsOfType(Type type) {
+		// Top-level elements are only ever appended, so the index is extended
+		// over the new ones, and only copied first when a copy shares it.
+
+		if (!types || types->blockCount > blocks.size()) {
+			types = std::make_shared<TypeIndex>();
+			types->blockCount = 0;
+		} else if (types->blockCount < blocks.size() && types.use_count() > 1) {
+			types = std::make_shared<TypeIndex>(*types);
+		}
+
+		for (; types->blockCount < blocks.size(); types->blockCount++) {
+			indexTypes(*types, *blocks[types->blockCount].element);
+		}
+
+		return types->elements[(type & 0xFF) % TYPE_COUNT];
+	}
+
+	void Document::indexTypes(TypeIndex& index, const Element& element) {
+		index.elements[(element.type & 0xFF) % TYPE_COUNT].push_back(&element);
+
+		const std::vector<Element>& children = element.getChildren();
+
+		for (std::vector<Element>::const_iterator it = children.begin(); it != children.end(); ++it) {
+			indexTypes(index, *it);
+		}
+	}
+
+	size_t Document::getFootprint() const {
+		// A shared element also costs its shared_ptr control block.
+
+		size_t bytes = sizeof(Document) + blocks.capacity() * sizeof(Block)
+			+ referenceRanges.capacity() * sizeof(referenceRanges[0]);
+
+		if (references.capacity() + 1 > sizeof(std::string)) {
+			bytes += references.capacity() + 1;
+		}
+
+		if (types) {
+			bytes += 2 * sizeof(void*) + 2 * sizeof(long) + sizeof(TypeIndex);
+
+			for (size_t i = 0; i < TYPE_COUNT; i++) {
+				bytes += types->elements[i].capacity() * sizeof(const Element*);
+			}
+		}
+
+		for (size_t i = 0; i < blocks.size(); i++) {
+			bytes += 2 * sizeof(void*) + 2 * sizeof(long) + blocks[i].element->getFootprint();
+		}
+
+		return bytes;
 	}
 
 }
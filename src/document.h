@@ -17,14 +17,52 @@
 #ifndef BYPASS_DOCUMENT_H
 #define BYPASS_DOCUMENT_H
 
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 #include "element.h"
 
 namespace Bypass
 {
 
+	/*!
+	 \brief Describes how a parse that produced a `Document` ended.
+
+	 Anything other than `PARSE_COMPLETE` means that the parse was stopped early
+	 by one of the limits in `ParseOptions`, and that the `Document` only holds
+	 what was parsed up to that point. `PARSE_VISIBLE_CHAR_LIMIT_REACHED` and
+	 `PARSE_BLOCK_LIMIT_REACHED` are the expected outcome of a preview parse
+	 rather than a failure. `PARSE_INVALID_UTF8` means that the input was
+	 rejected before parsing, so the `Document` is empty.
+	 */
+	enum ParseStatus {
+		PARSE_COMPLETE,
+		PARSE_CANCELLED,
+		PARSE_DEADLINE_EXCEEDED,
+		PARSE_NODE_LIMIT_EXCEEDED,
+		PARSE_OUTPUT_LIMIT_EXCEEDED,
+		PARSE_VISIBLE_CHAR_LIMIT_REACHED,
+		PARSE_BLOCK_LIMIT_REACHED,
+		PARSE_INVALID_UTF8
+	};
+
+	class Differ;
+	class DocumentView;
+	class DocumentWriter;
+	class Exporter;
+	class JsonWriter;
+	class Parser;
+	class SourceIndex;
+	class TreeBuilder;
+	class ProgressiveParser;
+	class WindowParser;
+
 	/*!
 	 \brief An object that serves as the root of a markdown `Element` tree.
+
+	 Top-level elements are held by reference, so copying a `Document` is cheap
+	 and copies share the elements they have in common.
 	 */
 	class Document
 	{
@@ -39,6 +77,11 @@ namespace Bypass
 		 */
 		~Document();
 
+		Document(const Document&) = default;
+		Document(Document&&) = default;
+		Document& operator=(const Document&) = default;
+		Document& operator=(Document&&) = default;
+
 		/*!
 		 \brief Appends the given element to the tail of this document.
 		 \param element The element to append to the tail.
@@ -57,8 +100,98 @@ namespace Bypass
 	     \return The number of elements.
 		 */
 		size_t size();
+
+		/*!
+		 \brief Sets how the parse that produced this `Document` ended.
+		 \param status The status of the parse.
+		 */
+		void setStatus(ParseStatus status);
+
+		/*!
+		 \brief Indicates how the parse that produced this `Document` ended.
+		 \return `PARSE_COMPLETE` unless the parse was stopped early.
+		 */
+		ParseStatus getStatus();
+
+		/*!
+		 \brief Gets the identifier of a top-level element.
+
+		 Identifiers are unique within a `Document`, and a top-level element
+		 that is untouched by an edit keeps its identifier, and its storage,
+		 across `Parser::reparse`.
+
+		 \param i The index of the element.
+		 \return The identifier of the element at the given index.
+		 */
+		size_t getId(size_t i);
+
+		/*!
+		 \brief Gets where a top-level element starts in the parsed markdown.
+		 \param i The index of the element.
+		 \return The offset in bytes of the element at the given index, or 0
+		         if the element was not produced by a `Parser`.
+		 */
+		size_t getOffset(size_t i);
+
+		/*!
+		 \brief Gets every element of a type, in document order.
+
+		 Elements are indexed by type on the first call, without copying any
+		 of them, and later calls only index the top-level elements appended
+		 since. Copies of a `Document` share the index until one of them
+		 extends it. Indexing parses the inline text of deferred elements.
+
+		 \param type The type of the elements to return.
+		 \return Pointers to the elements, which stay valid for as long as
+		         this `Document` or a copy of it holds them. The vector itself
+		         is only valid until the next call.
+		 */
+		const std::vector<const Element*>& getElementsOfType(Type type);
+
+		/*!
+		 \brief Estimates the memory held by this `Document`.
+
+		 Elements are counted in full even when they are shared with other
+		 documents. See `Element::getFootprint`.
+
+		 \return The footprint in bytes.
+		 */
+		size_t getFootprint() const;
 	private:
-		std::vector<Element> elements;
+		friend class Differ;
+		friend class DocumentView;
+		friend class DocumentWriter;
+		friend class Exporter;
+		friend class JsonWriter;
+		friend class Parser;
+		friend class SourceIndex;
+		friend class TreeBuilder;
+		friend class ProgressiveParser;
+		friend class WindowParser;
+
+		struct Block {
+			std::shared_ptr<const Element> element;
+			size_t id;
+			size_t offset;
+		};
+
+		// Types are indexed by their low byte, which is unique to each type.
+
+		static const size_t TYPE_COUNT = 0x16;
+
+		struct TypeIndex {
+			size_t blockCount;
+			std::vector<const Element*> elements[TYPE_COUNT];
+		};
+
+		std::vector<Block> blocks;
+		ParseStatus status;
+		size_t nextId;
+		std::string references;
+		std::vector<std::pair<size_t, size_t> > referenceRanges;
+		void append(const std::shared_ptr<const Element>& element, size_t id, size_t offset);
+		std::shared_ptr<TypeIndex> types;
+		static void indexTypes(TypeIndex& index, const Element& element);
 	};
 }
 
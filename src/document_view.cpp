@@ -0,0 +1,426 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "document_view.h"
+
+namespace Bypass {
+
+	// Node fields, in the order they are written.
+	enum {
+		NODE_TYPE,
+		NODE_TEXT_OFFSET,
+		NODE_TEXT_LENGTH,
+		NODE_FIRST_CHILD,
+		NODE_CHILD_COUNT,
+		NODE_FIRST_ATTRIBUTE,
+		NODE_ATTRIBUTE_COUNT
+	};
+
+	// The frame of an empty NodeView: a single paragraph with no text.
+	static const unsigned char EMPTY_FRAME[BINARY_FRAME_HEADER_SIZE + BINARY_NODE_SIZE] = {
+		1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		PARAGRAPH
+	};
+
+	static uint32_t readField(const unsigned char* node, int field) {
+		return readBinary32(node + field * 4);
+	}
+
+	// Whether [offset, offset + length) lies within [0, size); the sum is
+	// taken in 64 bits so that it cannot wrap.
+	static bool inRange(uint64_t offset, uint64_t length, uint64_t size) {
+		return offset + length <= size;
+	}
+
+	// NodeView
+
+	NodeView::NodeView()
+	: view(NULL)
+	, frame(EMPTY_FRAME)
+	, index(0)
+	{
+
+	}
+
+	NodeView::NodeView(const DocumentView* view, const unsigned char* frame, uint32_t index)
+	: view(view)
+	, frame(frame)
+	, index(index)
+	{
+
+	}
+
+	const unsigned char* NodeView::getNode() const {
+		return frame + BINARY_FRAME_HEADER_SIZE + index * BINARY_NODE_SIZE;
+	}
+
+	const unsigned char* NodeView::getStrings() const {
+		return frame + BINARY_FRAME_HEADER_SIZE
+			+ readBinary32(frame) * BINARY_NODE_SIZE
+			+ readBinary32(frame + 4) * BINARY_ATTRIBUTE_SIZE;
+	}
+
+	Type NodeView::getType() const {
+		return (Type) readField(getNode(), NODE_TYPE);
+	}
+
+	const char* NodeView::getTextData() const {
+		if (getTextLength() == 0) {
+			return (const char*) getStrings();
+		}
+
+		return (const char*) getStrings() + readField(getNode(), NODE_TEXT_OFFSET);
+	}
+
+	size_t NodeView::getTextLength() const {
+		const unsigned char* node = getNode();
+
+		if (!inRange(readField(node, NODE_TEXT_OFFSET), readField(node, NODE_TEXT_LENGTH), readBinary32(frame + 8))) {
+			return 0;
+		}
+
+		return readField(node, NODE_TEXT_LENGTH);
+	}
+
+	std::string NodeView::getText() const {
+		return std::string(getTextData(), getTextLength());
+	}
+
+	std::string NodeView::getAttribute(const std::string& name) const {
+		for (size_t i = 0; i < attrSize(); i++) {
+			if (getAttributeName(i) == name) {
+				return getAttributeValue(i);
+			}
+		}
+
+		return std::string();
+	}
+
+	std::string NodeView::getAttributeName(size_t i) const {
+		const unsigned char* attribute = frame + BINARY_FRAME_HEADER_SIZE
+			+ readBinary32(frame) * BINARY_NODE_SIZE
+			+ (readField(getNode(), NODE_FIRST_ATTRIBUTE) + i) * BINARY_ATTRIBUTE_SIZE;
+		size_t keyLength;
+		const char* key = view->getKey(readBinary32(attribute), &keyLength);
+		return std::string(key, keyLength);
+	}
+
+	std::string NodeView::getAttributeValue(size_t i) const {
+		const unsigned char* attribute = frame + BINARY_FRAME_HEADER_SIZE
+			+ readBinary32(frame) * BINARY_NODE_SIZE
+			+ (readField(getNode(), NODE_FIRST_ATTRIBUTE) + i) * BINARY_ATTRIBUTE_SIZE;
+		uint32_t offset = readBinary32(attribute + 4);
+		uint32_t length = readBinary32(attribute + 8);
+
+		if (!inRange(offset, length, readBinary32(frame + 8))) {
+			return std::string();
+		}
+
+		return std::string((const char*) getStrings() + offset, length);
+	}
+
+	size_t NodeView::attrSize() const {
+		const unsigned char* node = getNode();
+
+		if (!inRange(readField(node, NODE_FIRST_ATTRIBUTE), readField(node, NODE_ATTRIBUTE_COUNT), readBinary32(frame + 4))) {
+			return 0;
+		}
+
+		return readField(node, NODE_ATTRIBUTE_COUNT);
+	}
+
+	NodeView NodeView::operator[](size_t i) const {
+		return NodeView(view, frame, readField(getNode(), NODE_FIRST_CHILD) + i);
+	}
+
+	size_t NodeView::size() const {
+		const unsigned char* node = getNode();
+		uint32_t firstChild = readField(node, NODE_FIRST_CHILD);
+
+		// Children always come after their parent, which also rules out
+		// cycles in a corrupt file.
+
+		if (firstChild <= index || !inRange(firstChild, readField(node, NODE_CHILD_COUNT), readBinary32(frame))) {
+			return 0;
+		}
+
+		return readField(node, NODE_CHILD_COUNT);
+	}
+
+	Element NodeView::toElement() const {
+		Element element;
+		element.setType(getType());
+		element.setText(getText());
+
+		for (size_t i = 0; i < attrSize(); i++) {
+			element.addAttribute(getAttributeName(i), getAttributeValue(i));
+		}
+
+		for (size_t i = 0; i < size(); i++) {
+			element.append((*this)[i].toElement());
+		}
+
+		return element;
+	}
+
+	// DocumentView
+
+	DocumentView::DocumentView()
+	: data(NULL)
+	, length(0)
+	, blockCount(0)
+	, blockIndex(NULL)
+	, keyCount(0)
+	, keyTable(NULL)
+	, keyBytes(NULL)
+	, status(PARSE_COMPLETE)
+	, valid(false)
+	{
+
+	}
+
+	DocumentView::DocumentView(const void* data, size_t length)
+	: data(static_cast<const unsigned char*>(data))
+	, length(length)
+	, blockCount(0)
+	, blockIndex(NULL)
+	, keyCount(0)
+	, keyTable(NULL)
+	, keyBytes(NULL)
+	, status(PARSE_COMPLETE)
+	, valid(false)
+	{
+		if (length < BINARY_HEADER_SIZE + BINARY_TRAILER_SIZE) {
+			return;
+		}
+
+		const unsigned char* trailer = this->data + length - BINARY_TRAILER_SIZE;
+
+		if (memcmp(this->data, "BYPD", 4) != 0 || readBinary32(this->data + 4) != BINARY_VERSION
+			|| memcmp(trailer + 20, "BYPE", 4) != 0 || readBinary32(trailer + 16) != BINARY_VERSION) {
+			return;
+		}
+
+		uint32_t count = readBinary32(trailer);
+		uint32_t indexOffset = readBinary32(trailer + 4);
+		uint32_t keysOffset = readBinary32(trailer + 8);
+		size_t end = length - BINARY_TRAILER_SIZE;
+
+		if (keysOffset < BINARY_HEADER_SIZE || !inRange(keysOffset, 4, indexOffset)
+			|| !inRange(indexOffset, (uint64_t) count * BINARY_INDEX_ENTRY_SIZE, end)) {
+			return;
+		}
+
+		uint32_t keys = readBinary32(this->data + keysOffset);
+		uint64_t keyBytesOffset = keysOffset + 4 + (uint64_t) keys * 8;
+
+		if (keyBytesOffset > indexOffset) {
+			return;
+		}
+
+		keyCount = keys;
+		keyTable = this->data + keysOffset + 4;
+		keyBytes = this->data + keyBytesOffset;
+
+		for (size_t i = 0; i < keyCount; i++) {
+			if (!inRange(readBinary32(keyTable + i * 8), readBinary32(keyTable + i * 8 + 4), indexOffset - keyBytesOffset)) {
+				return;
+			}
+		}
+
+		blockCount = count;
+		blockIndex = this->data + indexOffset;
+		status = (ParseStatus) readBinary32(trailer + 12);
+		valid = true;
+	}
+
+	bool DocumentView::isValid() const {
+		return valid;
+	}
+
+	NodeView DocumentView::operator[](size_t i) const {
+		const unsigned char* entry = blockIndex + i * BINARY_INDEX_ENTRY_SIZE;
+		uint32_t offset = readBinary32(entry);
+		size_t available = blockIndex - data;
+
+		if (offset < BINARY_HEADER_SIZE || offset > available || !checkFrame(data + offset, available - offset)) {
+			return NodeView();
+		}
+
+		return NodeView(this, data + offset, 0);
+	}
+
+	size_t DocumentView::size() const {
+		return blockCount;
+	}
+
+	size_t DocumentView::getId(size_t i) const {
+		return readBinary32(blockIndex + i * BINARY_INDEX_ENTRY_SIZE + 4);
+	}
+
+	size_t DocumentView::getOffset(size_t i) const {
+		return readBinary32(blockIndex + i * BINARY_INDEX_ENTRY_SIZE + 8);
+	}
+
+	ParseStatus DocumentView::getStatus() const {
+		return status;
+	}
+
+	Document DocumentView::toDocument() const {
+		Document document;
+		document.blocks.reserve(blockCount);
+
+		for (size_t i = 0; i < blockCount; i++) {
+			Element* element = new Element((*this)[i].toElement());
+			element->updateHash();
+			document.append(std::shared_ptr<const Element>(element), getId(i), getOffset(i));
+		}
+
+		document.setStatus(status);
+		return document;
+	}
+
+	bool DocumentView::checkFrame(const unsigned char* frame, size_t available) const {
+		// The frame header, the node types and the shape of the tree are
+		// checked here: a type outside the enum cannot be handed out, and
+		// `toElement` recurses once per level. The nodes check their own
+		// string ranges as they are read.
+
+		if (available < BINARY_FRAME_HEADER_SIZE) {
+			return false;
+		}
+
+		uint32_t nodeCount = readBinary32(frame);
+		uint64_t size = BINARY_FRAME_HEADER_SIZE
+			+ (uint64_t) nodeCount * BINARY_NODE_SIZE
+			+ (uint64_t) readBinary32(frame + 4) * BINARY_ATTRIBUTE_SIZE
+			+ readBinary32(frame + 8);
+
+		if (nodeCount == 0 || size > available) {
+			return false;
+		}
+
+		// As written, the children of each node directly follow the children
+		// of the node before it, so every node but the first has exactly one
+		// parent, and the nodes of a level end where the children of the
+		// level before it end.
+
+		uint64_t expected = 1;
+		uint32_t levelEnd = 1;
+		uint32_t depth = 0;
+
+		for (uint32_t i = 0; i < nodeCount; i++) {
+			const unsigned char* node = frame + BINARY_FRAME_HEADER_SIZE + i * BINARY_NODE_SIZE;
+			uint32_t type = readField(node, NODE_TYPE);
+			uint32_t childCount = readField(node, NODE_CHILD_COUNT);
+
+			if (type > TABLE_ROW && (type < AUTOLINK || type > STRIKETHROUGH)) {
+				return false;
+			}
+
+			if (i == levelEnd) {
+				levelEnd = (uint32_t) expected;
+
+				if (++depth >= BINARY_MAX_DEPTH) {
+					return false;
+				}
+			}
+
+			if (childCount > 0) {
+				if (readField(node, NODE_FIRST_CHILD) != expected) {
+					return false;
+				}
+
+				expected += childCount;
+
+				if (expected > nodeCount) {
+					return false;
+				}
+			}
+		}
+
+		return expected == nodeCount;
+	}
+
+	const char* DocumentView::getKey(uint32_t key, size_t* keyLength) const {
+		if (key >= keyCount) {
+			*keyLength = 0;
+			return "";
+		}
+
+		*keyLength = readBinary32(keyTable + key * 8 + 4);
+		return (const char*) keyBytes + readBinary32(keyTable + key * 8);
+	}
+
+	// MappedDocument
+
+	MappedDocument::MappedDocument()
+	: address(NULL)
+	, length(0)
+	, view()
+	{
+
+	}
+
+	MappedDocument::~MappedDocument() {
+		close();
+	}
+
+	bool MappedDocument::open(const std::string& path) {
+		close();
+
+		int fd = ::open(path.c_str(), O_RDONLY);
+
+		if (fd < 0) {
+			return false;
+		}
+
+		struct stat info;
+
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (mapped != MAP_FAILED) {
+				address = mapped;
+				length = info.st_size;
+				view = DocumentView(address, length);
+			}
+		}
+
+		::close(fd);
+		return view.isValid();
+	}
+
+	void MappedDocument::close() {
+		if (address) {
+			munmap(address, length);
+		}
+
+		address = NULL;
+		length = 0;
+		view = DocumentView();
+	}
+
+	const DocumentView& MappedDocument::getView() const {
+		return view;
+	}
+
+}
@@ -0,0 +1,239 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_DOCUMENT_VIEW_H
+#define BYPASS_DOCUMENT_VIEW_H
+
+#include <string>
+#include "binary_format.h"
+#include "document.h"
+#include "element.h"
+
+namespace Bypass {
+
+	class DocumentView;
+
+	/*!
+	 \brief A read-only `Element` inside the binary form of a `Document`.
+
+	 A `NodeView` is a pair of pointers into the buffer of its `DocumentView`;
+	 it is cheap to copy and must not outlive the buffer. Text is read in
+	 place, without copying.
+	 */
+	class NodeView {
+	public:
+
+		/*!
+		 \brief Creates an empty `NodeView`, with no text and no children.
+		 */
+		NodeView();
+
+		/*!
+		 \brief Gets the type of this node.
+		 */
+		Type getType() const;
+
+		/*!
+		 \brief Gets the text of this node, in place.
+		 \return A pointer into the buffer; the text is not null-terminated.
+		 */
+		const char* getTextData() const;
+
+		/*!
+		 \brief Gets the length in bytes of the text of this node.
+		 */
+		size_t getTextLength() const;
+
+		/*!
+		 \brief Gets a copy of the text of this node.
+		 */
+		std::string getText() const;
+
+		/*!
+		 \brief Gets an attribute by name.
+		 \param name The name of the attribute to return.
+		 \return The value of the named attribute, or an empty string.
+		 */
+		std::string getAttribute(const std::string& name) const;
+
+		/*!
+		 \brief Gets the name of the i-th attribute, in name order.
+		 */
+		std::string getAttributeName(size_t i) const;
+
+		/*!
+		 \brief Gets the value of the i-th attribute, in name order.
+		 */
+		std::string getAttributeValue(size_t i) const;
+
+		/*!
+		 \brief Gets the number of attributes.
+		 */
+		size_t attrSize() const;
+
+		/*!
+		 \brief Gets a child of this node.
+		 \param i The index of the child to retrieve.
+		 \return The child.
+		 */
+		NodeView operator[](size_t i) const;
+
+		/*!
+		 \brief The number of children this node has.
+		 */
+		size_t size() const;
+
+		/*!
+		 \brief Copies the subtree rooted at this node into an `Element`.
+		 */
+		Element toElement() const;
+	private:
+		friend class DocumentView;
+
+		const DocumentView* view;
+		const unsigned char* frame;
+		uint32_t index;
+		NodeView(const DocumentView* view, const unsigned char* frame, uint32_t index);
+		const unsigned char* getNode() const;
+		const unsigned char* getStrings() const;
+	};
+
+	/*!
+	 \brief A `Document` read in place from its binary form, as written by
+	        `DocumentWriter`.
+
+	 Nothing is decoded up front: opening a view checks the header, trailer
+	 and key table, and a top-level block is checked when it is first
+	 requested, touching only the pages that hold it. This makes it suitable
+	 for a buffer mapped straight from a file; see `MappedDocument`.
+
+	 The buffer must outlive the view and every `NodeView` taken from it.
+	 */
+	class DocumentView {
+	public:
+
+		/*!
+		 \brief Creates an empty `DocumentView`.
+		 */
+		DocumentView();
+
+		/*!
+		 \brief Creates a `DocumentView` over a buffer.
+		 \param data The binary form of a `Document`.
+		 \param length The length of the buffer in bytes.
+		 */
+		DocumentView(const void* data, size_t length);
+
+		/*!
+		 \brief Indicates whether the buffer holds a document in a format and
+		        version this view can read.
+		 */
+		bool isValid() const;
+
+		/*!
+		 \brief Gets a top-level element.
+		 \param i The index of the element to retrieve.
+		 \return The element, or an empty `NodeView` if its part of the buffer
+		         is corrupt.
+		 */
+		NodeView operator[](size_t i) const;
+
+		/*!
+		 \brief Indicates the number of top-level elements.
+		 */
+		size_t size() const;
+
+		/*!
+		 \brief Gets the identifier of a top-level element. See
+		        `Document::getId`.
+		 */
+		size_t getId(size_t i) const;
+
+		/*!
+		 \brief Gets where a top-level element starts in the parsed markdown.
+		        See `Document::getOffset`.
+		 */
+		size_t getOffset(size_t i) const;
+
+		/*!
+		 \brief Indicates how the parse that produced the document ended.
+		 */
+		ParseStatus getStatus() const;
+
+		/*!
+		 \brief Copies the whole view into a `Document`.
+		 */
+		Document toDocument() const;
+	private:
+		friend class NodeView;
+
+		const unsigned char* data;
+		size_t length;
+		size_t blockCount;
+		const unsigned char* blockIndex;
+		size_t keyCount;
+		const unsigned char* keyTable;
+		const unsigned char* keyBytes;
+		ParseStatus status;
+		bool valid;
+		bool checkFrame(const unsigned char* frame, size_t available) const;
+		const char* getKey(uint32_t key, size_t* keyLength) const;
+	};
+
+	/*!
+	 \brief The binary form of a `Document` mapped read-only from a file.
+	 */
+	class MappedDocument {
+	public:
+
+		/*!
+		 \brief Creates a `MappedDocument` with nothing mapped.
+		 */
+		MappedDocument();
+
+		/*!
+		 \brief Unmaps the file.
+		 */
+		~MappedDocument();
+
+		MappedDocument(const MappedDocument&) = delete;
+		MappedDocument& operator=(const MappedDocument&) = delete;
+
+		/*!
+		 \brief Maps the given file, unmapping any previous one.
+		 \param path The path of a file written by `DocumentWriter`.
+		 \return Whether or not the file was mapped and holds a valid document.
+		 */
+		bool open(const std::string& path);
+
+		/*!
+		 \brief Unmaps the file. Views taken from it become invalid.
+		 */
+		void close();
+
+		/*!
+		 \brief Gets the view of the mapped document.
+		 */
+		const DocumentView& getView() const;
+	private:
+		void* address;
+		size_t length;
+		DocumentView view;
+	};
+
+}
+
+#endif // BYPASS_DOCUMENT_VIEW_H
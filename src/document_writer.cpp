@@ -0,0 +1,192 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "document_writer.h"
+
+namespace Bypass {
+
+	static void append32(std::vector<unsigned char>& data, uint32_t value) {
+		size_t at = data.size();
+		data.resize(at + 4);
+		writeBinary32(&data[at], value);
+	}
+
+	DocumentWriter::DocumentWriter(std::ostream& out)
+	: out(out)
+	, keyIndex()
+	, keys()
+	, blockIndex()
+	, frame()
+	{
+		size = 0;
+		written = 0;
+
+		unsigned char header[BINARY_HEADER_SIZE] = { 'B', 'Y', 'P', 'D' };
+		writeBinary32(header + 4, BINARY_VERSION);
+		emit(header, sizeof(header));
+	}
+
+	DocumentWriter::~DocumentWriter() {
+
+	}
+
+	void DocumentWriter::write(const Document& document) {
+		for (; written < document.blocks.size(); written++) {
+			const Document::Block& block = document.blocks[written];
+			writeBlock(*block.element, block.id, block.offset);
+		}
+	}
+
+	void DocumentWriter::finish(const Document& document) {
+		write(document);
+
+		// Key table
+
+		uint32_t keysOffset = size;
+		std::vector<unsigned char> table;
+		uint32_t keyBytes = 0;
+		append32(table, keys.size());
+
+		for (size_t i = 0; i < keys.size(); i++) {
+			append32(table, keyBytes);
+			append32(table, keys[i]->size());
+			keyBytes += keys[i]->size();
+		}
+
+		emit(&table[0], table.size());
+
+		for (size_t i = 0; i < keys.size(); i++) {
+			emit(keys[i]->data(), keys[i]->size());
+		}
+
+		pad();
+
+		// Block index and trailer
+
+		uint32_t indexOffset = size;
+
+		if (!blockIndex.empty()) {
+			emit(&blockIndex[0], blockIndex.size());
+		}
+
+		unsigned char trailer[BINARY_TRAILER_SIZE];
+		writeBinary32(trailer, written);
+		writeBinary32(trailer + 4, indexOffset);
+		writeBinary32(trailer + 8, keysOffset);
+		writeBinary32(trailer + 12, document.status);
+		writeBinary32(trailer + 16, BINARY_VERSION);
+		trailer[20] = 'B';
+		trailer[21] = 'Y';
+		trailer[22] = 'P';
+		trailer[23] = 'E';
+		emit(trailer, sizeof(trailer));
+	}
+
+	size_t DocumentWriter::getSize() const {
+		return size;
+	}
+
+	void DocumentWriter::write(std::ostream& out, const Document& document) {
+		DocumentWriter writer(out);
+		writer.finish(document);
+	}
+
+	void DocumentWriter::writeBlock(const Element& element, size_t id, size_t offset) {
+		append32(blockIndex, size);
+		append32(blockIndex, id);
+		append32(blockIndex, offset);
+
+		frame.nodes.clear();
+		frame.attributes.clear();
+		frame.strings.clear();
+
+		// Breadth first, so that the children of a node end up next to each
+		// other and can be addressed by a single range.
+
+		std::vector<const Element*> queue(1, &element);
+		uint32_t next = 1;
+
+		for (size_t i = 0; i < queue.size(); i++) {
+			const std::vector<Element>& children = queue[i]->getChildren();
+			writeNode(*queue[i], next);
+
+			for (size_t j = 0; j < children.size(); j++) {
+				queue.push_back(&children[j]);
+			}
+
+			next += children.size();
+		}
+
+		unsigned char header[BINARY_FRAME_HEADER_SIZE] = { 0 };
+		writeBinary32(header, queue.size());
+		writeBinary32(header + 4, frame.attributes.size() / BINARY_ATTRIBUTE_SIZE);
+		writeBinary32(header + 8, frame.strings.size());
+		emit(header, sizeof(header));
+		emit(&frame.nodes[0], frame.nodes.size());
+
+		if (!frame.attributes.empty()) {
+			emit(&frame.attributes[0], frame.attributes.size());
+		}
+
+		emit(frame.strings.data(), frame.strings.size());
+		pad();
+	}
+
+	void DocumentWriter::writeNode(const Element& element, uint32_t firstChild) {
+		append32(frame.nodes, element.type);
+		append32(frame.nodes, frame.strings.size());
+		append32(frame.nodes, element.text.size());
+		append32(frame.nodes, firstChild);
+		append32(frame.nodes, element.getChildren().size());
+		append32(frame.nodes, frame.attributes.size() / BINARY_ATTRIBUTE_SIZE);
+		append32(frame.nodes, element.attributes.size());
+		frame.strings.append(element.text);
+
+		Element::AttributeMap::const_iterator it;
+
+		for (it = element.attributes.begin(); it != element.attributes.end(); ++it) {
+			append32(frame.attributes, getKey(it->first));
+			append32(frame.attributes, frame.strings.size());
+			append32(frame.attributes, it->second.size());
+			frame.strings.append(it->second);
+		}
+	}
+
+	uint32_t DocumentWriter::getKey(const std::string& key) {
+		std::map<std::string, uint32_t>::iterator it = keyIndex.find(key);
+
+		if (it == keyIndex.end()) {
+			it = keyIndex.insert(std::make_pair(key, (uint32_t) keys.size())).first;
+			keys.push_back(&it->first);
+		}
+
+		return it->second;
+	}
+
+	void DocumentWriter::emit(const void* data, size_t length) {
+		out.write(static_cast<const char*>(data), length);
+		size += length;
+	}
+
+	void DocumentWriter::pad() {
+		static const char zeros[4] = { 0 };
+
+		if (size % 4 != 0) {
+			emit(zeros, 4 - size % 4);
+		}
+	}
+
+}
@@ -0,0 +1,109 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_DOCUMENT_WRITER_H
+#define BYPASS_DOCUMENT_WRITER_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "binary_format.h"
+#include "document.h"
+#include "element.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief Writes a `Document` in the compact binary form described in
+	        binary_format.h, which `DocumentView` reads without copying.
+
+	 Each top-level block is written as soon as it is handed over, so a
+	 writer can follow a resumable parse: call `write` with
+	 `Parser::getDocument` after every `Parser::step`, then `finish` once the
+	 parse is over. Only the attribute keys and the block index are held
+	 until `finish`.
+
+	 The binary form addresses everything with 32-bit offsets, so a single
+	 file is limited to 4 GB.
+	 */
+	class DocumentWriter {
+	public:
+
+		/*!
+		 \brief Creates a `DocumentWriter` and writes the file header.
+		 \param out The stream to write to. It must outlive the writer.
+		 */
+		DocumentWriter(std::ostream& out);
+
+		/*!
+		 \brief Destroys the `DocumentWriter` without finishing the file.
+		 */
+		~DocumentWriter();
+
+		/*!
+		 \brief Writes the top-level blocks of `document` that have not been
+		        written yet.
+
+		 Blocks are counted, not matched, so successive calls must pass the
+		 same `Document` as it grows.
+
+		 \param document The document to write.
+		 */
+		void write(const Document& document);
+
+		/*!
+		 \brief Writes the remaining blocks of `document`, followed by the key
+		        table, the block index and the trailer.
+		 \param document The document to write.
+		 */
+		void finish(const Document& document);
+
+		/*!
+		 \brief Gets the number of bytes written so far.
+		 */
+		size_t getSize() const;
+
+		/*!
+		 \brief Writes a whole `Document` to a stream.
+		 \param out The stream to write to.
+		 \param document The document to write.
+		 */
+		static void write(std::ostream& out, const Document& document);
+	private:
+		struct Frame {
+			std::vector<unsigned char> nodes;
+			std::vector<unsigned char> attributes;
+			std::string strings;
+		};
+
+		std::ostream& out;
+		size_t size;
+		size_t written;
+		std::map<std::string, uint32_t> keyIndex;
+		std::vector<const std::string*> keys;
+		std::vector<unsigned char> blockIndex;
+		Frame frame;
+		void writeBlock(const Element& element, size_t id, size_t offset);
+		void writeNode(const Element& element, uint32_t firstChild);
+		uint32_t getKey(const std::string& key);
+		void emit(const void* data, size_t length);
+		void pad();
+	};
+
+}
+
+#endif // BYPASS_DOCUMENT_WRITER_H
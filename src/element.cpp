@@ -14,15 +14,42 @@
 //  limitations under the License.
 //
 
+#include <algorithm>
 #include "element.h"
 
 namespace Bypass {
 
+	// What a node of a std::map costs on top of its value: three links and
+	// a color, rounded up.
+	const static size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+	const static uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+	const static uint64_t FNV_PRIME = 1099511628211ULL;
+
+	static uint64_t hashBytes(uint64_t hash, const void* data, size_t length) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		for (size_t i = 0; i < length; i++) {
+			hash = (hash ^ bytes[i]) * FNV_PRIME;
+		}
+
+		return hash;
+	}
+
+	static uint64_t hashString(uint64_t hash, const std::string& str) {
+		uint64_t length = str.size();
+		hash = hashBytes(hash, &length, sizeof(length));
+		return hashBytes(hash, str.data(), str.size());
+	}
+
 	Element::Element()
 	: text()
 	, attributes()
 	{
 		type = PARAGRAPH;
+		sourceOffset = 0;
+		sourceLength = 0;
+		hash = 0;
 	}
 
 	Element::~Element() {
@@ -31,18 +58,83 @@ namespace Bypass {
 
 	void Element::setText(const std::string& text) {
 		this->text = text;
+		utf16.reset();
 	}
 
-	const std::string& Element::getText() {
+	const std::string& Element::getText() const {
 		return text;
 	}
 
+	size_t Element::getUtf16Length() const {
+		if (utf16 && utf16->getByteLength() == text.size()) {
+			return utf16->getLength();
+		}
+
+		return utf16Length(text.data(), text.size());
+	}
+
+	size_t Element::getUtf16Offset(size_t byteOffset) const {
+		if (utf16 && utf16->getByteLength() == text.size()) {
+			return utf16->toUtf16(text.data(), byteOffset);
+		}
+
+		return utf16Length(text.data(), std::min(byteOffset, text.size()));
+	}
+
+	size_t Element::getByteOffset(size_t utf16Offset) const {
+		if (utf16 && utf16->getByteLength() == text.size()) {
+			return utf16->toUtf8(text.data(), utf16Offset);
+		}
+
+		return Utf16Index(text.data(), text.size()).toUtf8(text.data(), utf16Offset);
+	}
+
+	void Element::setSourceRange(size_t offset, size_t length) {
+		sourceOffset = (uint32_t) std::min(offset, (size_t) UINT32_MAX);
+		sourceLength = (uint32_t) std::min(length, (size_t) UINT32_MAX - sourceOffset);
+	}
+
+	void Element::clipSource(size_t begin, size_t end) {
+		if (!sourceLength) {
+			return;
+		}
+
+		size_t clippedBegin = std::max((size_t) sourceOffset, begin);
+		size_t clippedEnd = std::min((size_t) sourceOffset + sourceLength, end);
+
+		if (clippedBegin > clippedEnd) {
+			clippedBegin = clippedEnd;
+		}
+
+		if (clippedBegin == sourceOffset && clippedEnd - clippedBegin == sourceLength) {
+			return;
+		}
+
+		// Children already lie within this element, so they only need
+		// clipping again when it shrinks.
+
+		setSourceRange(clippedBegin, clippedEnd - clippedBegin);
+
+		for (size_t i = 0; i < children.size(); i++) {
+			children[i].clipSource(clippedBegin, clippedEnd);
+		}
+	}
+
+	size_t Element::getSourceOffset() const {
+		return sourceOffset;
+	}
+
+	size_t Element::getSourceLength() const {
+		return sourceLength;
+	}
+
 	void Element::addAttribute(const std::string& name, const std::string& value) {
 		attributes.insert(std::make_pair(name, value));
 	}
 
-	std::string Element::getAttribute(const std::string& name) {
-		return attributes[name];
+	std::string Element::getAttribute(const std::string& name) const {
+		AttributeMap::const_iterator it = attributes.find(name);
+		return it != attributes.end() ? it->second : std::string();
 	}
 
 	Element::AttributeMap::iterator Element::attrBegin() {
@@ -58,31 +150,163 @@ namespace Bypass {
 	}
 
 	void Element::append(const Element& child) {
+		if (inlineSource) {
+			children = inlineSource->getChildren();
+			inlineSource.reset();
+		}
+
 		children.push_back(Element(child));
+		children.back().updateHash();
 	}
 
-	Element Element::operator[](size_t i) {
-		return children[i];
+	Element Element::operator[](size_t i) const {
+		return getChildren()[i];
 	}
 
 	void Element::setType(Type type) {
 		this->type = type;
 	}
 
-	Type Element::getType() {
+	Type Element::getType() const {
 		return type;
 	}
 
-	bool Element::isBlockElement() {
+	bool Element::isBlockElement() const {
 		return (type & 0x100) == 0x000;
 	}
 
-	bool Element::isSpanElement() {
+	bool Element::isSpanElement() const {
 		return (type & 0x100) == 0x100;
 	}
 
-	size_t Element::size() {
-		return children.size();
+	size_t Element::size() const {
+		return getChildren().size();
+	}
+
+	const std::vector<Element>& Element::getChildren() const {
+		return inlineSource ? inlineSource->getChildren() : children;
+	}
+
+	bool Element::isInlineDeferred() const {
+		return inlineSource && !inlineSource->isParsed();
+	}
+
+	uint64_t Element::getHash() const {
+		return hash;
+	}
+
+	static size_t heapSize(const std::string& str) {
+		// Short strings live inside the string object itself.
+
+		return str.capacity() + 1 > sizeof(std::string) ? str.capacity() + 1 : 0;
+	}
+
+	size_t Element::getFootprint() const {
+		size_t bytes = sizeof(Element) + heapSize(text);
+
+		if (utf16) {
+			bytes += sizeof(Utf16Index) + utf16->getFootprint();
+		}
+
+		for (AttributeMap::const_iterator it = attributes.begin(); it != attributes.end(); ++it) {
+			bytes += MAP_NODE_OVERHEAD + sizeof(*it) + heapSize(it->first) + heapSize(it->second);
+		}
+
+		bytes += (children.capacity() - children.size()) * sizeof(Element);
+
+		for (std::vector<Element>::const_iterator it = children.begin(); it != children.end(); ++it) {
+			bytes += it->getFootprint();
+		}
+
+		if (inlineSource) {
+			bytes += sizeof(InlineSource) + heapSize(inlineSource->getText());
+
+			if (inlineSource->isParsed()) {
+				const std::vector<Element>& parsed = inlineSource->getChildren();
+
+				for (std::vector<Element>::const_iterator it = parsed.begin(); it != parsed.end(); ++it) {
+					bytes += it->getFootprint();
+				}
+			}
+		}
+
+		return bytes;
+	}
+
+	void Element::updateHash() {
+		// Children were hashed when they were appended, so only their
+		// hashes are folded in here.
+
+		uint64_t value = FNV_OFFSET_BASIS;
+		uint32_t typeValue = type;
+		value = hashBytes(value, &typeValue, sizeof(typeValue));
+		value = hashString(value, text);
+
+		for (AttributeMap::const_iterator it = attributes.begin(); it != attributes.end(); ++it) {
+			value = hashString(value, it->first);
+			value = hashString(value, it->second);
+		}
+
+		for (std::vector<Element>::const_iterator it = children.begin(); it != children.end(); ++it) {
+			value = hashBytes(value, &it->hash, sizeof(it->hash));
+		}
+
+		// Deferred children are stood in for by the text they will be
+		// parsed from, so hashing never forces them to be parsed.
+
+		if (inlineSource) {
+			uint64_t sourceHash = inlineSource->getHash();
+			value = hashBytes(value, &sourceHash, sizeof(sourceHash));
+		}
+
+		// 0 is reserved for elements that have not been hashed yet.
+
+		hash = value ? value : 1;
+	}
+
+	InlineReferences::InlineReferences(const std::string& text)
+	: text(text)
+	{
+		hash = hashString(FNV_OFFSET_BASIS, text);
+	}
+
+	InlineSource::InlineSource(const std::string& text, const std::shared_ptr<const InlineReferences>& references)
+	: text(text)
+	, references(references)
+	, children()
+	, parsed(false)
+	{
+		hash = hashString(FNV_OFFSET_BASIS, text);
+		hash = hashBytes(hash, &references->hash, sizeof(references->hash));
+	}
+
+	InlineSource::~InlineSource() {
+
+	}
+
+	const std::vector<Element>& InlineSource::getChildren() const {
+		std::call_once(once, [this]() {
+			parse(children);
+			parsed = true;
+		});
+
+		return children;
+	}
+
+	bool InlineSource::isParsed() const {
+		return parsed;
+	}
+
+	const std::string& InlineSource::getText() const {
+		return text;
+	}
+
+	const std::string& InlineSource::getReferences() const {
+		return references->text;
+	}
+
+	uint64_t InlineSource::getHash() const {
+		return hash;
 	}
 
 	std::ostream& operator<<(std::ostream& out, const Element& element) {
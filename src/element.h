@@ -22,6 +22,11 @@
 #include <map>
 #include <iostream>
 #include <set>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+#include "utf16.h"
 
 namespace Bypass {
 
@@ -56,6 +61,9 @@ namespace Bypass {
 		STRIKETHROUGH   = 0x115
 	};
 
+	class DeferredInline;
+	class InlineSource;
+
 	/*!
 	 \brief An object that describes some portion of a markdown document.
 
@@ -94,7 +102,65 @@ namespace Bypass {
 		/*!
 		 \brief Returns the text of this `element`.
 		 */
-		const std::string& getText();
+		const std::string& getText() const;
+
+		/*!
+		 \brief Gets the length of the text in UTF-16 code units.
+
+		 This and the conversions below are constant time when the element
+		 was parsed with `ParseOptions::utf16Offsets`, and scan the text
+		 otherwise.
+		 */
+		size_t getUtf16Length() const;
+
+		/*!
+		 \brief Converts a byte offset into the text to a UTF-16 offset.
+		 \param byteOffset An offset at the start of a character, or the end
+		                   of the text.
+		 */
+		size_t getUtf16Offset(size_t byteOffset) const;
+
+		/*!
+		 \brief Converts a UTF-16 offset into the text to a byte offset.
+		 \param utf16Offset An offset in UTF-16 code units.
+		 */
+		size_t getByteOffset(size_t utf16Offset) const;
+
+		/*!
+		 \brief Sets where this `Element` came from in the parsed markdown.
+
+		 Offsets are stored in 32 bits and are clamped to fit.
+
+		 \param offset The offset in bytes from the start of the top-level
+		               element that contains this one.
+		 \param length The length in bytes of the markdown, markup included.
+		 */
+		void setSourceRange(size_t offset, size_t length);
+
+		/*!
+		 \brief Gets where this `Element` starts in the parsed markdown.
+
+		 The offset is relative to the start of the top-level element that
+		 contains this one, as given by `Document::getOffset`, so that blocks
+		 shared across `Parser::reparse` or taken from a `BlockCache` stay
+		 valid. It accounts for carriage returns and for the reference
+		 definitions removed from the markdown before parsing.
+
+		 \return The offset in bytes, or 0 if the element was not produced by
+		         a `Parser`.
+		 */
+		size_t getSourceOffset() const;
+
+		/*!
+		 \brief Gets the length of the markdown this `Element` came from.
+
+		 Blocks exclude the blank lines that follow them. Text merged across
+		 the lines of a list item or block quote spans the prefixes in between.
+
+		 \return The length in bytes, or 0 if the element was not produced by a
+		         `Parser`.
+		 */
+		size_t getSourceLength() const;
 
 		/*!
 		 \brief Adds an attribute to this `Element`.
@@ -114,7 +180,7 @@ namespace Bypass {
 		 \param name The name of the attribute to return.
 		 \return The value of the named attribute.
 		 */
-		std::string getAttribute(const std::string& name);
+		std::string getAttribute(const std::string& name) const;
 
 		/*!
 		 \brief Gets an iterator pointing to the first attribute.
@@ -142,14 +208,14 @@ namespace Bypass {
 		 \param i The index of the child to retrieve.
 		 \return The child.
 		 */
-		Element getChild(size_t i);
+		Element getChild(size_t i) const;
 
 		/*!
 		 \brief Gets a child `Element` of this `Element`.
 		 \param i The index of the child to retrieve.
 		 \return The child.
 		 */
-		Element operator[](size_t i);
+		Element operator[](size_t i) const;
 
 		/*!
 		 \brief Sets the type of this `Dlement`.
@@ -161,27 +227,142 @@ namespace Bypass {
 		 \brief Gets the type of this element.
 		 \return The `Type` of this element.
 		 */
-		Type getType();
+		Type getType() const;
 
 		/*!
 		 \brief Indicates whether or not this element is a block element.
 		 */
-		bool isBlockElement();
+		bool isBlockElement() const;
 
 		/*!
 		 \brief Indicates whether or not this element is a span element.
 		 */
-		bool isSpanElement();
+		bool isSpanElement() const;
 
 		/*!
 		 \brief The number of children this particular `Element` has.
 		 */
-		size_t size();
+		size_t size() const;
+
+		/*!
+		 \brief Gets a hash of the content of the subtree rooted at this element.
+
+		 The hash covers the type, text and attributes of this element and the
+		 hashes of its children, so equal subtrees can be compared in constant
+		 time. It is computed once an element is appended to its parent or to a
+		 `Document`; changes made to the element afterwards are not reflected.
+
+		 \return The hash of this subtree, or 0 if it has not been computed.
+		 */
+		uint64_t getHash() const;
+
+		/*!
+		 \brief Indicates whether the inline content of this element has yet to
+		        be parsed.
+
+		 Elements produced with `ParseOptions::lazyInline` keep the inline text
+		 of their block and only parse it into children when `size` or a child
+		 is first requested. Copies of the element share that work.
+		 */
+		bool isInlineDeferred() const;
+
+		/*!
+		 \brief Estimates the memory held by the subtree rooted at this element.
+
+		 This counts the element objects, the heap storage of their strings,
+		 attribute maps and child vectors, and the text of a deferred block.
+		 Allocator overhead is estimated.
+
+		 \return The footprint in bytes.
+		 */
+		size_t getFootprint() const;
+
 		friend std::ostream& operator<<(std::ostream& out, const Element& element);
 	private:
+		friend class DeferredInline;
+		friend class Differ;
+		friend class Document;
+		friend class DocumentView;
+		friend class DocumentWriter;
+		friend class Exporter;
+		friend class JsonWriter;
+		friend class Parser;
+		friend class SourceIndex;
+		friend class TreeBuilder;
+
 		AttributeMap attributes;
 		std::vector<Element> children;
 		Type type;
+		uint32_t sourceOffset;
+		uint32_t sourceLength;
+		uint64_t hash;
+		std::shared_ptr<const InlineSource> inlineSource;
+		std::shared_ptr<const Utf16Index> utf16;
+		void updateHash();
+		const std::vector<Element>& getChildren() const;
+
+		/*!
+		 \brief Clips the source range of this element, and of its children,
+		        to the given range.
+		 */
+		void clipSource(size_t begin, size_t end);
+	};
+
+	/*!
+	 \brief The reference definitions shared by the deferred blocks of a
+	        document.
+	 */
+	struct InlineReferences {
+		InlineReferences(const std::string& text);
+
+		std::string text;
+		uint64_t hash;
+	};
+
+	/*!
+	 \brief The unparsed inline text of a block, which is parsed into the
+	        children of the block on first use.
+	 */
+	class InlineSource {
+	public:
+		/*!
+		 \brief Creates an `InlineSource`.
+		 \param text The inline markdown of the block.
+		 \param references The reference definitions the text may use.
+		 */
+		InlineSource(const std::string& text, const std::shared_ptr<const InlineReferences>& references);
+
+		virtual ~InlineSource();
+
+		/*!
+		 \brief Gets the parsed children, parsing them on the first call.
+		 */
+		const std::vector<Element>& getChildren() const;
+
+		/*!
+		 \brief Indicates whether the children have been parsed.
+		 */
+		bool isParsed() const;
+
+		const std::string& getText() const;
+		const std::string& getReferences() const;
+
+		/*!
+		 \brief Gets a hash of the text and the references.
+		 */
+		uint64_t getHash() const;
+	protected:
+		/*!
+		 \brief Parses the text into the given children.
+		 */
+		virtual void parse(std::vector<Element>& children) const = 0;
+	private:
+		std::string text;
+		std::shared_ptr<const InlineReferences> references;
+		uint64_t hash;
+		mutable std::vector<Element> children;
+		mutable std::once_flag once;
+		mutable std::atomic<bool> parsed;
 	};
 
 }
@@ -0,0 +1,41 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "basic_parser.h"
+#include "builders.h"
+#include "event_parser.h"
+
+namespace Bypass {
+
+	EventParser::EventParser() {
+
+	}
+
+	EventParser::~EventParser() {
+
+	}
+
+	void EventParser::parse(const char* markdown, Handler& handler) {
+		EventBuilder builder(handler);
+		BasicParser<EventBuilder> parser(builder);
+		parser.parse(markdown);
+	}
+
+	void EventParser::parse(const std::string& markdown, Handler& handler) {
+		parse(markdown.c_str(), handler);
+	}
+
+}
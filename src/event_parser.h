@@ -0,0 +1,72 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_EVENT_PARSER_H
+#define BYPASS_EVENT_PARSER_H
+
+#include <string>
+#include "handler.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief A parser that reports markdown to a `Handler` instead of building
+	        a `Document`.
+
+	 This is a `BasicParser` with an `EventBuilder`: the libsoldout callbacks
+	 write compact records into libsoldout's own buffers rather than creating
+	 elements, and each top-level block is replayed to the handler as soon as
+	 it has been parsed. No `Element` is allocated and no tree is assembled,
+	 so memory use does not grow with the document.
+
+	 The events describe the tree `Parser::parse` builds for the same
+	 markdown, with two exceptions: entities are reported as text rather
+	 than dropped, and spans that libsoldout parses and then backs out of,
+	 which `Parser` leaves behind as stray top-level elements, are not
+	 reported at all.
+	 */
+	class EventParser {
+	public:
+
+		/*!
+		 \brief Creates an `EventParser`.
+		 */
+		EventParser();
+
+		/*!
+		 \brief Destroys the `EventParser`.
+		 */
+		~EventParser();
+
+		/*!
+		 \brief Parses the given markdown, reporting it to a handler.
+		 \param markdown The textual representation of the markdown as a
+		                 character array.
+		 \param handler The handler that receives the events.
+		 */
+		void parse(const char* markdown, Handler& handler);
+
+		/*!
+		 \brief Parses the given markdown, reporting it to a handler.
+		 \param markdown The textual representation of the markdown as a string.
+		 \param handler The handler that receives the events.
+		 */
+		void parse(const std::string& markdown, Handler& handler);
+	};
+
+}
+
+#endif // BYPASS_EVENT_PARSER_H
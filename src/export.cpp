@@ -0,0 +1,210 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include "export.h"
+#include "parser.h"
+
+static_assert(sizeof(bypass_export_header) == 64, "the export header is part of the ABI");
+static_assert(sizeof(bypass_export_node) == 32, "export nodes are part of the ABI");
+static_assert(sizeof(bypass_export_attribute) == 16, "export attributes are part of the ABI");
+
+namespace Bypass {
+
+	/*!
+	 \brief Lays out and writes an exported document, so that the buffer can
+	        be allocated at its final size by the caller.
+	 */
+	class Exporter {
+	public:
+		Exporter(const Document& document);
+
+		/*!
+		 \brief The size of the exported document, or 0 if it does not fit
+		        32-bit offsets.
+		 */
+		size_t getSize() const;
+
+		/*!
+		 \brief Writes the exported document into a buffer of `getSize` bytes.
+		 */
+		void write(unsigned char* out);
+	private:
+		const Document& document;
+		std::vector<const Element*> nodes;
+		std::vector<uint32_t> parents;
+		std::map<std::string, uint32_t> names;
+		size_t attributeCount;
+		size_t stringPoolSize;
+		uint32_t appendString(char* pool, size_t& used, const std::string& str);
+	};
+
+	Exporter::Exporter(const Document& document)
+	: document(document)
+	, nodes()
+	, parents()
+	, names()
+	{
+		attributeCount = 0;
+		stringPoolSize = 0;
+
+		for (size_t i = 0; i < document.blocks.size(); i++) {
+			nodes.push_back(document.blocks[i].element.get());
+			parents.push_back(BYPASS_EXPORT_NO_PARENT);
+		}
+
+		// Breadth first, so that the children of a node are contiguous.
+
+		for (size_t i = 0; i < nodes.size(); i++) {
+			const Element& element = *nodes[i];
+			const std::vector<Element>& children = element.getChildren();
+
+			for (size_t j = 0; j < children.size(); j++) {
+				nodes.push_back(&children[j]);
+				parents.push_back(i);
+			}
+
+			stringPoolSize += element.text.size() + 1;
+			attributeCount += element.attributes.size();
+			Element::AttributeMap::const_iterator it;
+
+			for (it = element.attributes.begin(); it != element.attributes.end(); ++it) {
+				if (names.insert(std::make_pair(it->first, BYPASS_EXPORT_NO_PARENT)).second) {
+					stringPoolSize += it->first.size() + 1;
+				}
+
+				stringPoolSize += it->second.size() + 1;
+			}
+		}
+	}
+
+	size_t Exporter::getSize() const {
+		uint64_t size = sizeof(bypass_export_header)
+			+ (uint64_t) nodes.size() * sizeof(bypass_export_node)
+			+ (uint64_t) attributeCount * sizeof(bypass_export_attribute)
+			+ stringPoolSize;
+
+		return size > UINT32_MAX ? 0 : size;
+	}
+
+	void Exporter::write(unsigned char* out) {
+		bypass_export_header* header = reinterpret_cast<bypass_export_header*>(out);
+		memset(header, 0, sizeof(*header));
+		header->magic = BYPASS_EXPORT_MAGIC;
+		header->version = BYPASS_EXPORT_VERSION;
+		header->header_size = sizeof(bypass_export_header);
+		header->node_size = sizeof(bypass_export_node);
+		header->attribute_size = sizeof(bypass_export_attribute);
+		header->status = document.status;
+		header->root_count = document.blocks.size();
+		header->node_count = nodes.size();
+		header->attribute_count = attributeCount;
+		header->string_pool_size = stringPoolSize;
+		header->nodes_offset = sizeof(bypass_export_header);
+		header->attributes_offset = header->nodes_offset + nodes.size() * sizeof(bypass_export_node);
+		header->strings_offset = header->attributes_offset + attributeCount * sizeof(bypass_export_attribute);
+		header->total_size = getSize();
+
+		bypass_export_node* node = reinterpret_cast<bypass_export_node*>(out + header->nodes_offset);
+		bypass_export_attribute* attribute = reinterpret_cast<bypass_export_attribute*>(out + header->attributes_offset);
+		char* pool = reinterpret_cast<char*>(out + header->strings_offset);
+		size_t used = 0;
+		uint32_t nextChild = document.blocks.size();
+		uint32_t nextAttribute = 0;
+
+		for (size_t i = 0; i < nodes.size(); i++, node++) {
+			const Element& element = *nodes[i];
+			node->type = element.type;
+			node->parent = parents[i];
+			node->first_child = nextChild;
+			node->child_count = element.getChildren().size();
+			node->text_length = element.text.size();
+			node->text_offset = appendString(pool, used, element.text);
+			node->first_attribute = nextAttribute;
+			node->attribute_count = element.attributes.size();
+			nextChild += node->child_count;
+			nextAttribute += node->attribute_count;
+			Element::AttributeMap::const_iterator it;
+
+			for (it = element.attributes.begin(); it != element.attributes.end(); ++it, attribute++) {
+				uint32_t& name = names[it->first];
+
+				if (name == BYPASS_EXPORT_NO_PARENT) {
+					name = appendString(pool, used, it->first);
+				}
+
+				attribute->name_offset = name;
+				attribute->name_length = it->first.size();
+				attribute->value_length = it->second.size();
+				attribute->value_offset = appendString(pool, used, it->second);
+			}
+		}
+	}
+
+	uint32_t Exporter::appendString(char* pool, size_t& used, const std::string& str) {
+		uint32_t offset = used;
+		memcpy(pool + used, str.data(), str.size());
+		pool[used + str.size()] = '\0';
+		used += str.size() + 1;
+		return offset;
+	}
+
+	bool exportDocument(const Document& document, std::vector<unsigned char>& buffer) {
+		Exporter exporter(document);
+		size_t size = exporter.getSize();
+
+		if (size == 0) {
+			buffer.clear();
+			return false;
+		}
+
+		buffer.resize(size);
+		exporter.write(&buffer[0]);
+		return true;
+	}
+
+}
+
+unsigned char *
+bypass_export_markdown(const char *markdown, size_t length, size_t *size) {
+	// Nothing may be thrown across the C boundary.
+
+	try {
+		Bypass::Parser parser;
+		Bypass::Document document = parser.parse(std::string(markdown, length));
+		Bypass::Exporter exporter(document);
+		size_t exported = exporter.getSize();
+		unsigned char* buffer = exported ? static_cast<unsigned char*>(malloc(exported)) : NULL;
+
+		if (buffer) {
+			exporter.write(buffer);
+			*size = exported;
+		}
+
+		return buffer;
+	}
+	catch (...) {
+		return NULL;
+	}
+}
+
+void
+bypass_export_free(unsigned char *buffer) {
+	free(buffer);
+}
@@ -0,0 +1,129 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_EXPORT_H
+#define BYPASS_EXPORT_H
+
+/*
+ A whole Document exported as a single contiguous buffer, for bridges to
+ Java, Objective-C or any other language with a C FFI. The buffer holds no
+ pointers, so it can be copied or moved as a block, and every table can be
+ decoded in bulk, eg. as a java.nio.IntBuffer.
+
+ All integers are uint32_t in the byte order of the producing machine, and
+ every offset is relative to the start of the buffer, which is 8-byte
+ aligned when it comes from bypass_export_markdown.
+
+     header      struct bypass_export_header, header_size bytes
+     nodes       node_count x struct bypass_export_node, node_size bytes each
+     attributes  attribute_count x struct bypass_export_attribute,
+                 attribute_size bytes each
+     strings     string_pool_size bytes of UTF-8
+
+ The first root_count nodes are the top-level elements of the document. The
+ children of every node are stored next to each other (breadth first), so
+ they are the nodes [first_child, first_child + child_count), and a node's
+ attributes are [first_attribute, first_attribute + attribute_count), in
+ name order. Every string in the pool is followed by a NUL byte that its
+ length does not count, and attribute names are stored once each.
+
+ Readers must check magic and version, and should step through the tables
+ by the record sizes in the header: later minor versions may append fields
+ to the records, but never move or remove one.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BYPASS_EXPORT_MAGIC 0x58505942 /* "BYPX" read as little-endian */
+#define BYPASS_EXPORT_VERSION 1
+#define BYPASS_EXPORT_NO_PARENT 0xFFFFFFFF
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bypass_export_header • describes the tables of an exported buffer */
+struct bypass_export_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t node_size;
+	uint32_t attribute_size;
+	uint32_t status;		/* a Bypass::ParseStatus */
+	uint32_t root_count;
+	uint32_t node_count;
+	uint32_t attribute_count;
+	uint32_t string_pool_size;
+	uint32_t nodes_offset;
+	uint32_t attributes_offset;
+	uint32_t strings_offset;
+	uint32_t total_size;		/* of the whole buffer */
+	uint32_t reserved[2];
+};
+
+/* bypass_export_node • one element */
+struct bypass_export_node {
+	uint32_t type;			/* a Bypass::Type */
+	uint32_t parent;		/* BYPASS_EXPORT_NO_PARENT for roots */
+	uint32_t first_child;
+	uint32_t child_count;
+	uint32_t text_offset;		/* into the string pool */
+	uint32_t text_length;
+	uint32_t first_attribute;
+	uint32_t attribute_count;
+};
+
+/* bypass_export_attribute • one name-value pair */
+struct bypass_export_attribute {
+	uint32_t name_offset;		/* into the string pool */
+	uint32_t name_length;
+	uint32_t value_offset;		/* into the string pool */
+	uint32_t value_length;
+};
+
+/* bypass_export_markdown • parses markdown and exports the document */
+/*   returns a buffer to release with bypass_export_free and stores its */
+/*   size, or returns NULL when out of memory or over 4 GB */
+unsigned char *
+bypass_export_markdown(const char *markdown, size_t length, size_t *size);
+
+/* bypass_export_free • releases a buffer from bypass_export_markdown */
+void
+bypass_export_free(unsigned char *buffer);
+
+#ifdef __cplusplus
+}
+
+#include <vector>
+#include "document.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief Exports a `Document` as a single buffer, in the layout described
+	        in export.h.
+	 \param document The document to export.
+	 \param buffer Receives the exported document.
+	 \return Whether or not the document fits the 32-bit offsets of the
+	         layout.
+	 */
+	bool exportDocument(const Document& document, std::vector<unsigned char>& buffer);
+
+}
+#endif
+
+#endif // BYPASS_EXPORT_H
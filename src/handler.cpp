@@ -0,0 +1,121 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstring>
+#include <stdint.h>
+#include "handler.h"
+
+namespace Bypass {
+
+	// Attributes are encoded as a count followed by that many name-value
+	// pairs, each string preceded by its length; every number is a native
+	// uint32_t.
+
+	static uint32_t read32(const char* data) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	TextView::TextView()
+	: data("")
+	, length(0)
+	{
+
+	}
+
+	TextView::TextView(const char* data, size_t length)
+	: data(data)
+	, length(length)
+	{
+
+	}
+
+	std::string TextView::toString() const {
+		return std::string(data, length);
+	}
+
+	Attributes::Attributes()
+	: encoded(NULL)
+	{
+
+	}
+
+	Attributes::Attributes(const char* encoded)
+	: encoded(encoded)
+	{
+
+	}
+
+	size_t Attributes::size() const {
+		return encoded ? read32(encoded) : 0;
+	}
+
+	const char* Attributes::find(size_t i) const {
+		const char* at = encoded + 4;
+
+		for (; i > 0; i--) {
+			at += 4 + read32(at);
+			at += 4 + read32(at);
+		}
+
+		return at;
+	}
+
+	TextView Attributes::getName(size_t i) const {
+		const char* at = find(i);
+		return TextView(at + 4, read32(at));
+	}
+
+	TextView Attributes::getValue(size_t i) const {
+		const char* at = find(i);
+		at += 4 + read32(at);
+		return TextView(at + 4, read32(at));
+	}
+
+	TextView Attributes::get(const std::string& name) const {
+		for (size_t i = 0; i < size(); i++) {
+			TextView candidate = getName(i);
+
+			if (candidate.length == name.size() && memcmp(candidate.data, name.data(), name.size()) == 0) {
+				return getValue(i);
+			}
+		}
+
+		return TextView();
+	}
+
+	Handler::~Handler() {
+
+	}
+
+	void Handler::enterBlock(Type type, const Attributes& attributes) {
+
+	}
+
+	void Handler::exitBlock(Type type) {
+
+	}
+
+	void Handler::text(const TextView& text) {
+
+	}
+
+	void Handler::span(Type type, const TextView& text, const Attributes& attributes) {
+
+	}
+
+}
@@ -0,0 +1,129 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_HANDLER_H
+#define BYPASS_HANDLER_H
+
+#include <string>
+#include "element.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief A run of bytes owned by someone else, valid for the duration of
+	        the call it is passed to.
+	 */
+	struct TextView {
+		TextView();
+		TextView(const char* data, size_t length);
+
+		/*!
+		 \brief Copies the bytes into a string.
+		 */
+		std::string toString() const;
+
+		const char* data;
+		size_t length;
+	};
+
+	/*!
+	 \brief The attributes of an event, in name order, read in place.
+	 */
+	class Attributes {
+	public:
+		/*!
+		 \brief Creates an empty set of attributes.
+		 */
+		Attributes();
+
+		/*!
+		 \brief Wraps attributes encoded by `EventParser`.
+		 */
+		explicit Attributes(const char* encoded);
+
+		/*!
+		 \brief Gets the number of attributes.
+		 */
+		size_t size() const;
+
+		/*!
+		 \brief Gets the name of the i-th attribute.
+		 */
+		TextView getName(size_t i) const;
+
+		/*!
+		 \brief Gets the value of the i-th attribute.
+		 */
+		TextView getValue(size_t i) const;
+
+		/*!
+		 \brief Gets an attribute by name.
+		 \param name The name of the attribute to return.
+		 \return The value of the named attribute, or an empty view.
+		 */
+		TextView get(const std::string& name) const;
+	private:
+		const char* encoded;
+		const char* find(size_t i) const;
+	};
+
+	/*!
+	 \brief Receives the content of a markdown document as a sequence of
+	        events, in document order, without a tree being built.
+
+	 The events describe the same tree that `Parser` would build: every block
+	 element is bracketed by `enterBlock` and `exitBlock`, and every span
+	 element, which never has children, is a single `text` or `span` call.
+	 Views and attributes are only valid during the call they are passed to.
+
+	 Every method does nothing by default, so a handler only overrides the
+	 events it needs.
+	 */
+	class Handler {
+	public:
+		virtual ~Handler();
+
+		/*!
+		 \brief A block element starts.
+		 \param type The type of the block.
+		 \param attributes Its attributes, eg. the `level` of a header.
+		 */
+		virtual void enterBlock(Type type, const Attributes& attributes);
+
+		/*!
+		 \brief The block element last entered, and not yet exited, ends.
+		 \param type The type of the block.
+		 */
+		virtual void exitBlock(Type type);
+
+		/*!
+		 \brief A `TEXT` span.
+		 \param text The text of the span.
+		 */
+		virtual void text(const TextView& text);
+
+		/*!
+		 \brief Any other span, such as an emphasis or a link.
+		 \param type The type of the span.
+		 \param text The text of the span, which may be empty.
+		 \param attributes Its attributes, eg. the `link` of a link.
+		 */
+		virtual void span(Type type, const TextView& text, const Attributes& attributes);
+	};
+
+}
+
+#endif // BYPASS_HANDLER_H
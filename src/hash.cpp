@@ -0,0 +1,79 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstring>
+#include "hash.h"
+
+namespace Bypass {
+
+	const static uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+	const static uint64_t MIX = 0xBF58476D1CE4E5B9ULL;
+	const static uint64_t SECOND_MULTIPLIER = 0x94D049BB133111EBULL;
+
+	static uint64_t finalize(uint64_t value) {
+		value ^= value >> 31;
+		value *= MIX;
+		value ^= value >> 29;
+		return value;
+	}
+
+	uint64_t hash64(const void* data, size_t length, uint64_t seed) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t value = (seed + length) * MULTIPLIER;
+		size_t i = 0;
+
+		for (; i + 8 <= length; i += 8) {
+			uint64_t word;
+			memcpy(&word, bytes + i, sizeof(word));
+			value = (value ^ finalize(word)) * MULTIPLIER;
+		}
+
+		if (i < length) {
+			uint64_t word = 0;
+			memcpy(&word, bytes + i, length - i);
+			value = (value ^ finalize(word)) * MULTIPLIER;
+		}
+
+		return finalize(value);
+	}
+
+	Hash128 hash128(const void* data, size_t length, uint64_t seed) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t low = (seed + length) * MULTIPLIER;
+		uint64_t high = (seed ^ length) * SECOND_MULTIPLIER + 1;
+		size_t i = 0;
+
+		for (; i + 16 <= length; i += 16) {
+			uint64_t words[2];
+			memcpy(words, bytes + i, sizeof(words));
+			low = (low ^ finalize(words[0])) * MULTIPLIER;
+			high = (high ^ finalize(words[1])) * SECOND_MULTIPLIER;
+		}
+
+		uint64_t tail[2] = { 0, 0 };
+		memcpy(tail, bytes + i, length - i);
+		low = (low ^ finalize(tail[0])) * MULTIPLIER;
+		high = (high ^ finalize(tail[1])) * SECOND_MULTIPLIER;
+
+		// Each half ends up depending on every byte.
+
+		Hash128 hash;
+		hash.low = finalize(low ^ (high >> 32));
+		hash.high = finalize(high ^ (low << 32) ^ low);
+		return hash;
+	}
+
+}
@@ -0,0 +1,65 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_HASH_H
+#define BYPASS_HASH_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace Bypass {
+
+	/*!
+	 \brief Hashes a run of bytes, eight at a time.
+
+	 This is a fast non-cryptographic hash meant for cache keys; it is not
+	 stable across versions of the library.
+
+	 \param data The bytes to hash.
+	 \param length The number of bytes.
+	 \param seed A value mixed into the hash, eg. to tell apart configurations.
+	 \return The 64-bit hash.
+	 */
+	uint64_t hash64(const void* data, size_t length, uint64_t seed = 0);
+
+	/*!
+	 \brief A 128-bit hash, wide enough to key a cache by the hash alone.
+	 */
+	struct Hash128 {
+		uint64_t low;
+		uint64_t high;
+
+		bool operator==(const Hash128& other) const {
+			return low == other.low && high == other.high;
+		}
+	};
+
+	/*!
+	 \brief Hashes a run of bytes, sixteen at a time.
+
+	 The two halves are computed in independent lanes over alternating words,
+	 so that the compiler can keep both in flight or vectorize them.
+
+	 \param data The bytes to hash.
+	 \param length The number of bytes.
+	 \param seed A value mixed into the hash, eg. to tell apart configurations.
+	 \return The 128-bit hash.
+	 */
+	Hash128 hash128(const void* data, size_t length, uint64_t seed = 0);
+
+}
+
+#endif // BYPASS_HASH_H
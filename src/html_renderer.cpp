@@ -0,0 +1,351 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstring>
+#include <strings.h>
+#include <stdint.h>
+#include "html_renderer.h"
+
+namespace Bypass {
+
+	// The entity that replaces a byte, or NULL when the byte is copied as is.
+	static const char* ESCAPES[256] = {
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+		NULL, NULL, "&quot;", NULL, NULL, NULL, "&amp;", "&#39;", NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, "&lt;", NULL, "&gt;", NULL
+	};
+
+	static const uint64_t ONES = 0x0101010101010101ULL;
+	static const uint64_t HIGHS = 0x8080808080808080ULL;
+
+	// Whether a word has a zero byte. Bytes of 0x80 and above never count,
+	// so only the bytes below 0x80 need to be told apart.
+	static inline uint64_t zeroBytes(uint64_t word) {
+		return (word - ONES) & ~word;
+	}
+
+	// Whether any of the eight bytes of a word needs escaping.
+	static inline bool needsEscape(uint64_t word) {
+		uint64_t found = zeroBytes(word ^ (ONES * '&')) | zeroBytes(word ^ (ONES * '<'))
+			| zeroBytes(word ^ (ONES * '>')) | zeroBytes(word ^ (ONES * '"'))
+			| zeroBytes(word ^ (ONES * '\''));
+		return (found & HIGHS) != 0;
+	}
+
+	void escapeHtml(struct buf *ob, const char* data, size_t length) {
+		size_t start = 0;
+		size_t i = 0;
+
+		while (i < length) {
+			// Skip ahead a word at a time while there is nothing to escape.
+
+			if (i + 8 <= length) {
+				uint64_t word;
+				memcpy(&word, data + i, 8);
+
+				if (!needsEscape(word)) {
+					i += 8;
+					continue;
+				}
+			}
+
+			const char* escape = ESCAPES[(unsigned char) data[i]];
+
+			if (escape) {
+				bufput(ob, data + start, i - start);
+				bufputs(ob, escape);
+				start = i + 1;
+			}
+
+			i++;
+		}
+
+		bufput(ob, data + start, length - start);
+	}
+
+	// Appends the rendered content of a block without its trailing newlines.
+	static void putTrimmed(struct buf *ob, struct buf *text) {
+		if (!text) {
+			return;
+		}
+
+		size_t size = text->size;
+
+		while (size > 0 && text->data[size - 1] == '\n') {
+			size--;
+		}
+
+		bufput(ob, text->data, size);
+	}
+
+	// Whether a link may be rendered as an href: relative links, and the
+	// http, https and mailto schemes. Anything that could run script, such
+	// as javascript: or data:, is left out.
+	static bool isSafeLink(const char* data, size_t length) {
+		static const char* SCHEMES[] = { "http", "https", "mailto" };
+
+		size_t colon = 0;
+
+		while (colon < length && data[colon] != ':') {
+			if (data[colon] == '/' || data[colon] == '?' || data[colon] == '#') {
+				return true;
+			}
+
+			colon++;
+		}
+
+		if (colon == length) {
+			return true;
+		}
+
+		for (size_t i = 0; i < sizeof(SCHEMES) / sizeof(SCHEMES[0]); i++) {
+			if (strlen(SCHEMES[i]) == colon && strncasecmp(data, SCHEMES[i], colon) == 0) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	HtmlRenderer::HtmlRenderer(const Sink& sink)
+	: sink(sink)
+	{
+		pendingSize = 0;
+	}
+
+	HtmlRenderer::~HtmlRenderer() {
+		flush();
+
+		for (size_t i = 0; i < spare.size(); i++) {
+			bufrelease(spare[i]);
+		}
+	}
+
+	void HtmlRenderer::render(const char* markdown) {
+		BasicParser<HtmlRenderer> parser(*this);
+		parser.parse(markdown);
+		flush();
+	}
+
+	void HtmlRenderer::render(const std::string& markdown) {
+		render(markdown.c_str());
+	}
+
+	void HtmlRenderer::flush() {
+		if (pending.empty()) {
+			return;
+		}
+
+		struct iovec chunks[HTML_MAX_CHUNKS];
+
+		for (size_t i = 0; i < pending.size(); i++) {
+			chunks[i].iov_base = pending[i]->data;
+			chunks[i].iov_len = pending[i]->size;
+		}
+
+		sink(chunks, (int) pending.size());
+
+		for (size_t i = 0; i < pending.size(); i++) {
+			pending[i]->size = 0;
+			spare.push_back(pending[i]);
+		}
+
+		pending.clear();
+		pendingSize = 0;
+	}
+
+	void HtmlRenderer::render(std::ostream& out, const std::string& markdown) {
+		HtmlRenderer renderer([&out](const struct iovec* chunks, int count) {
+			for (int i = 0; i < count; i++) {
+				out.write((const char*) chunks[i].iov_base, chunks[i].iov_len);
+			}
+		});
+
+		renderer.render(markdown);
+	}
+
+	// Builder interface
+
+	void HtmlRenderer::parsedBlockCode(struct buf *ob, struct buf *text) {
+		BUFPUTSL(ob, "<pre><code>");
+
+		if (text) {
+			escapeHtml(ob, text->data, text->size);
+		}
+
+		BUFPUTSL(ob, "</code></pre>\n");
+	}
+
+	void HtmlRenderer::parsedBlock(Type type, struct buf *ob, struct buf *text, int extra) {
+		switch (type) {
+			case BLOCK_QUOTE:
+				BUFPUTSL(ob, "<blockquote>\n");
+				putTrimmed(ob, text);
+				BUFPUTSL(ob, "\n</blockquote>\n");
+				break;
+			case HEADER:
+				bufprintf(ob, "<h%d>", extra);
+				putTrimmed(ob, text);
+				bufprintf(ob, "</h%d>\n", extra);
+				break;
+			case LIST:
+				bufputs(ob, extra & MKD_LIST_ORDERED ? "<ol>\n" : "<ul>\n");
+				putTrimmed(ob, text);
+				bufputs(ob, extra & MKD_LIST_ORDERED ? "\n</ol>\n" : "\n</ul>\n");
+				break;
+			case LIST_ITEM:
+				BUFPUTSL(ob, "<li>");
+				putTrimmed(ob, text);
+				BUFPUTSL(ob, "</li>\n");
+				break;
+			case PARAGRAPH:
+				BUFPUTSL(ob, "<p>");
+				putTrimmed(ob, text);
+				BUFPUTSL(ob, "</p>\n");
+				break;
+			default:
+				putTrimmed(ob, text);
+				break;
+		}
+	}
+
+	void HtmlRenderer::parsedSpan(Type type, struct buf *ob, struct buf *text, struct buf *link, struct buf *title) {
+		switch (type) {
+			case AUTOLINK:
+				if (!link || !isSafeLink(link->data, link->size)) {
+					escapeHtml(ob, text->data, text->size);
+					return;
+				}
+
+				BUFPUTSL(ob, "<a href=\"");
+				escapeHtml(ob, link->data, link->size);
+				BUFPUTSL(ob, "\">");
+				escapeHtml(ob, text->data, text->size);
+				BUFPUTSL(ob, "</a>");
+				return;
+			case LINK:
+				// A link to an unsafe target keeps its content, without the
+				// anchor.
+
+				if (link && !isSafeLink(link->data, link->size)) {
+					if (text) {
+						bufput(ob, text->data, text->size);
+					}
+
+					return;
+				}
+
+				BUFPUTSL(ob, "<a href=\"");
+
+				if (link) {
+					escapeHtml(ob, link->data, link->size);
+				}
+
+				if (title && title->size > 0) {
+					BUFPUTSL(ob, "\" title=\"");
+					escapeHtml(ob, title->data, title->size);
+				}
+
+				BUFPUTSL(ob, "\">");
+
+				if (text) {
+					bufput(ob, text->data, text->size);
+				}
+
+				BUFPUTSL(ob, "</a>");
+				return;
+			case DOUBLE_EMPHASIS:
+				BUFPUTSL(ob, "<strong>");
+				bufput(ob, text->data, text->size);
+				BUFPUTSL(ob, "</strong>");
+				return;
+			case EMPHASIS:
+				BUFPUTSL(ob, "<em>");
+				bufput(ob, text->data, text->size);
+				BUFPUTSL(ob, "</em>");
+				return;
+			case TRIPLE_EMPHASIS:
+				BUFPUTSL(ob, "<strong><em>");
+				bufput(ob, text->data, text->size);
+				BUFPUTSL(ob, "</em></strong>");
+				return;
+			case STRIKETHROUGH:
+				BUFPUTSL(ob, "<del>");
+				bufput(ob, text->data, text->size);
+				BUFPUTSL(ob, "</del>");
+				return;
+			default:
+				bufput(ob, text->data, text->size);
+				return;
+		}
+	}
+
+	void HtmlRenderer::parsedCodeSpan(struct buf *ob, struct buf *text) {
+		BUFPUTSL(ob, "<code>");
+
+		if (text) {
+			escapeHtml(ob, text->data, text->size);
+		}
+
+		BUFPUTSL(ob, "</code>");
+	}
+
+	void HtmlRenderer::parsedLinebreak(struct buf *ob) {
+		// libsoldout only takes back one of the spaces that make the break.
+
+		while (ob->size > 0 && ob->data[ob->size - 1] == ' ') {
+			ob->size--;
+		}
+
+		BUFPUTSL(ob, "<br>\n");
+	}
+
+	void HtmlRenderer::parsedNormalText(struct buf *ob, struct buf *text) {
+		escapeHtml(ob, text->data, text->size);
+	}
+
+	void HtmlRenderer::parsedTopLevel(struct buf *ob, size_t offset) {
+		if (ob->size == 0) {
+			return;
+		}
+
+		// Keep the rendered block as a chunk by trading its storage for an
+		// empty buffer, which the parser goes on to fill.
+
+		struct buf *chunk;
+
+		if (spare.empty()) {
+			chunk = bufnew(HTML_OUTPUT_UNIT);
+		}
+		else {
+			chunk = spare.back();
+			spare.pop_back();
+		}
+
+		struct buf swapped = *chunk;
+		*chunk = *ob;
+		*ob = swapped;
+
+		pending.push_back(chunk);
+		pendingSize += chunk->size;
+
+		if (pendingSize >= HTML_FLUSH_SIZE || pending.size() == HTML_MAX_CHUNKS) {
+			flush();
+		}
+	}
+
+}
@@ -0,0 +1,142 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_HTML_RENDERER_H
+#define BYPASS_HTML_RENDERER_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+#include "basic_parser.h"
+
+#define HTML_OUTPUT_UNIT 1024
+#define HTML_FLUSH_SIZE 65536
+#define HTML_MAX_CHUNKS 16
+
+namespace Bypass {
+
+	/*!
+	 \brief Renders markdown straight to HTML, without building a tree.
+
+	 Each callback of the parse writes its HTML into the libsoldout output
+	 buffer as it runs, so the only copies are the ones libsoldout makes
+	 itself. The elements are the ones `Parser` supports:
+
+	 | Type              | HTML                          |
+	 |-------------------|-------------------------------|
+	 | `BLOCK_CODE`      | `<pre><code>`                 |
+	 | `BLOCK_QUOTE`     | `<blockquote>`                |
+	 | `HEADER`          | `<h1>` to `<h6>`              |
+	 | `LIST`            | `<ul>`, or `<ol>` if ordered  |
+	 | `LIST_ITEM`       | `<li>`                        |
+	 | `PARAGRAPH`       | `<p>`                         |
+	 | `AUTOLINK`        | `<a href>`                    |
+	 | `CODE_SPAN`       | `<code>`                      |
+	 | `DOUBLE_EMPHASIS` | `<strong>`                    |
+	 | `EMPHASIS`        | `<em>`                        |
+	 | `LINEBREAK`       | `<br>`                        |
+	 | `LINK`            | `<a href title>`              |
+	 | `TRIPLE_EMPHASIS` | `<strong><em>`                |
+	 | `STRIKETHROUGH`   | `<del>`                       |
+
+	 Text, code and attribute values are escaped; entities are copied
+	 through. Links are only rendered as anchors when they are relative or
+	 use the http, https or mailto scheme; other links, such as
+	 `javascript:` ones, keep their content without the anchor. Each top-level block is kept as its own chunk, and the chunks
+	 go to the sink together, in the shape `writev` takes, once they add up
+	 to `HTML_FLUSH_SIZE` bytes or `HTML_MAX_CHUNKS` chunks.
+	 */
+	class HtmlRenderer {
+	public:
+
+		/*!
+		 \brief Receives the output as a list of chunks, in order.
+
+		 The chunks are only valid for the duration of the call.
+		 */
+		typedef std::function<void(const struct iovec* chunks, int count)> Sink;
+
+		/*!
+		 \brief Creates an `HtmlRenderer`.
+		 \param sink The function that receives the output.
+		 */
+		HtmlRenderer(const Sink& sink);
+
+		/*!
+		 \brief Destroys the `HtmlRenderer`, flushing any pending output.
+		 */
+		~HtmlRenderer();
+
+		HtmlRenderer(const HtmlRenderer&) = delete;
+		HtmlRenderer& operator=(const HtmlRenderer&) = delete;
+
+		/*!
+		 \brief Renders the given markdown and flushes it to the sink.
+		 \param markdown The textual representation of the markdown as a
+		                 character array.
+		 */
+		void render(const char* markdown);
+
+		/*!
+		 \brief Renders the given markdown and flushes it to the sink.
+		 \param markdown The textual representation of the markdown as a string.
+		 */
+		void render(const std::string& markdown);
+
+		/*!
+		 \brief Hands any pending chunks to the sink.
+		 */
+		void flush();
+
+		/*!
+		 \brief Renders markdown as HTML to a stream.
+		 \param out The stream to write to.
+		 \param markdown The markdown to render.
+		 */
+		static void render(std::ostream& out, const std::string& markdown);
+	private:
+		friend class BasicParser<HtmlRenderer>;
+
+		Sink sink;
+		std::vector<struct buf*> pending;
+		std::vector<struct buf*> spare;
+		size_t pendingSize;
+
+		// Builder interface, see BasicParser
+
+		void parsedBlockCode(struct buf *ob, struct buf *text);
+		void parsedBlock(Type type, struct buf *ob, struct buf *text, int extra);
+		void parsedSpan(Type type, struct buf *ob, struct buf *text, struct buf *link, struct buf *title);
+		void parsedCodeSpan(struct buf *ob, struct buf *text);
+		void parsedLinebreak(struct buf *ob);
+		void parsedNormalText(struct buf *ob, struct buf *text);
+		void parsedTopLevel(struct buf *ob, size_t offset);
+	};
+
+	/*!
+	 \brief Appends text to a buffer, escaping it for use in HTML text and
+	        attribute values.
+	 \param ob The buffer to append to.
+	 \param data The text to escape.
+	 \param length The length of the text.
+	 */
+	void escapeHtml(struct buf *ob, const char* data, size_t length);
+
+}
+
+#endif // BYPASS_HTML_RENDERER_H
@@ -0,0 +1,218 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstring>
+#include <stdint.h>
+#include "json_writer.h"
+
+namespace Bypass {
+
+	// Indexed by the low byte of a Type; span types follow on from the
+	// block types.
+	static const char* TYPE_NAMES[] = {
+		"BLOCK_CODE", "BLOCK_QUOTE", "BLOCK_HTML", "HEADER", "HRULE", "LIST",
+		"LIST_ITEM", "PARAGRAPH", "TABLE", "TABLE_CELL", "TABLE_ROW",
+		"AUTOLINK", "CODE_SPAN", "DOUBLE_EMPHASIS", "EMPHASIS", "IMAGE",
+		"LINEBREAK", "LINK", "RAW_HTML_TAG", "TRIPLE_EMPHASIS", "TEXT",
+		"STRIKETHROUGH"
+	};
+
+	static const char* STATUS_NAMES[] = {
+		"COMPLETE", "CANCELLED", "DEADLINE_EXCEEDED", "NODE_LIMIT_EXCEEDED",
+		"OUTPUT_LIMIT_EXCEEDED", "VISIBLE_CHAR_LIMIT_REACHED",
+		"BLOCK_LIMIT_REACHED", "INVALID_UTF8"
+	};
+
+	// The character that follows the backslash when a byte is escaped, or 0
+	// when the byte is copied as is. Control characters without a short
+	// form are written as \u00XX.
+	static const char ESCAPES[256] = {
+		'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+		'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+		0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0
+	};
+
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+
+	static const uint64_t ONES = 0x0101010101010101ULL;
+	static const uint64_t HIGHS = 0x8080808080808080ULL;
+
+	// Whether any of the eight bytes of a word needs escaping: a control
+	// character, a quote or a backslash. Bytes of 0x80 and above never
+	// match, so UTF-8 sequences are skipped a word at a time.
+	static bool needsEscape(uint64_t word) {
+		uint64_t quotes = word ^ (ONES * '"');
+		uint64_t backslashes = word ^ (ONES * '\\');
+		uint64_t controls = (word - ONES * 0x20) & ~word;
+		uint64_t found = controls | ((quotes - ONES) & ~quotes) | ((backslashes - ONES) & ~backslashes);
+		return (found & HIGHS) != 0;
+	}
+
+	JsonWriter::JsonWriter(const Sink& sink)
+	: sink(sink)
+	{
+		used = 0;
+	}
+
+	JsonWriter::~JsonWriter() {
+		flush();
+	}
+
+	void JsonWriter::write(const Document& document) {
+		append("{\"status\":\"");
+		append(STATUS_NAMES[document.status], strlen(STATUS_NAMES[document.status]));
+		append("\",\"children\":[");
+
+		for (size_t i = 0; i < document.blocks.size(); i++) {
+			if (i > 0) {
+				append(',');
+			}
+
+			writeElement(*document.blocks[i].element);
+		}
+
+		append("]}");
+		flush();
+	}
+
+	void JsonWriter::write(const Element& element) {
+		writeElement(element);
+		flush();
+	}
+
+	void JsonWriter::flush() {
+		if (used > 0) {
+			sink(buffer, used);
+			used = 0;
+		}
+	}
+
+	void JsonWriter::write(std::ostream& out, const Document& document) {
+		JsonWriter writer([&out](const char* data, size_t length) {
+			out.write(data, length);
+		});
+
+		writer.write(document);
+	}
+
+	void JsonWriter::writeElement(const Element& element) {
+		const char* type = TYPE_NAMES[element.type & 0xFF];
+		append("{\"type\":\"");
+		append(type, strlen(type));
+		append('"');
+
+		if (!element.text.empty()) {
+			append(",\"text\":");
+			writeString(element.text.data(), element.text.size());
+		}
+
+		if (!element.attributes.empty()) {
+			append(",\"attributes\":{");
+			Element::AttributeMap::const_iterator it;
+
+			for (it = element.attributes.begin(); it != element.attributes.end(); ++it) {
+				if (it != element.attributes.begin()) {
+					append(',');
+				}
+
+				writeString(it->first.data(), it->first.size());
+				append(':');
+				writeString(it->second.data(), it->second.size());
+			}
+
+			append('}');
+		}
+
+		const std::vector<Element>& children = element.getChildren();
+
+		if (!children.empty()) {
+			append(",\"children\":[");
+
+			for (size_t i = 0; i < children.size(); i++) {
+				if (i > 0) {
+					append(',');
+				}
+
+				writeElement(children[i]);
+			}
+
+			append(']');
+		}
+
+		append('}');
+	}
+
+	void JsonWriter::writeString(const char* data, size_t length) {
+		size_t start = 0;
+		size_t i = 0;
+		append('"');
+
+		while (i < length) {
+			// Skip ahead a word at a time while there is nothing to escape.
+
+			if (i + 8 <= length) {
+				uint64_t word;
+				memcpy(&word, data + i, 8);
+
+				if (!needsEscape(word)) {
+					i += 8;
+					continue;
+				}
+			}
+
+			unsigned char c = data[i];
+			char escape = ESCAPES[c];
+
+			if (escape) {
+				append(data + start, i - start);
+				char sequence[6] = { '\\', escape, '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0xF] };
+				append(sequence, escape == 'u' ? 6 : 2);
+				start = i + 1;
+			}
+
+			i++;
+		}
+
+		append(data + start, length - start);
+		append('"');
+	}
+
+	void JsonWriter::append(const char* data, size_t length) {
+		if (used + length > JSON_BUFFER_SIZE) {
+			flush();
+
+			if (length >= JSON_BUFFER_SIZE) {
+				sink(data, length);
+				return;
+			}
+		}
+
+		memcpy(buffer + used, data, length);
+		used += length;
+	}
+
+	void JsonWriter::append(char c) {
+		if (used == JSON_BUFFER_SIZE) {
+			flush();
+		}
+
+		buffer[used++] = c;
+	}
+
+}
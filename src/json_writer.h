@@ -0,0 +1,106 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_JSON_WRITER_H
+#define BYPASS_JSON_WRITER_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include "document.h"
+#include "element.h"
+
+#define JSON_BUFFER_SIZE 4096
+
+namespace Bypass {
+
+	/*!
+	 \brief Writes a `Document` or an `Element` tree as JSON.
+
+	 Every element becomes an object with its `type`, and its `text`,
+	 `attributes` and `children` when it has any:
+
+	     {"type":"HEADER","attributes":{"level":"1"},"children":[
+	         {"type":"TEXT","text":"Title"}]}
+
+	 A document becomes `{"status":"COMPLETE","children":[...]}`. Types and
+	 statuses are spelled as in `Type` and `ParseStatus`, without prefix.
+
+	 The tree is walked in place and the output goes through a fixed buffer
+	 to the sink, so writing allocates nothing beyond the inline children of
+	 a lazily parsed block. Text is copied to the output as is; it is
+	 expected to be UTF-8.
+	 */
+	class JsonWriter {
+	public:
+
+		/*!
+		 \brief Receives the output in chunks, in order.
+		 */
+		typedef std::function<void(const char* data, size_t length)> Sink;
+
+		/*!
+		 \brief Creates a `JsonWriter`.
+		 \param sink The function that receives the output.
+		 */
+		JsonWriter(const Sink& sink);
+
+		/*!
+		 \brief Destroys the `JsonWriter`, flushing any buffered output.
+		 */
+		~JsonWriter();
+
+		/*!
+		 \brief Writes a document and flushes it to the sink.
+		 \param document The document to write.
+		 */
+		void write(const Document& document);
+
+		/*!
+		 \brief Writes an element tree and flushes it to the sink.
+		 \param element The root of the tree to write.
+		 */
+		void write(const Element& element);
+
+		/*!
+		 \brief Hands any buffered output to the sink.
+		 */
+		void flush();
+
+		/*!
+		 \brief Writes a document as JSON to a stream.
+		 \param out The stream to write to.
+		 \param document The document to write.
+		 */
+		static void write(std::ostream& out, const Document& document);
+	private:
+		Sink sink;
+		char buffer[JSON_BUFFER_SIZE];
+		size_t used;
+		void writeElement(const Element& element);
+		void writeString(const char* data, size_t length);
+		void append(const char* data, size_t length);
+		void append(char c);
+
+		template <size_t N>
+		void append(const char (&literal)[N]) {
+			append(literal, N - 1);
+		}
+	};
+
+}
+
+#endif // BYPASS_JSON_WRITER_H
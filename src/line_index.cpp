@@ -0,0 +1,60 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <algorithm>
+#include "line_index.h"
+
+namespace Bypass {
+
+	LineIndex::LineIndex(const char* data, size_t length)
+	: starts()
+	{
+		index(data, length);
+	}
+
+	LineIndex::LineIndex(const std::string& markdown)
+	: starts()
+	{
+		index(markdown.data(), markdown.size());
+	}
+
+	void LineIndex::index(const char* data, size_t length) {
+		starts.push_back(0);
+
+		for (size_t i = 0; i < length; i++) {
+			if (data[i] == '\n' || (data[i] == '\r' && (i + 1 == length || data[i + 1] != '\n'))) {
+				starts.push_back(i + 1);
+			}
+		}
+	}
+
+	size_t LineIndex::getLineCount() const {
+		return starts.size();
+	}
+
+	size_t LineIndex::getLine(size_t offset) const {
+		return std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+	}
+
+	size_t LineIndex::getColumn(size_t offset) const {
+		return offset - starts[getLine(offset)];
+	}
+
+	size_t LineIndex::getLineOffset(size_t line) const {
+		return starts[line];
+	}
+
+}
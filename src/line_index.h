@@ -0,0 +1,81 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_LINE_INDEX_H
+#define BYPASS_LINE_INDEX_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Bypass {
+
+	/*!
+	 \brief Converts between byte offsets into markdown and line and column
+	        numbers.
+
+	 Elements only carry byte offsets into the markdown they were parsed
+	 from, see `Element::getSourceOffset`; this turns them into positions an
+	 editor can show. Lines end at `\n`, `\r\n` or a lone `\r`, as they do
+	 for the parser. Lines and columns count from 0, and columns are counted
+	 in bytes.
+	 */
+	class LineIndex {
+	public:
+
+		/*!
+		 \brief Creates the index of the given markdown.
+		 */
+		LineIndex(const char* data, size_t length);
+
+		/*!
+		 \brief Creates the index of the given markdown.
+		 */
+		LineIndex(const std::string& markdown);
+
+		/*!
+		 \brief Gets the number of lines, counting the one after a final
+		        newline.
+		 */
+		size_t getLineCount() const;
+
+		/*!
+		 \brief Gets the line that holds a byte.
+		 \param offset An offset into the markdown. Offsets past the end fall
+		               on the last line.
+		 */
+		size_t getLine(size_t offset) const;
+
+		/*!
+		 \brief Gets the column of a byte within its line.
+		 \param offset An offset into the markdown.
+		 */
+		size_t getColumn(size_t offset) const;
+
+		/*!
+		 \brief Gets where a line starts.
+		 \param line A line number, less than `getLineCount`.
+		 \return The offset of the first byte of the line.
+		 */
+		size_t getLineOffset(size_t line) const;
+	private:
+		std::vector<size_t> starts;
+		void index(const char* data, size_t length);
+	};
+
+}
+
+#endif // BYPASS_LINE_INDEX_H
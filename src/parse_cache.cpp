@@ -0,0 +1,145 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "parse_cache.h"
+#include "parser.h"
+
+namespace Bypass {
+
+	// The cost of an entry on top of its document: the list node and the
+	// index node, estimated.
+	const static size_t ENTRY_OVERHEAD = sizeof(void*) * 8;
+
+	ParseCache::ParseCache(size_t budget, size_t shardCount)
+	: shards()
+	{
+		if (shardCount == 0) {
+			shardCount = 1;
+		}
+
+		for (size_t i = 0; i < shardCount; i++) {
+			Shard* shard = new Shard();
+			shard->bytes = 0;
+			shard->hits = 0;
+			shard->misses = 0;
+			shard->evictions = 0;
+			shards.push_back(std::unique_ptr<Shard>(shard));
+		}
+
+		shardBudget = budget / shardCount;
+	}
+
+	ParseCache::~ParseCache() {
+
+	}
+
+	Document ParseCache::parse(const std::string& markdown, const ParseOptions& options) {
+		// Only the options that change the resulting tree are part of the
+		// key; deadlines and cancellation only decide whether it is kept.
+
+		uint64_t config[] = {
+			options.maxNodes,
+			options.maxOutputBytes,
+			options.maxVisibleChars,
+			options.maxBlocks,
+			options.lazyInline,
+			options.utf16Offsets,
+			(uint64_t) options.utf8Policy
+		};
+
+		Hash128 key = hash128(markdown.data(), markdown.size(), hash64(config, sizeof(config)));
+		Shard& shard = getShard(key);
+
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			std::unordered_map<Hash128, EntryList::iterator, KeyHash>::iterator it = shard.index.find(key);
+
+			if (it != shard.index.end()) {
+				shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+				shard.hits++;
+				return it->second->document;
+			}
+
+			shard.misses++;
+		}
+
+		Parser parser;
+		Document document = parser.parse(markdown, options);
+		ParseStatus status = document.getStatus();
+
+		if (status == PARSE_CANCELLED || status == PARSE_DEADLINE_EXCEEDED) {
+			return document;
+		}
+
+		Entry entry;
+		entry.key = key;
+		entry.document = document;
+		entry.footprint = sizeof(Entry) + ENTRY_OVERHEAD + document.getFootprint() - sizeof(Document);
+
+		if (entry.footprint > shardBudget) {
+			return document;
+		}
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		// Another thread may have parsed the same markdown meanwhile.
+
+		if (shard.index.find(key) == shard.index.end()) {
+			shard.entries.push_front(entry);
+			shard.index[key] = shard.entries.begin();
+			shard.bytes += entry.footprint;
+
+			while (shard.bytes > shardBudget) {
+				EntryList::iterator last = --shard.entries.end();
+				shard.bytes -= last->footprint;
+				shard.index.erase(last->key);
+				shard.entries.erase(last);
+				shard.evictions++;
+			}
+		}
+
+		return document;
+	}
+
+	void ParseCache::clear() {
+		for (size_t i = 0; i < shards.size(); i++) {
+			std::lock_guard<std::mutex> lock(shards[i]->mutex);
+			shards[i]->entries.clear();
+			shards[i]->index.clear();
+			shards[i]->bytes = 0;
+		}
+	}
+
+	ParseCache::Statistics ParseCache::getStatistics() {
+		Statistics statistics = { 0, 0, 0, 0, 0 };
+
+		for (size_t i = 0; i < shards.size(); i++) {
+			std::lock_guard<std::mutex> lock(shards[i]->mutex);
+			statistics.hits += shards[i]->hits;
+			statistics.misses += shards[i]->misses;
+			statistics.evictions += shards[i]->evictions;
+			statistics.entries += shards[i]->entries.size();
+			statistics.bytes += shards[i]->bytes;
+		}
+
+		return statistics;
+	}
+
+	ParseCache::Shard& ParseCache::getShard(const Hash128& key) {
+		return *shards[key.high % shards.size()];
+	}
+
+}
@@ -0,0 +1,125 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_PARSE_CACHE_H
+#define BYPASS_PARSE_CACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "document.h"
+#include "hash.h"
+#include "parse_options.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief A cache of whole parsed documents, for markdown that is parsed
+	        again and again on many threads.
+
+	 Entries are keyed by a 128-bit hash of the markdown and of the options
+	 that shape the result, and hold a `Document` whose elements are shared
+	 with every copy handed out. The cache is split into shards, each with its
+	 own lock, least recently used list and share of the memory budget, so
+	 that threads looking up different documents rarely contend.
+	 */
+	class ParseCache {
+	public:
+
+		/*!
+		 \brief Counters describing how a `ParseCache` has been used, summed
+		        over every shard.
+		 */
+		struct Statistics {
+			size_t hits;
+			size_t misses;
+			size_t evictions;
+			size_t entries;
+			size_t bytes;
+		};
+
+		/*!
+		 \brief Creates an empty `ParseCache`.
+		 \param budget The number of bytes the cache may hold, as measured by
+		               `Document::getFootprint`.
+		 \param shardCount The number of independently locked shards.
+		 */
+		ParseCache(size_t budget, size_t shardCount = 16);
+
+		/*!
+		 \brief Destroys the `ParseCache`.
+		 */
+		~ParseCache();
+
+		/*!
+		 \brief Returns the cached `Document` for the given markdown, parsing
+		        and caching it on a miss.
+
+		 Parses that were cancelled or ran past their deadline are returned
+		 but not cached.
+
+		 \param markdown The textual representation of the markdown as a string.
+		 \param options The options to parse with.
+		 \return A `Document` object that represents the supplied markdown.
+		 */
+		Document parse(const std::string& markdown, const ParseOptions& options = ParseOptions());
+
+		/*!
+		 \brief Drops every entry. The counters are kept.
+		 */
+		void clear();
+
+		/*!
+		 \brief Gets the counters of this cache.
+		 */
+		Statistics getStatistics();
+
+	private:
+		struct Entry {
+			Hash128 key;
+			Document document;
+			size_t footprint;
+		};
+
+		struct KeyHash {
+			size_t operator()(const Hash128& key) const {
+				return (size_t) key.low;
+			}
+		};
+
+		typedef std::list<Entry> EntryList;
+
+		struct Shard {
+			std::mutex mutex;
+			EntryList entries;
+			std::unordered_map<Hash128, EntryList::iterator, KeyHash> index;
+			size_t bytes;
+			size_t hits;
+			size_t misses;
+			size_t evictions;
+		};
+
+		std::vector<std::unique_ptr<Shard> > shards;
+		size_t shardBudget;
+		Shard& getShard(const Hash128& key);
+	};
+
+}
+
+#endif // BYPASS_PARSE_CACHE_H
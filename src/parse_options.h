@@ -0,0 +1,165 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_PARSE_OPTIONS_H
+#define BYPASS_PARSE_OPTIONS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace Bypass {
+
+	class BlockCache;
+
+	/*!
+	 \brief What a parse does with input that is not well-formed UTF-8.
+	 */
+	enum Utf8Policy {
+
+		/*!
+		 \brief Every invalid sequence is replaced with U+FFFD.
+		 */
+		UTF8_REPLACE,
+
+		/*!
+		 \brief Nothing is parsed, and the `Document` is returned with
+		        `PARSE_INVALID_UTF8`.
+		 */
+		UTF8_REJECT,
+
+		/*!
+		 \brief The input is not checked, and element text holds whatever
+		        bytes it was given.
+		 */
+		UTF8_PASS_THROUGH
+	};
+
+	/*!
+	 \brief Limits that bound the work a single parse may do, and switches that
+	        defer some of it.
+
+	 The limits are checked at block and span boundaries while libsoldout runs.
+	 When one of them is hit the parse stops, every open element is closed, and
+	 the partial `Document` is returned with a `ParseStatus` explaining why.
+	 A default constructed `ParseOptions` imposes no limits at all.
+	 */
+	struct ParseOptions {
+
+		/*!
+		 \brief The clock that deadlines are measured against.
+		 */
+		typedef std::chrono::steady_clock Clock;
+
+		/*!
+		 \brief Creates `ParseOptions` without any limits.
+		 */
+		ParseOptions()
+		: deadline(Clock::time_point::max())
+		, cancel(NULL)
+		, maxNodes(0)
+		, maxOutputBytes(0)
+		, maxVisibleChars(0)
+		, maxBlocks(0)
+		, lazyInline(false)
+		, utf16Offsets(false)
+		, utf8Policy(UTF8_REPLACE)
+		, blockCache(NULL)
+		{
+
+		}
+
+		/*!
+		 \brief The point in time after which the parse is abandoned.
+		 */
+		Clock::time_point deadline;
+
+		/*!
+		 \brief A flag that another thread may raise to abandon the parse, or
+		        `NULL`.
+		 */
+		const std::atomic<bool>* cancel;
+
+		/*!
+		 \brief The number of elements after which the parse is abandoned, or 0
+		        for no limit.
+		 */
+		size_t maxNodes;
+
+		/*!
+		 \brief The number of bytes of element text and attributes after which
+		        the parse is abandoned, or 0 for no limit.
+		 */
+		size_t maxOutputBytes;
+
+		/*!
+		 \brief The number of visible characters, ie. characters of text and
+		        code, after which the parse stops, or 0 for no limit.
+
+		 Meant for previews: the text that crosses the limit is cut at it, and
+		 every element that is still open is closed, so the `Document` is
+		 well-formed and holds exactly this many visible characters.
+		 */
+		size_t maxVisibleChars;
+
+		/*!
+		 \brief The number of top-level blocks after which the parse stops, or
+		        0 for no limit.
+		 */
+		size_t maxBlocks;
+
+		/*!
+		 \brief Whether the inline text of paragraphs, headers and list items
+		        is left unparsed until their children are first requested.
+
+		 Blocks that are never looked into then only cost block-level
+		 scanning. See `Element::isInlineDeferred`.
+		 */
+		bool lazyInline;
+
+		/*!
+		 \brief Whether elements keep a `Utf16Index` of their text, built as
+		        the text is copied.
+
+		 Bridges to UTF-16 platforms then convert offsets in constant time;
+		 see `Element::getUtf16Offset`. Blocks from `blockCache` and the
+		 children of deferred blocks are not indexed, and scan instead.
+		 */
+		bool utf16Offsets;
+
+		/*!
+		 \brief How input that is not well-formed UTF-8 is handled.
+
+		 Unless it is `UTF8_PASS_THROUGH`, the text of every element is valid
+		 UTF-8. Offsets into the input, such as those of `Document::getOffset`,
+		 are then offsets into the repaired text.
+		 */
+		Utf8Policy utf8Policy;
+
+		/*!
+		 \brief A cache of parsed top-level blocks to share blocks with other
+		        parses, or `NULL`.
+
+		 The cache is not used while `maxNodes`, `maxOutputBytes` or
+		 `maxVisibleChars` are set, since cached blocks are not counted
+		 against them.
+		 */
+		BlockCache* blockCache;
+	};
+
+}
+
+#endif // BYPASS_PARSE_OPTIONS_H
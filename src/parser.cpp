@@ -14,7 +14,13 @@
 //  limitations under the License.
 //
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+#include "hash.h"
 #include "parser.h"
+#include "utf8.h"
 
 using namespace std;
 
@@ -32,6 +38,9 @@ static int rndr_linebreak(struct buf *ob, void *opaque);
 static int rndr_link(struct buf *ob, struct buf *link, struct buf *title, struct buf *content, void *opaque);
 static int rndr_autolink(struct buf *ob, struct buf *link, enum mkd_autolink type, void *opaque);
 static void rndr_normal_text(struct buf *ob, struct buf *text, void *opaque);
+static int rndr_halt(void *opaque);
+static int rndr_defer_inline(struct buf *ob, struct buf *text, void *opaque);
+static void rndr_source(size_t begin, size_t end, void *opaque);
 
 struct mkd_renderer mkd_callbacks = {
 	/* document-level callbacks */
@@ -66,6 +75,13 @@ struct mkd_renderer mkd_callbacks = {
 	NULL,                 // entity
 	rndr_normal_text,     // normal text
 
+	/* control callbacks */
+	rndr_halt,            // halt
+	rndr_defer_inline,    // defer inline
+
+	/* position callback */
+	rndr_source,          // source
+
 	/* renderer data */
 	64, // max stack
 	"*_~",
@@ -77,62 +93,667 @@ namespace Bypass {
 	const static std::string TWO_SPACES = "  ";
 	const static std::string NEWLINE = "\n";
 
+	// The clock is only read on every DEADLINE_CHECK_INTERVAL-th limit check
+	const static unsigned int DEADLINE_CHECK_INTERVAL = 64;
+
+	/*!
+	 \brief Inline text deferred by a `Parser`, parsed by a fresh one.
+
+	 The text may have been copied out of the lines of a list item or block
+	 quote, so it keeps where each of its runs starts relative to the
+	 top-level block, in order to place the spans it is parsed into.
+	 */
+	class DeferredInline : public InlineSource {
+	public:
+		struct Run {
+			size_t text;
+			size_t source;
+		};
+
+		DeferredInline(const std::string& text, const std::shared_ptr<const InlineReferences>& references, const std::vector<Run>& runs)
+		: InlineSource(text, references)
+		, runs(runs)
+		, begin(0)
+		, end((size_t) -1)
+		{
+
+		}
+
+		/*!
+		 \brief Sets the source range of the block that holds the text, which
+		        the parsed children are clipped to as they would be by an
+		        eager parse.
+		 */
+		void setBounds(size_t begin, size_t end) {
+			this->begin = begin;
+			this->end = end;
+		}
+	protected:
+		void parse(std::vector<Element>& children) const {
+			Parser parser;
+			parser.parseInline(children, getText(), getReferences());
+
+			for (size_t i = 0; i < children.size(); i++) {
+				place(children[i]);
+				children[i].clipSource(begin, end);
+			}
+		}
+	private:
+		std::vector<Run> runs;
+		size_t begin;
+		size_t end;
+
+		size_t toSource(size_t offset) const {
+			std::vector<Run>::const_iterator run = std::upper_bound(runs.begin(), runs.end(), offset,
+				[](size_t offset, const Run& run) { return offset < run.text; });
+
+			if (run == runs.begin()) {
+				return offset;
+			}
+
+			--run;
+			return run->source + (offset - run->text);
+		}
+
+		void place(Element& element) const {
+			size_t begin = toSource(element.sourceOffset);
+			size_t end = element.sourceLength ? toSource(element.sourceOffset + element.sourceLength - 1) + 1 : begin;
+			element.setSourceRange(begin, end - begin);
+
+			for (size_t i = 0; i < element.children.size(); i++) {
+				place(element.children[i]);
+			}
+		}
+	};
+
 	Parser::Parser()
 	: elementSoup()
+	, pending(NULL)
+	, offset(0)
+	, options()
 	{
 		elementCount = 1;
+		lastElement = 0;
+		nodeCount = 0;
+		outputBytes = 0;
+		visibleChars = 0;
+		limitChecks = 0;
+		blockCache = NULL;
+		blockContext = 0;
 	}
 
 	Parser::~Parser() {
+		finish();
+	}
+
+	Document Parser::parse(const char* mkd, const ParseOptions& options) {
+		begin(mkd, options);
+
+		while (step((size_t) -1));
+
+		return document;
+	}
 
+	Document Parser::parse(const string& markdown, const ParseOptions& options) {
+		return parse(markdown.c_str(), options);
 	}
 
-	Document Parser::parse(const char* mkd) {
+	void Parser::begin(const char* mkd, const ParseOptions& options) {
+		finish();
+		elementSoup.clear();
+		lastElement = 0;
+		lastDeferred.reset();
 		document = Document();
+		this->options = options;
+		nodeCount = 0;
+		outputBytes = 0;
+		visibleChars = 0;
+		limitChecks = 0;
+		offset = 0;
+		inlineReferences.reset();
+		blockCache = NULL;
+
+		if (options.blockCache && !options.maxNodes && !options.maxOutputBytes && !options.maxVisibleChars) {
+			blockCache = options.blockCache;
+		}
 
-		if (mkd) {
-			struct buf *ib, *ob;
+		std::string repaired;
+
+		if (mkd && options.utf8Policy != UTF8_PASS_THROUGH) {
+			size_t length = strlen(mkd);
+
+			if (findInvalidUtf8(mkd, length) < length) {
+				if (options.utf8Policy == UTF8_REJECT) {
+					document.setStatus(PARSE_INVALID_UTF8);
+					return;
+				}
+
+				repaired = repairUtf8(mkd, length);
+				mkd = repaired.c_str();
+			}
+		}
 
-			ib = bufnew(INPUT_UNIT);
+		if (mkd) {
+			struct buf *ib = bufnew(INPUT_UNIT);
 			bufputs(ib, mkd);
 
-			ob = bufnew(OUTPUT_UNIT);
+			// The callback table is copied so that parsers may be started on
+			// several threads at once.
+
+			struct mkd_renderer callbacks = mkd_callbacks;
+			callbacks.opaque = this;
+			pending = mkd_document_new(ib, &callbacks);
+			offset = mkd_document_offset(pending);
 
-			mkd_callbacks.opaque = this;
+			size_t refBegin, refEnd;
 
-			//parse and assemble document
-			markdown(ob, ib, &mkd_callbacks);
+			for (size_t i = 0; mkd_document_reference(pending, i, &refBegin, &refEnd); i++) {
+				document.referenceRanges.push_back(std::make_pair(refBegin, refEnd));
+				document.references.append(mkd + refBegin, refEnd - refBegin);
+				document.references.push_back('\n');
+			}
 
-			for (std::map<int, Element>::iterator it = elementSoup.begin(); it != elementSoup.end(); ++it) {
-				document.append(it->second);
+			if (options.lazyInline) {
+				inlineReferences = std::make_shared<const InlineReferences>(document.references);
 			}
 
+			// Cached blocks depend on the reference definitions and on whether
+			// their inline text was deferred.
+
+			blockContext = hash64(document.references.data(), document.references.size(), options.lazyInline);
+
 			bufrelease(ib);
-			bufrelease(ob);
 		}
+	}
+
+	void Parser::begin(const string& markdown, const ParseOptions& options) {
+		begin(markdown.c_str(), options);
+	}
+
+	bool Parser::step(size_t maxBytes) {
+		if (!pending) {
+			return false;
+		}
+
+		struct buf *ob = bufnew(OUTPUT_UNIT);
+		size_t consumed = 0;
+
+		// Blocks are parsed one at a time so that each one knows where it
+		// started in the input.
+
+		do {
+			size_t start = offset;
+
+			if (blockCache) {
+				stepBlock(ob, start, consumed);
+			} else {
+				consumed += mkd_document_step(ob, pending, 0);
+				ob->size = 0;
+				flushElements(start);
+			}
+
+			offset = mkd_document_offset(pending);
+		} while (consumed < maxBytes && mkd_document_remaining(pending));
+
+		bufrelease(ob);
+
+		if (mkd_document_remaining(pending) == 0) {
+			finish();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Parser::stepBlock(struct buf *ob, size_t start, size_t& consumed) {
+		const char* data;
+		size_t length = mkd_document_next(pending, &data);
+		std::vector<std::shared_ptr<const Element> > blocks;
+
+		// Source offsets are kept relative to the block, which only carries
+		// over to another copy of the text when no carriage return or
+		// reference definition was taken out of it.
+
+		bool cacheable = mkd_document_extent(pending, length) == length;
+
+		// Limits are checked as libsoldout would before a block, so that a
+		// run of cache hits cannot overrun a deadline.
+
+		if (length && cacheable && !checkLimits() && blockCache->find(data, length, blockContext, blocks)) {
+			for (size_t i = 0; i < blocks.size(); i++) {
+				document.append(blocks[i], document.nextId, start);
+			}
+
+			limitBlocks();
+			mkd_document_skip(pending, length);
+			consumed += length;
+			return;
+		}
+
+		size_t first = document.blocks.size();
+		consumed += mkd_document_step(ob, pending, 0);
+		ob->size = 0;
+		flushElements(start);
+
+		if (cacheable && document.status == PARSE_COMPLETE && document.blocks.size() > first) {
+			for (size_t i = first; i < document.blocks.size(); i++) {
+				blocks.push_back(document.blocks[i].element);
+			}
+
+			blockCache->store(data, length, blockContext, blocks);
+		}
+	}
+
+	bool Parser::stepFor(long microseconds) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool more;
 
+		do {
+			more = step(0);
+		} while (more && std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count() < microseconds);
+
+		return more;
+	}
+
+	Document& Parser::getDocument() {
 		return document;
 	}
 
-	Document Parser::parse(const string& markdown) {
-		return parse(markdown.c_str());
+	int Parser::checkLimits() {
+		if (document.getStatus() != PARSE_COMPLETE) {
+			return 1;
+		}
+
+		ParseStatus status = PARSE_COMPLETE;
+
+		if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+			status = PARSE_CANCELLED;
+		} else if (options.maxNodes && nodeCount >= options.maxNodes) {
+			status = PARSE_NODE_LIMIT_EXCEEDED;
+		} else if (options.maxOutputBytes && outputBytes >= options.maxOutputBytes) {
+			status = PARSE_OUTPUT_LIMIT_EXCEEDED;
+		} else if (options.maxVisibleChars && visibleChars >= options.maxVisibleChars) {
+			status = PARSE_VISIBLE_CHAR_LIMIT_REACHED;
+		} else if (options.maxBlocks && document.blocks.size() >= options.maxBlocks) {
+			status = PARSE_BLOCK_LIMIT_REACHED;
+		} else if (options.deadline != ParseOptions::Clock::time_point::max()
+			&& limitChecks++ % DEADLINE_CHECK_INTERVAL == 0
+			&& ParseOptions::Clock::now() >= options.deadline) {
+			status = PARSE_DEADLINE_EXCEEDED;
+		}
+
+		document.setStatus(status);
+		return status != PARSE_COMPLETE;
+	}
+
+	size_t Parser::getOffset() {
+		return offset;
+	}
+
+	size_t Parser::getOutputBytes() {
+		return outputBytes;
+	}
+
+	void Parser::finish() {
+		if (pending) {
+			mkd_document_free(pending);
+			pending = NULL;
+		}
+	}
+
+	void Parser::flushElements(size_t start) {
+		// Between top-level blocks only top-level elements are left in the
+		// soup, so they can be moved into the document for good.
+
+		for (std::map<int, Element>::iterator it = elementSoup.begin(); it != elementSoup.end(); ++it) {
+			it->second.updateHash();
+			document.append(std::make_shared<const Element>(it->second), document.nextId, start);
+		}
+
+		elementSoup.clear();
+		limitBlocks();
+	}
+
+	void Parser::limitBlocks() {
+		// A single step can produce more than one block, such as a paragraph
+		// that ends at a setext header, so the limit can be overrun here.
+
+		if (options.maxBlocks && document.blocks.size() > options.maxBlocks) {
+			document.blocks.resize(options.maxBlocks);
+			document.setStatus(PARSE_BLOCK_LIMIT_REACHED);
+		}
 	}
 
-	void Parser::eraseTrailingControlCharacters(const std::string& controlCharacters) {
+	Document Parser::reparse(const Document& previous, const EditRange& edit, const std::string& markdown, const ParseOptions& options) {
+		const std::vector<Document::Block>& blocks = previous.blocks;
+		size_t oldEnd = edit.offset + edit.removedLength;
+		size_t newEnd = edit.offset + edit.insertedLength;
+
+		// Offsets into repaired input do not line up with the edit, so input
+		// that needs repairing is parsed in full. Where a limit cuts a parse
+		// depends on every block before it, so bounded parses are too.
+
+		bool bounded = options.maxNodes || options.maxOutputBytes || options.maxVisibleChars || options.maxBlocks;
+
+		if (blocks.empty() || previous.status != PARSE_COMPLETE || newEnd > markdown.size() || bounded
+			|| touchesReferences(previous, edit, markdown) || !isValidUtf8(markdown.data(), markdown.size())) {
+			return parse(markdown, options);
+		}
+
+		// Find the block holding the edit and back up to the start of the
+		// block before it, whose extent depends on the edited lines.
+
+		size_t first = std::upper_bound(blocks.begin() + 1, blocks.end(), edit.offset,
+			[](size_t offset, const Document::Block& block) { return offset < block.offset; }) - blocks.begin() - 1;
+
+		while (first > 0 && blocks[first - 1].offset == blocks[first].offset) {
+			first--;
+		}
+
+		if (first > 0) {
+			first--;
+
+			while (first > 0 && blocks[first - 1].offset == blocks[first].offset) {
+				first--;
+			}
+		}
+
+		size_t parseStart = first > 0 ? blocks[first].offset : 0;
+		size_t window = std::max((size_t) REPARSE_UNIT, 2 * (newEnd - parseStart));
+
+		Document result;
+		result.references = previous.references;
+		result.blocks.reserve(blocks.size() + 1);
+		result.blocks.assign(blocks.begin(), blocks.begin() + first);
+
+		for (size_t i = 0; i < previous.referenceRanges.size(); i++) {
+			std::pair<size_t, size_t> range = previous.referenceRanges[i];
+
+			if (range.first >= oldEnd) {
+				range.first = range.first - edit.removedLength + edit.insertedLength;
+				range.second = range.second - edit.removedLength + edit.insertedLength;
+			}
+
+			result.referenceRanges.push_back(range);
+		}
+
+		for (;;) {
+			size_t windowEnd = std::min(markdown.size(), parseStart + window);
+			bool atEnd = windowEnd == markdown.size();
+
+			// The definitions in the window follow those of the whole
+			// document, which changes the order libsoldout finds duplicates
+			// in.
+
+			if (definesDuplicateReference(result, parseStart, windowEnd)) {
+				return parse(markdown, options);
+			}
+
+			std::string input = previous.references + markdown.substr(parseStart, windowEnd - parseStart);
+			size_t base = previous.references.size();
+			size_t settled = atEnd ? input.size() : input.rfind('\n');
+
+			result.blocks.resize(first);
+			result.nextId = previous.nextId;
+
+			begin(input, options);
+
+			for (bool more = true; more; ) {
+				size_t fresh = document.size();
+				more = step(0);
+
+				for (size_t i = fresh; i < document.size(); i++) {
+					size_t start = parseStart + document.blocks[i].offset - base;
+
+					// Once a block starts past the edit where an old block
+					// started, and its first line is complete, everything
+					// from there on parses exactly as it did before.
+
+					if (i == fresh && start >= newEnd && document.blocks[i].offset <= settled) {
+						size_t oldStart = start - edit.insertedLength + edit.removedLength;
+						size_t k = std::lower_bound(blocks.begin() + first, blocks.end(), oldStart,
+							[](const Document::Block& block, size_t offset) { return block.offset < offset; }) - blocks.begin();
+
+						if (k < blocks.size() && blocks[k].offset == oldStart) {
+							for (; k < blocks.size(); k++) {
+								Document::Block block = blocks[k];
+								block.offset = block.offset - edit.removedLength + edit.insertedLength;
+								result.blocks.push_back(block);
+							}
+
+							finish();
+							std::swap(document, result);
+							return document;
+						}
+					}
+
+					result.append(document.blocks[i].element, result.nextId, start);
+				}
+			}
+
+			// A deadline or cancellation stops the reparse where it stopped
+			// the window, as it would a full parse.
+
+			if (document.getStatus() != PARSE_COMPLETE) {
+				result.setStatus(document.getStatus());
+				std::swap(document, result);
+				return document;
+			}
+
+			if (atEnd) {
+				std::swap(document, result);
+				return document;
+			}
+
+			window *= 2;
+		}
+	}
+
+	bool Parser::touchesReferences(const Document& previous, const EditRange& edit, const std::string& markdown) {
+		size_t oldEnd = edit.offset + edit.removedLength;
+		size_t newEnd = edit.offset + edit.insertedLength;
+
+		for (size_t i = 0; i < previous.referenceRanges.size(); i++) {
+			if (previous.referenceRanges[i].first <= oldEnd && edit.offset <= previous.referenceRanges[i].second) {
+				return true;
+			}
+		}
+
+		// A definition may span three lines, so the two lines before the
+		// edit are scanned along with the edited ones.
+
+		size_t from = edit.offset;
+
+		for (int lines = 0; from > 0 && lines < 3; from--) {
+			if (markdown[from - 1] == '\n' && ++lines == 3) {
+				break;
+			}
+		}
+
+		size_t to = markdown.find('\n', newEnd);
+		to = (to == std::string::npos) ? markdown.size() : to + 1;
+
+		struct buf *ib = bufnew(INPUT_UNIT);
+		struct buf *ob = bufnew(OUTPUT_UNIT);
+		bufput(ib, markdown.data() + from, to - from);
+		mkd_references(ob, ib, ib->size);
+		bool found = ob->size > 0;
+		bufrelease(ib);
+		bufrelease(ob);
+
+		return found;
+	}
+
+	bool Parser::definesDuplicateReference(const Document& document, size_t from, size_t to) {
+		// Each definition is kept in the references of the document followed
+		// by a newline, and its id is compared without case, as libsoldout
+		// does.
+
+		std::unordered_map<std::string, size_t> counts;
+		std::vector<std::string> windowed;
+		size_t at = 0;
+
+		for (size_t i = 0; i < document.referenceRanges.size(); i++) {
+			const std::pair<size_t, size_t>& range = document.referenceRanges[i];
+			size_t length = range.second - range.first;
+			size_t open = document.references.find('[', at);
+			size_t close = document.references.find(']', open);
+			std::string id;
+
+			if (open < at + length && close < at + length) {
+				id = document.references.substr(open + 1, close - open - 1);
+				std::transform(id.begin(), id.end(), id.begin(), [](char c) {
+					return c >= 'A' && c <= 'Z' ? (char) (c - 'A' + 'a') : c;
+				});
+			}
+
+			counts[id]++;
+
+			if (range.first < to && range.second > from) {
+				windowed.push_back(id);
+			}
+
+			at += length + 1;
+		}
+
+		for (size_t i = 0; i < windowed.size(); i++) {
+			if (counts[windowed[i]] > 1) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	int Parser::deferInline(struct buf *ob, struct buf *text) {
+		if (!options.lazyInline || !inlineReferences) {
+			return 0;
+		}
+
+		// The stand-in is an empty text span carrying the source; handleBlock
+		// hands the source over to the block that contains it.
+
+		// Runs are cut wherever the text stops following the markdown, which
+		// can only happen at the start of a line.
+
+		std::vector<DeferredInline::Run> runs;
+
+		for (size_t i = 0; i < text->size; i = std::find(text->data + i, text->data + text->size, '\n') - text->data + 1) {
+			size_t position = pending ? mkd_document_position(pending, text->data + i) : (size_t) -1;
+
+			if (position == (size_t) -1 || position < offset) {
+				continue;
+			}
+
+			DeferredInline::Run run = { i, position - offset };
+
+			if (runs.empty() || run.source - runs.back().source != run.text - runs.back().text) {
+				runs.push_back(run);
+			}
+		}
+
+		Element deferred;
+		deferred.setType(TEXT);
+		lastDeferred = std::make_shared<DeferredInline>(std::string(text->data, text->size), inlineReferences, runs);
+		deferred.inlineSource = lastDeferred;
+		createSpan(deferred, ob);
+		return 1;
+	}
+
+	void Parser::parsedSource(size_t begin, size_t end) {
+		std::map<int, Element>::iterator it = elementSoup.find(lastElement);
+		lastElement = 0;
+
+		if (it == elementSoup.end() || begin < offset || end < begin) {
+			return;
+		}
+
+		Element& element = it->second;
+		element.setSourceRange(begin - offset, end - begin);
+
+		// Text runs such as the newline at the end of a list item can reach
+		// past the element that holds them.
+
+		for (size_t i = 0; i < element.children.size(); i++) {
+			element.children[i].clipSource(begin - offset, end - offset);
+		}
+
+		if (element.inlineSource && element.inlineSource == lastDeferred) {
+			lastDeferred->setBounds(begin - offset, end - offset);
+		}
+
+		// The text of a code block is copied out of its lines, so it is given
+		// the extent of the block.
+
+		if (element.type == BLOCK_CODE && element.children.size() == 1) {
+			element.children[0].setSourceRange(begin - offset, end - begin);
+		}
+	}
+
+	void Parser::parseInline(std::vector<Element>& children, const std::string& text, const std::string& references) {
+		struct mkd_renderer callbacks = mkd_callbacks;
+		callbacks.opaque = this;
+
+		struct buf *ib = bufnew(INPUT_UNIT);
+		struct buf *rb = bufnew(INPUT_UNIT);
+		struct buf *ob = bufnew(OUTPUT_UNIT);
+		bufput(ib, text.data(), text.size());
+		bufput(rb, references.data(), references.size());
+		mkd_inline(ob, ib, rb, &callbacks);
+
+		std::vector<std::string> strs;
+		split(strs, std::string(ob->data, ob->data + ob->size), '|');
+
+		for (std::vector<std::string>::iterator it = strs.begin(); it != strs.end(); it++) {
+			std::map<int, Element>::iterator elit = elementSoup.find(atoi((*it).c_str()));
+
+			if (elit != elementSoup.end()) {
+				children.push_back(elit->second);
+				children.back().updateHash();
+				elementSoup.erase(elit);
+			}
+		}
+
+		bufrelease(ib);
+		bufrelease(rb);
+		bufrelease(ob);
+	}
+
+	bool Parser::eraseTrailingControlCharacters(const std::string& controlCharacters) {
 		std::map<int, Element>::iterator it = elementSoup.find(elementCount);
 
 		if ( it != elementSoup.end() ) {
 			Element *element = &((*it).second);
 			size_t pos = element->text.size() - controlCharacters.size();
 
-			if (element->text.substr(pos, string::npos) == controlCharacters) {
+			if (element->text.size() >= controlCharacters.size()
+				&& element->text.substr(pos, string::npos) == controlCharacters) {
 				element->text.erase(pos, string::npos);
+
+				if (element->sourceLength >= controlCharacters.size()) {
+					element->sourceLength -= controlCharacters.size();
+				}
+
+				if (element->utf16) {
+					std::shared_ptr<Utf16Index> index = std::make_shared<Utf16Index>(*element->utf16);
+					index->truncate(element->text.data(), element->text.size());
+					element->utf16 = index;
+				}
+
+				return true;
 			}
 		}
+
+		return false;
 	}
 
 	// Block Element Callbacks
 
+	static bool isDeferred(Element& element) {
+		return element.getType() == TEXT && element.isInlineDeferred();
+	}
+
 	void Parser::handleBlock(Type type, struct buf *ob, struct buf *text, int extra) {
 		Element block;
 		block.setType(type);
@@ -141,6 +762,7 @@ namespace Bypass {
 			char levelStr[2];
 			snprintf(levelStr, 2, "%d", extra);
 			block.addAttribute("level", levelStr);
+			outputBytes += 1;
 		}
 
 		std::string textString(text->data, text->data + text->size);
@@ -157,7 +779,30 @@ namespace Bypass {
 			}
 		}
 
+		// A block whose only child stands in for deferred inline text takes
+		// the deferred text over; mixed with other children it is parsed now.
+
+		if (block.children.size() == 1 && isDeferred(block.children[0])) {
+			block.inlineSource = block.children[0].inlineSource;
+			block.children.clear();
+		} else if (options.lazyInline) {
+			std::vector<Element> children;
+
+			for (size_t i = 0; i < block.children.size(); i++) {
+				if (isDeferred(block.children[i])) {
+					const std::vector<Element>& spans = block.children[i].inlineSource->getChildren();
+					children.insert(children.end(), spans.begin(), spans.end());
+				} else {
+					children.push_back(block.children[i]);
+				}
+			}
+
+			block.children.swap(children);
+		}
+
 		elementCount++;
+		nodeCount++;
+		lastElement = elementCount;
 
 		std::ostringstream oss;
 		oss << elementCount;
@@ -179,13 +824,20 @@ namespace Bypass {
 
 	void Parser::parsedBlockCode(struct buf *ob, struct buf *text) {
 		if(!text) return; // Analyze seems to believe that text can be null here
+		int textElement = elementCount;
 		parsedNormalText(ob, text);
-		eraseTrailingControlCharacters(NEWLINE);
-
-		std::ostringstream oss;
-		oss << elementCount << '|';
 		bufreset(text);
-		bufputs(text, oss.str().c_str());
+
+		// No text element is made once the visible character limit is hit.
+
+		if (elementCount != textElement) {
+			eraseTrailingControlCharacters(NEWLINE);
+
+			std::ostringstream oss;
+			oss << elementCount << '|';
+			bufputs(text, oss.str().c_str());
+		}
+
 		handleBlock(BLOCK_CODE, ob, text);
 	}
 
@@ -224,7 +876,17 @@ namespace Bypass {
             Element element;
 			element.setType(type);
             element.setText(textString);
+
+			// The text of an autolink is visible, and is cut like any other;
+			// the link keeps the whole address.
+
+			if (!takeVisible(element.text)) {
+				return;
+			}
+
             element.addAttribute("link", textString);
+            outputBytes += textString.size();
+            indexUtf16(element);
 
 			createSpan(element, ob);
 		} else if (strs.size() > 0) {
@@ -240,16 +902,19 @@ namespace Bypass {
                 if (element.getType() == LINK) {
                     if (extra != NULL && extra->size) {
                         element.addAttribute("link", std::string(extra->data, extra->data + extra->size));
+                        outputBytes += extra->size;
                     }
 
                     if (extra2 != NULL && extra2->size) {
                         element.addAttribute("title", std::string(extra2->data, extra2->data + extra2->size));
+                        outputBytes += extra2->size;
                     }
                 }
 
 				elementSoup.erase(pos);
 				if (output) {
 					elementSoup[pos] = element;
+					lastElement = pos;
 				}
 			}
 
@@ -267,6 +932,9 @@ namespace Bypass {
 
 	void Parser::createSpan(const Element& element, struct buf *ob) {
 		elementCount++;
+		nodeCount++;
+		lastElement = elementCount;
+		outputBytes += element.text.size();
 		std::ostringstream oss;
 		oss << elementCount;
 		elementSoup[elementCount] = element;
@@ -322,13 +990,23 @@ namespace Bypass {
 			Element codeSpan;
 			codeSpan.setType(CODE_SPAN);
 			codeSpan.text.assign(text->data, text->data + text->size);
-			createSpan(codeSpan, ob);
+
+			if (takeVisible(codeSpan.text)) {
+				indexUtf16(codeSpan);
+				createSpan(codeSpan, ob);
+			}
 		}
 		return 1;
 	}
 
 	int Parser::parsedLinebreak(struct buf *ob) {
-		eraseTrailingControlCharacters(TWO_SPACES);
+		// The spaces that mark a line break were counted as visible, so they
+		// go back to the budget once they are erased.
+
+		if (eraseTrailingControlCharacters(TWO_SPACES) && options.maxVisibleChars) {
+			visibleChars -= std::min(visibleChars, TWO_SPACES.size());
+		}
+
 		handleSpan(LINEBREAK, ob, NULL);
 		return 1;
 	}
@@ -343,10 +1021,53 @@ namespace Bypass {
 			Element normalText;
 			normalText.setType(TEXT);
 			normalText.text.assign(text->data, text->data + text->size);
-			createSpan(normalText, ob);
+
+			if (takeVisible(normalText.text)) {
+				indexUtf16(normalText);
+				createSpan(normalText, ob);
+			}
+		}
+	}
+
+	void Parser::indexUtf16(Element& element) {
+		if (options.utf16Offsets) {
+			element.utf16 = std::make_shared<const Utf16Index>(element.text.data(), element.text.size());
 		}
 	}
 
+	bool Parser::takeVisible(std::string& text) {
+		if (!options.maxVisibleChars) {
+			return true;
+		}
+
+		// Characters are counted as UTF-8 sequences, and text that crosses
+		// the limit is cut at a character boundary. Newlines do not count.
+		// Cutting text stops the parse here rather than at the next check,
+		// which libsoldout skips after the last run of a block.
+
+		size_t i = 0;
+
+		for (; i < text.size(); i++) {
+			if ((text[i] & 0xC0) != 0x80 && text[i] != '\n') {
+				if (visibleChars == options.maxVisibleChars) {
+					break;
+				}
+
+				visibleChars++;
+			}
+		}
+
+		if (i < text.size()) {
+			text.erase(i);
+
+			if (document.status == PARSE_COMPLETE) {
+				document.setStatus(PARSE_VISIBLE_CHAR_LIMIT_REACHED);
+			}
+		}
+
+		return !text.empty();
+	}
+
 }
 
 // Block Element callbacks
@@ -411,3 +1132,19 @@ static void rndr_normal_text(struct buf *ob, struct buf *text, void *opaque) {
 	return ((Bypass::Parser*) opaque)->parsedNormalText(ob, text);
 }
 
+//	Control Callbacks
+
+static int rndr_halt(void *opaque) {
+	return ((Bypass::Parser*) opaque)->checkLimits();
+}
+
+static int rndr_defer_inline(struct buf *ob, struct buf *text, void *opaque) {
+	return ((Bypass::Parser*) opaque)->deferInline(ob, text);
+}
+
+//	Position Callbacks
+
+static void rndr_source(size_t begin, size_t end, void *opaque) {
+	((Bypass::Parser*) opaque)->parsedSource(begin, end);
+}
+
@@ -24,8 +24,10 @@
 #include <cstdio>
 #include <cstdlib>
 #include <map>
+#include "block_cache.h"
 #include "document.h"
 #include "element.h"
+#include "parse_options.h"
 
 extern "C" {
 #include "soldout/markdown.h"
@@ -36,9 +38,22 @@ extern "C" {
 
 #define INPUT_UNIT 1024
 #define OUTPUT_UNIT 64
+#define REPARSE_UNIT 4096
 
 namespace Bypass {
 
+	/*!
+	 \brief Describes an edit made to markdown that has already been parsed.
+
+	 The edit replaced `removedLength` bytes at `offset` in the previous
+	 markdown with `insertedLength` bytes in the new markdown.
+	 */
+	struct EditRange {
+		size_t offset;
+		size_t removedLength;
+		size_t insertedLength;
+	};
+
 	/*!
      \brief A parser that converts textual markdown into a Document object.
 
@@ -73,20 +88,119 @@ namespace Bypass {
 		 */
 		~Parser();
 
+		Parser(const Parser&) = delete;
+		Parser& operator=(const Parser&) = delete;
+
 		/*!
 		 \brief Parses the given markdown into a `Document`.
 		 \param markdown The textual representation of the markdown as a character
 		                 array.
-		 \return A `Document` object that represents the supplied markdown.
+		 \param options The limits that bound the parse.
+		 \return A `Document` object that represents the supplied markdown. Its
+		         status tells whether or not one of the limits was hit.
 		 */
-		Document parse(const char* markdown);
+		Document parse(const char* markdown, const ParseOptions& options = ParseOptions());
 
 		/*!
 		 \brief Parses the given markdown into a `Document`.
 		 \param markdown The textual representation of the markdown as a string.
+		 \param options The limits that bound the parse.
+		 \return A `Document` object that represents the supplied markdown. Its
+		         status tells whether or not one of the limits was hit.
+		 */
+		Document parse(const std::string &markdown, const ParseOptions& options = ParseOptions());
+
+		/*!
+		 \brief Parses markdown that differs from a previously parsed `Document`
+		        by a single edit.
+
+		 Only the top-level blocks around the edit are parsed again: parsing
+		 starts one block before the edit, so that list and block quote
+		 continuations are picked up, and stops as soon as a block starts at the
+		 same place it did before the edit. Every other block is shared with
+		 `previous`, keeping its identifier and its storage. Edits that touch a
+		 reference definition fall back to a full parse, as do bounded parses
+		 and those that would parse again a definition of an id defined more
+		 than once, since which of the duplicates wins depends on all of them.
+
+		 \param previous The `Document` parsed from the markdown before the edit.
+		 \param edit The edit that was made.
+		 \param markdown The whole markdown after the edit.
+		 \param options The options `previous` was parsed with, which the
+		                blocks parsed again are parsed with too.
 		 \return A `Document` object that represents the supplied markdown.
 		 */
-		Document parse(const std::string &markdown);
+		Document reparse(const Document& previous, const EditRange& edit, const std::string& markdown, const ParseOptions& options = ParseOptions());
+
+		/*!
+		 \brief Starts a resumable parse of the given markdown.
+
+		 Only the reference pass runs here; blocks are parsed by subsequent
+		 calls to `step` or `stepFor`, so that parsing can be interleaved with
+		 other work on the calling thread. Any parse that is still in progress
+		 is discarded.
+
+		 \param markdown The textual representation of the markdown as a character
+		                 array.
+		 \param options The limits that bound the whole parse, across steps.
+		 */
+		void begin(const char* markdown, const ParseOptions& options = ParseOptions());
+
+		/*!
+		 \brief Starts a resumable parse of the given markdown.
+		 \param markdown The textual representation of the markdown as a string.
+		 \param options The limits that bound the whole parse, across steps.
+		 */
+		void begin(const std::string &markdown, const ParseOptions& options = ParseOptions());
+
+		/*!
+		 \brief Parses whole top-level blocks until at least `maxBytes` of input
+		        have been consumed.
+
+		 At least one block is parsed per call. Completed blocks are appended to
+		 the `Document` returned by `getDocument` before this returns.
+
+		 \param maxBytes The number of input bytes to consume in this slice.
+		 \return Whether or not there is input left to parse.
+		 */
+		bool step(size_t maxBytes);
+
+		/*!
+		 \brief Parses whole top-level blocks until the given time budget has
+		        been spent.
+
+		 The budget is checked between blocks, so a single large block may
+		 overrun it.
+
+		 \param microseconds The time budget for this slice.
+		 \return Whether or not there is input left to parse.
+		 */
+		bool stepFor(long microseconds);
+
+		/*!
+		 \brief Gets the `Document` built so far by `begin` and `step`.
+
+		 Between steps the `Document` holds every completed top-level block.
+		 Once `step` returns false it is identical to the result of `parse`.
+
+		 \return The `Document` under construction.
+		 */
+		Document& getDocument();
+
+		/*!
+		 \brief Indicates how far a parse started with `begin` has got.
+		 \return The offset in the input markdown of the first byte that has
+		         not been parsed yet, ie. the start of the next top-level block.
+		 */
+		size_t getOffset();
+
+		/*!
+		 \brief Indicates how much output a parse started with `begin` has
+		        produced.
+		 \return The number of bytes of element text and attributes produced
+		         so far, as counted against `ParseOptions::maxOutputBytes`.
+		 */
+		size_t getOutputBytes();
 
 		/*!
 		 \brief Populates the given `tokens` with the result of splitting the
@@ -285,6 +399,48 @@ namespace Bypass {
 		 */
 		void parsedNormalText(struct buf *ob, struct buf *text);
 
+		// Control Callbacks
+
+		/*!
+		 \brief Checks the limits given in `ParseOptions`.
+
+		 This is called by libsoldout at every block and span boundary, so it is
+		 kept cheap: the clock is only read once every few dozen calls. The first
+		 limit that is hit is recorded as the status of the `Document`.
+
+		 \return whether or not the parse should stop
+		 */
+		int checkLimits();
+
+		/*!
+		 \brief Handles the inline text of a block when `ParseOptions::lazyInline`
+		        is set, by standing in a deferred element for its children.
+
+		 \param ob The designated output buffer.
+		 \param text The unparsed inline text.
+		 \return whether or not the inline text was deferred
+		 */
+		int deferInline(struct buf *ob, struct buf *text);
+
+		// Position Callbacks
+
+		/*!
+		 \brief Handles the input range of the block, span or text that
+		        libsoldout has just rendered, by recording it on the element
+		        that was made for it.
+		 \param begin The offset of the first byte in the input.
+		 \param end The offset past the last byte in the input.
+		 */
+		void parsedSource(size_t begin, size_t end);
+
+		/*!
+		 \brief Parses the inline text of a single block.
+		 \param children Receives the span elements of the block.
+		 \param text The inline markdown of the block.
+		 \param references The reference definitions the text may use.
+		 */
+		void parseInline(std::vector<Element>& children, const std::string& text, const std::string& references);
+
 		// Debugging
 
 		void printBuf(struct buf *b);
@@ -293,10 +449,30 @@ namespace Bypass {
 		Document document;
 		std::map<int, Element> elementSoup;
 		int elementCount;
+		int lastElement;
+		struct mkd_document *pending;
+		size_t offset;
+		ParseOptions options;
+		size_t nodeCount;
+		size_t outputBytes;
+		size_t visibleChars;
+		unsigned int limitChecks;
+		std::shared_ptr<const InlineReferences> inlineReferences;
+		std::shared_ptr<DeferredInline> lastDeferred;
+		BlockCache* blockCache;
+		uint64_t blockContext;
+		void finish();
+		void stepBlock(struct buf *ob, size_t start, size_t& consumed);
+		void flushElements(size_t start);
+		void limitBlocks();
+		bool touchesReferences(const Document& previous, const EditRange& edit, const std::string& markdown);
+		bool definesDuplicateReference(const Document& document, size_t from, size_t to);
 		void handleBlock(Type, struct buf *ob, struct buf *text, int extra = -1);
 		void handleSpan(Type, struct buf *ob, struct buf *text, struct buf *extra = NULL, struct buf *extra2 = NULL, bool output = true);
 		void createSpan(const Element&, struct buf *ob);
-		void eraseTrailingControlCharacters(const std::string& controlCharacters);
+		bool takeVisible(std::string& text);
+		void indexUtf16(Element& element);
+		bool eraseTrailingControlCharacters(const std::string& controlCharacters);
 	};
 
 }
@@ -0,0 +1,244 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <algorithm>
+#include <cstring>
+#include "basic_parser.h"
+#include "builders.h"
+#include "plain_text.h"
+
+namespace Bypass {
+
+	const size_t PlainText::NO_NODE;
+
+	/*!
+	 \brief Projects each top-level block into a `PlainText` as it is parsed.
+
+	 The runs of a block are looked up in the markdown once the next block,
+	 or the end of the input, says where the block ends.
+	 */
+	class PlainTextBuilder : public RecordBuilder {
+	public:
+		PlainTextBuilder(PlainText& plainText, const char* source, size_t sourceLength);
+
+		void parsedTopLevel(struct buf *ob, size_t offset);
+
+		/*!
+		 \brief Maps the runs of the last block, once the parse is over.
+		 */
+		void finish();
+	private:
+		PlainText& plainText;
+		const char* source;
+		size_t sourceLength;
+		size_t cursor;
+		size_t unmapped;
+		void project(const Record& record, size_t parent);
+		void map(size_t end);
+	};
+
+	PlainTextBuilder::PlainTextBuilder(PlainText& plainText, const char* source, size_t sourceLength)
+	: plainText(plainText)
+	, source(source)
+	{
+		this->sourceLength = sourceLength;
+		cursor = 0;
+		unmapped = 0;
+	}
+
+	void PlainTextBuilder::parsedTopLevel(struct buf *ob, size_t offset) {
+		map(offset);
+		cursor = std::max(cursor, offset);
+
+		const char* at = ob->data;
+		const char* end = ob->data + ob->size;
+		Record record;
+
+		while (at < end) {
+			at = readRecord(at, end, record);
+			project(record, PlainText::NO_NODE);
+		}
+	}
+
+	void PlainTextBuilder::finish() {
+		map(sourceLength);
+	}
+
+	void PlainTextBuilder::project(const Record& record, size_t parent) {
+		std::string& text = plainText.text;
+		size_t index = plainText.nodes.size();
+		PlainText::Node node;
+		node.type = record.tag == 'T' ? TEXT : record.type;
+		node.parent = parent;
+		plainText.nodes.push_back(node);
+
+		if (record.tag != 'B') {
+			TextView visible = node.type == LINEBREAK ? TextView("\n", 1) : record.text;
+
+			if (visible.length > 0) {
+				PlainText::Run run = { text.size(), visible.length, index };
+				plainText.nodeRuns.push_back(run);
+				text.append(visible.data, visible.length);
+			}
+
+			return;
+		}
+
+		const char* at = record.content;
+		Record child;
+
+		while (at < record.contentEnd) {
+			at = readRecord(at, record.contentEnd, child);
+			project(child, index);
+		}
+
+		if (!text.empty() && text[text.size() - 1] != '\n') {
+			text += '\n';
+		}
+	}
+
+	// Looks up each line of the node runs not yet mapped, in order, between
+	// the cursor and the end of their block.
+	void PlainTextBuilder::map(size_t end) {
+		const std::string& text = plainText.text;
+		end = std::min(end, sourceLength);
+
+		for (; unmapped < plainText.nodeRuns.size(); unmapped++) {
+			const PlainText::Run& run = plainText.nodeRuns[unmapped];
+			size_t line = run.offset;
+			size_t runEnd = run.offset + run.length;
+
+			while (line < runEnd) {
+				const char* newline = static_cast<const char*>(memchr(text.data() + line, '\n', runEnd - line));
+				size_t lineEnd = newline ? newline - text.data() : runEnd;
+
+				if (lineEnd > line && cursor < end) {
+					const char* found = std::search(source + cursor, source + end, text.data() + line, text.data() + lineEnd);
+
+					if (found != source + end) {
+						PlainText::Run mapped = { line, lineEnd - line, (size_t) (found - source) };
+						plainText.sourceRuns.push_back(mapped);
+						cursor = mapped.target + mapped.length;
+					}
+				}
+
+				line = lineEnd + 1;
+			}
+		}
+	}
+
+	PlainText::PlainText()
+	: text()
+	, nodes()
+	, nodeRuns()
+	, sourceRuns()
+	{
+
+	}
+
+	PlainText PlainText::parse(const char* markdown) {
+		PlainText plainText;
+
+		if (!markdown) {
+			return plainText;
+		}
+
+		size_t length = strlen(markdown);
+		plainText.text.reserve(length + 1);
+
+		PlainTextBuilder builder(plainText, markdown, length);
+		BasicParser<PlainTextBuilder>(builder).parse(markdown);
+		builder.finish();
+		return plainText;
+	}
+
+	PlainText PlainText::parse(const std::string& markdown) {
+		return parse(markdown.c_str());
+	}
+
+	bool PlainText::startsAfter(size_t offset, const Run& run) {
+		return offset < run.offset;
+	}
+
+	bool PlainText::targetsAfter(size_t target, const Run& run) {
+		return target < run.target;
+	}
+
+	const std::string& PlainText::getText() const {
+		return text;
+	}
+
+	size_t PlainText::getNodeCount() const {
+		return nodes.size();
+	}
+
+	Type PlainText::getNodeType(size_t node) const {
+		return nodes.at(node).type;
+	}
+
+	size_t PlainText::getNodeParent(size_t node) const {
+		return nodes.at(node).parent;
+	}
+
+	size_t PlainText::getNode(size_t offset, size_t* nodeOffset) const {
+		std::vector<Run>::const_iterator it = std::upper_bound(nodeRuns.begin(), nodeRuns.end(), offset, startsAfter);
+
+		if (it == nodeRuns.begin() || offset >= (it - 1)->offset + (it - 1)->length) {
+			return NO_NODE;
+		}
+
+		--it;
+
+		if (nodeOffset) {
+			*nodeOffset = offset - it->offset;
+		}
+
+		return it->target;
+	}
+
+	size_t PlainText::getTextOffset(size_t node) const {
+		std::vector<Run>::const_iterator it = std::upper_bound(nodeRuns.begin(), nodeRuns.end(), node, targetsAfter);
+
+		if (it == nodeRuns.begin() || (it - 1)->target != node) {
+			return std::string::npos;
+		}
+
+		return (it - 1)->offset;
+	}
+
+	size_t PlainText::getSourceOffset(size_t offset) const {
+		std::vector<Run>::const_iterator it = std::upper_bound(sourceRuns.begin(), sourceRuns.end(), offset, startsAfter);
+
+		if (it == sourceRuns.begin()) {
+			return 0;
+		}
+
+		--it;
+		return it->target + std::min(offset - it->offset, it->length);
+	}
+
+	size_t PlainText::getOffset(size_t sourceOffset) const {
+		std::vector<Run>::const_iterator it = std::upper_bound(sourceRuns.begin(), sourceRuns.end(), sourceOffset, targetsAfter);
+
+		if (it != sourceRuns.begin() && sourceOffset < (it - 1)->target + (it - 1)->length) {
+			--it;
+			return it->offset + sourceOffset - it->target;
+		}
+
+		return it == sourceRuns.end() ? text.size() : it->offset;
+	}
+
+}
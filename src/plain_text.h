@@ -0,0 +1,136 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_PLAIN_TEXT_H
+#define BYPASS_PLAIN_TEXT_H
+
+#include <string>
+#include <vector>
+#include "element.h"
+
+namespace Bypass {
+
+	class PlainTextBuilder;
+
+	/*!
+	 \brief The visible text of a markdown document, with maps back to the
+	        nodes that hold it and to the markdown it came from.
+
+	 The text is the text of every node in document order. A line break
+	 becomes a newline, and so does the end of every block that does not
+	 already end with one. Nodes are numbered in document order, each
+	 before its descendants, as in `FlatBuilder`. Entities such as `&amp;`
+	 are kept as written, as they are by `Parser`, so text that is shown or
+	 spoken has to decode them first.
+
+	 Offsets map to sources through the runs of text found verbatim in the
+	 markdown; a run ends at each newline, so indented lines of list items,
+	 quotes and code still map exactly. Markup, separators, and text that
+	 the parser rewrote fall between runs. Every lookup is a binary search
+	 over the runs.
+	 */
+	class PlainText {
+	public:
+		static const size_t NO_NODE = (size_t) -1;
+
+		PlainText();
+
+		/*!
+		 \brief Parses markdown into its plain text.
+		 \param markdown The textual representation of the markdown as a
+		                 character array.
+		 */
+		static PlainText parse(const char* markdown);
+
+		/*!
+		 \brief Parses markdown into its plain text.
+		 \param markdown The textual representation of the markdown as a string.
+		 */
+		static PlainText parse(const std::string& markdown);
+
+		/*!
+		 \brief Gets the visible text.
+		 */
+		const std::string& getText() const;
+
+		size_t getNodeCount() const;
+		Type getNodeType(size_t node) const;
+
+		/*!
+		 \brief Gets the parent of a node, or `NO_NODE` for a top-level block.
+		 */
+		size_t getNodeParent(size_t node) const;
+
+		/*!
+		 \brief Gets the node whose text holds the given offset.
+		 \param offset An offset into the visible text.
+		 \param nodeOffset Receives the offset into the text of the node, if
+		                   not NULL.
+		 \return The node, or `NO_NODE` for a separator or an offset past the
+		         end.
+		 */
+		size_t getNode(size_t offset, size_t* nodeOffset = NULL) const;
+
+		/*!
+		 \brief Gets where the text of a node starts in the visible text.
+		 \return The offset, or `std::string::npos` when the node has no text.
+		 */
+		size_t getTextOffset(size_t node) const;
+
+		/*!
+		 \brief Maps an offset into the visible text to the markdown.
+		 \return The offset of the same byte in the markdown. An offset that
+		         falls between runs maps to the end of the run before it.
+		 */
+		size_t getSourceOffset(size_t offset) const;
+
+		/*!
+		 \brief Maps an offset into the markdown to the visible text.
+		 \return The offset of the same byte in the visible text. A source
+		         offset that falls between runs, such as markup, maps to the
+		         start of the run after it, or to the end of the text.
+		 */
+		size_t getOffset(size_t sourceOffset) const;
+	private:
+		friend class PlainTextBuilder;
+
+		struct Node {
+			Type type;
+			size_t parent;
+		};
+
+		// A range of the visible text and what it maps to: a node, or the
+		// offset of the same bytes in the markdown.
+		struct Run {
+			size_t offset;
+			size_t length;
+			size_t target;
+		};
+
+		std::string text;
+		std::vector<Node> nodes;
+		std::vector<Run> nodeRuns;
+		std::vector<Run> sourceRuns;
+
+		// Orders runs by where they start in the visible text, or by their
+		// target.
+		static bool startsAfter(size_t offset, const Run& run);
+		static bool targetsAfter(size_t target, const Run& run);
+	};
+
+}
+
+#endif // BYPASS_PLAIN_TEXT_H
@@ -0,0 +1,66 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <memory>
+#include "progressive_parser.h"
+
+namespace Bypass {
+
+	ProgressiveParser::ProgressiveParser(const Executor& executor)
+	: executor(executor)
+	{
+
+	}
+
+	ProgressiveParser::~ProgressiveParser() {
+
+	}
+
+	Document ProgressiveParser::parse(const std::string& markdown, size_t maxBlocks, size_t maxOutputBytes,
+		const Completion& completion, const ParseOptions& options) {
+		// The parser is handed over to the background task, which is the only
+		// one to touch it once this returns.
+
+		std::shared_ptr<Parser> parser = std::make_shared<Parser>();
+		parser->begin(markdown, options);
+
+		bool more = true;
+
+		while (more && parser->getDocument().size() < maxBlocks && parser->getOutputBytes() < maxOutputBytes) {
+			more = parser->step(0);
+		}
+
+		Document first = parser->getDocument();
+		size_t firstCount = first.blocks.size();
+
+		executor([parser, firstCount, completion]() {
+			while (parser->step((size_t) -1));
+
+			const Document& document = parser->getDocument();
+			Document rest;
+			rest.status = document.status;
+			rest.references = document.references;
+			rest.referenceRanges = document.referenceRanges;
+			rest.blocks.assign(document.blocks.begin() + firstCount, document.blocks.end());
+			rest.nextId = document.nextId;
+
+			completion(rest);
+		});
+
+		return first;
+	}
+
+}
@@ -0,0 +1,93 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_PROGRESSIVE_PARSER_H
+#define BYPASS_PROGRESSIVE_PARSER_H
+
+#include <functional>
+#include <string>
+#include "document.h"
+#include "parser.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief A parser that returns the first screen of a document right away
+	        and parses the rest in the background.
+
+	 The reference pass runs over the whole input before any block is parsed,
+	 so links in the first blocks resolve against definitions found anywhere
+	 in the input. The blocks of the first `Document` are shared, not copied,
+	 with the full document the background parse builds.
+	 */
+	class ProgressiveParser {
+	public:
+
+		/*!
+		 \brief Runs a task on some other thread, eg. by posting it to a queue
+		        or a thread pool.
+		 */
+		typedef std::function<void(const std::function<void()>& task)> Executor;
+
+		/*!
+		 \brief Receives the blocks that followed the first screen, once they
+		        have all been parsed.
+
+		 The `Document` holds only the appended blocks, with identifiers and
+		 offsets continuing those of the first screen. Its status tells
+		 whether the parse ran to completion.
+		 */
+		typedef std::function<void(const Document& rest)> Completion;
+
+		/*!
+		 \brief Creates a `ProgressiveParser` that parses in the background on
+		        the given executor.
+		 \param executor The executor to run the background parse on.
+		 */
+		ProgressiveParser(const Executor& executor);
+
+		/*!
+		 \brief Destroys the `ProgressiveParser`. Background parses that are
+		        under way carry on.
+		 */
+		~ProgressiveParser();
+
+		/*!
+		 \brief Parses the first screen of the given markdown and hands the
+		        rest of it to the executor.
+
+		 Whole top-level blocks are parsed until at least `maxBlocks` blocks or
+		 `maxOutputBytes` bytes of text and attributes have been produced,
+		 whichever comes first. `completion` is always called on the executor,
+		 even when the first screen covers the whole input.
+
+		 \param markdown The textual representation of the markdown as a string.
+		 \param maxBlocks The number of top-level blocks in the first screen.
+		 \param maxOutputBytes The amount of output in the first screen.
+		 \param completion Called with the remaining blocks.
+		 \param options The limits that bound the whole parse, across threads.
+		 \return The `Document` holding the first screen.
+		 */
+		Document parse(const std::string& markdown, size_t maxBlocks, size_t maxOutputBytes,
+			const Completion& completion, const ParseOptions& options = ParseOptions());
+
+	private:
+		Executor executor;
+	};
+
+}
+
+#endif // BYPASS_PROGRESSIVE_PARSER_H
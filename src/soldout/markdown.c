@@ -56,7 +56,46 @@ struct render {
 	struct mkd_renderer	make;
 	struct array		refs;
 	char_trigger		active_char[256];
-	struct parray		work; };
+	struct parray		work;
+	int			halted;
+	int			measure;	/* only looking for extents */
+	const struct buf *	origin;	/* text source positions point into */
+	const struct array *	lines;	/* its line map, 0 when in step */
+	size_t			input_size;
+	struct array		src; };	/* runs copied out of the origin */
+
+
+/* src_map • where a run of a copied block body comes from in the origin */
+/*	runs of one copy are consecutive, sorted, and share their first index */
+struct src_map {
+	const char *	base;	/* start of the copy, once it is complete */
+	size_t		off;	/* offset of the run in the copy */
+	size_t		size;
+	size_t		text;	/* offset of the run in the origin */
+	size_t		group; };	/* index of the first run of the copy */
+
+
+/* line_map • where a run of the reference-stripped copy starts in the input */
+struct line_map {
+	size_t	text;
+	size_t	input; };
+
+
+/* ref_line • input range of a reference definition */
+struct ref_line {
+	size_t	beg;
+	size_t	end; };
+
+
+/* mkd_document • a render in progress over a reference-stripped copy */
+struct mkd_document {
+	struct render	rndr;
+	struct buf *	text;
+	size_t		beg;
+	struct array	lines;
+	struct array	ref_lines;
+	size_t		input_size;
+	struct render *	measure; };
 
 
 /* html_tag • structure for quick HTML tag search (inspired from discount) */
@@ -209,6 +248,127 @@ release_work_buffer(struct render *rndr, struct buf *buf) {
 
 
 
+/* src_text • offset in the origin of a char, or (size_t)-1 if not from it */
+/*	only the first n runs are searched, latest copies first since an */
+/*	in-place copy shadows the bytes it was moved over */
+static size_t
+src_text(struct render *rndr, const char *p, size_t n) {
+	struct src_map *sm = rndr->src.base;
+	size_t first, lo, hi, mid, rel;
+
+	while (n > 0) {
+		first = sm[n - 1].group;
+		if (p >= sm[first].base) {
+			rel = p - sm[first].base;
+			lo = first;
+			hi = n;
+			while (lo < hi) {
+				mid = lo + (hi - lo) / 2;
+				if (sm[mid].off <= rel) lo = mid + 1;
+				else hi = mid; }
+			if (lo > first && rel < sm[lo - 1].off + sm[lo - 1].size)
+				return sm[lo - 1].text + (rel - sm[lo - 1].off); }
+		n = first; }
+	if (!rndr->origin || p < rndr->origin->data
+	|| p >= rndr->origin->data + rndr->origin->size)
+		return (size_t)-1;
+	return p - rndr->origin->data; }
+
+
+/* push_src • records that size bytes at offset off of a copy come from src */
+/*	the copy has to be rebased before its runs are searched */
+static void
+push_src(struct render *rndr, size_t group, size_t off,
+				const char *src, size_t size) {
+	struct src_map *sm;
+	size_t text;
+
+	if (!size || (text = src_text(rndr, src, group)) == (size_t)-1)
+		return;
+	sm = arr_item(&rndr->src, arr_newitem(&rndr->src));
+	if (!sm) return;
+	sm->base = 0;
+	sm->off = off;
+	sm->size = size;
+	sm->text = text;
+	sm->group = group; }
+
+
+/* rebase_src • sets where the copy whose runs start at group now lies */
+static void
+rebase_src(struct render *rndr, size_t group, const char *base) {
+	struct src_map *sm = rndr->src.base;
+	size_t i;
+	for (i = group; i < (size_t)rndr->src.size; i += 1)
+		sm[i].base = base; }
+
+
+/* text_input • input offset of an offset into the reference-stripped copy */
+static size_t
+text_input(const struct array *lines, size_t text) {
+	struct line_map *lm = lines->base;
+	int lo = 0, hi = lines->size, mid;
+
+	/* binary search of the last run starting at or before text */
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (lm[mid].text <= text) lo = mid + 1;
+		else hi = mid; }
+	if (lo > 0) return lm[lo - 1].input + (text - lm[lo - 1].text);
+	return text; }
+
+
+/* origin_input • input offset of an offset into the origin */
+static size_t
+origin_input(struct render *rndr, size_t text) {
+	if (rndr->lines) text = text_input(rndr->lines, text);
+	return (text < rndr->input_size) ? text : rndr->input_size; }
+
+
+/* src_input • input offset of a char, or (size_t)-1 if not from the input */
+static size_t
+src_input(struct render *rndr, const char *p) {
+	size_t text = src_text(rndr, p, rndr->src.size);
+	return (text == (size_t)-1) ? text : origin_input(rndr, text); }
+
+
+/* emit_source • hands the input range of [beg, end) to the renderer */
+/*	a newline at the start takes in the carriage return dropped with it */
+static void
+emit_source(struct render *rndr, const char *beg, const char *end) {
+	size_t b, e;
+
+	if (!rndr->make.source) return;
+	if ((b = src_text(rndr, beg, rndr->src.size)) == (size_t)-1) return;
+	else if (*beg == '\n' && b > 0) b = origin_input(rndr, b - 1) + 1;
+	else b = origin_input(rndr, b);
+	if (end <= beg) e = b;
+	else if ((e = src_text(rndr, end - 1, rndr->src.size)) == (size_t)-1)
+		return;
+	else e = origin_input(rndr, e) + 1;
+	rndr->make.source(b, e, rndr->make.opaque); }
+
+
+/* emit_block_source • same as emit_source, without the trailing blanks */
+static void
+emit_block_source(struct render *rndr, const char *beg, const char *end) {
+	while (end > beg && (end[-1] == '\n' || end[-1] == ' '
+	|| end[-1] == '\t'))
+		end -= 1;
+	emit_source(rndr, beg, end); }
+
+
+
+/* is_halted • checks the halt callback at a block or span boundary */
+static int
+is_halted(struct render *rndr) {
+	if (!rndr->halted && rndr->make.halt
+	&& rndr->make.halt(rndr->make.opaque))
+		rndr->halted = 1;
+	return rndr->halted; }
+
+
+
 /****************************
  * INLINE PARSING FUNCTIONS *
  ****************************/
@@ -300,10 +460,11 @@ parse_inline(struct buf *ob, struct render *rndr, char *data, size_t size) {
 		if (rndr->make.normal_text) {
 			work.data = data + i;
 			work.size = end - i;
-			rndr->make.normal_text(ob, &work, rndr->make.opaque); }
+			rndr->make.normal_text(ob, &work, rndr->make.opaque);
+			emit_source(rndr, data + i, data + end); }
 		else
 			bufput(ob, data + i, end - i);
-		if (end >= size) break;
+		if (end >= size || is_halted(rndr)) break;
 		i = end;
 
 		/* calling the trigger */
@@ -315,6 +476,18 @@ parse_inline(struct buf *ob, struct render *rndr, char *data, size_t size) {
 			end = i; } } }
 
 
+/* parse_block_inline • parses the inline text of a block unless deferred */
+static void
+parse_block_inline(struct buf *ob, struct render *rndr,
+			char *data, size_t size) {
+	struct buf text = { data, size, 0, 0, 0 };
+	if (rndr->make.defer_inline
+	&& rndr->make.defer_inline(ob, &text, rndr->make.opaque)) {
+		emit_source(rndr, data, data + size);
+		return; }
+	parse_inline(ob, rndr, data, size); }
+
+
 /* find_emph_char • looks for the next emph char, skipping other constructs */
 static size_t
 find_emph_char(char *data, size_t size, char c) {
@@ -488,16 +661,19 @@ char_emphasis(struct buf *ob, struct render *rndr,
 		if (data[1] == ' ' || data[1] == '\t' || data[1] == '\n'
 		|| (ret = parse_emph1(ob, rndr, data + 1, size - 1, c)) == 0)
 			return 0;
+		emit_source(rndr, data, data + ret + 1);
 		return ret + 1; }
 	if (size > 3 && data[1] == c && data[2] != c) {
 		if (data[2] == ' ' || data[2] == '\t' || data[2] == '\n'
 		|| (ret = parse_emph2(ob, rndr, data + 2, size - 2, c)) == 0)
 			return 0;
+		emit_source(rndr, data, data + ret + 2);
 		return ret + 2; }
 	if (size > 4 && data[1] == c && data[2] == c && data[3] != c) {
 		if (data[3] == ' ' || data[3] == '\t' || data[3] == '\n'
 		|| (ret = parse_emph3(ob, rndr, data + 3, size - 3, c)) == 0)
 			return 0;
+		emit_source(rndr, data, data + ret + 3);
 		return ret + 3; }
 	return 0; }
 
@@ -509,7 +685,9 @@ char_linebreak(struct buf *ob, struct render *rndr,
 	if (offset < 2 || data[-1] != ' ' || data[-2] != ' ') return 0;
 	/* removing the last space from ob and rendering */
 	if (ob->size && ob->data[ob->size - 1] == ' ') ob->size -= 1;
-	return rndr->make.linebreak(ob, rndr->make.opaque) ? 1 : 0; }
+	if (!rndr->make.linebreak(ob, rndr->make.opaque)) return 0;
+	emit_source(rndr, data - 2, data + 1);
+	return 1; }
 
 
 /* char_codespan • '`' parsing a code span (assuming codespan != 0) */
@@ -544,6 +722,7 @@ char_codespan(struct buf *ob, struct render *rndr,
 	else {
 		if (!rndr->make.codespan(ob, 0, rndr->make.opaque))
 			end = 0; }
+	if (end) emit_source(rndr, data, data + end);
 	return end; }
 
 
@@ -556,7 +735,8 @@ char_escape(struct buf *ob, struct render *rndr,
 		if (rndr->make.normal_text) {
 			work.data = data + 1;
 			work.size = 1;
-			rndr->make.normal_text(ob, &work, rndr->make.opaque); }
+			rndr->make.normal_text(ob, &work, rndr->make.opaque);
+			emit_source(rndr, data, data + 2); }
 		else bufputc(ob, data[1]); }
 	return 2; }
 
@@ -583,7 +763,8 @@ char_entity(struct buf *ob, struct render *rndr,
 	if (rndr->make.entity) {
 		work.data = data;
 		work.size = end;
-		rndr->make.entity(ob, &work, rndr->make.opaque); }
+		rndr->make.entity(ob, &work, rndr->make.opaque);
+		emit_source(rndr, data, data + end); }
 	else bufput(ob, data, end);
 	return end; }
 
@@ -606,7 +787,8 @@ char_langle_tag(struct buf *ob, struct render *rndr,
 			ret = rndr->make.raw_html_tag(ob, &work,
 							rndr->make.opaque); }
 	if (!ret) return 0;
-	else return end; }
+	emit_source(rndr, data, data + end);
+	return end; }
 
 
 /* get_link_inline • extract inline-style link and title from parenthesed data*/
@@ -798,7 +980,9 @@ char_link_cleanup:
 	release_work_buffer(rndr, title);
 	release_work_buffer(rndr, link);
 	release_work_buffer(rndr, content);
-	return ret ? i : 0; }
+	if (!ret) return 0;
+	emit_source(rndr, is_img ? data - 1 : data, data + i);
+	return i; }
 
 
 
@@ -962,7 +1146,7 @@ static void parse_block(struct buf *ob, struct render *rndr,
 static size_t
 parse_blockquote(struct buf *ob, struct render *rndr,
 			char *data, size_t size) {
-	size_t beg, end = 0, pre, work_size = 0;
+	size_t beg, end = 0, pre, work_size = 0, group = rndr->src.size;
 	char *work_data = 0;
 	struct buf *out = new_work_buffer(rndr);
 
@@ -977,19 +1161,27 @@ parse_blockquote(struct buf *ob, struct render *rndr,
 					&& !is_empty(data + end, size - end))))
 			/* empty line followed by non-quote line */
 			break;
-		if (beg < end) { /* copy into the in-place working buffer */
+		/* copy into the in-place working buffer, unless measuring */
+		/* which has to leave the text as it is for the actual render */
+		if (beg < end && !rndr->measure) {
 			/* bufput(work, data + beg, end - beg); */
 			if (!work_data)
 				work_data = data + beg;
-			else if (data + beg != work_data + work_size)
+			if (rndr->make.source)
+				push_src(rndr, group, work_size, data + beg,
+							end - beg);
+			if (data + beg != work_data + work_size)
 				memmove(work_data + work_size, data + beg,
 						end - beg);
 			work_size += end - beg; }
 		beg = end; }
 
+	rebase_src(rndr, group, work_data);
 	parse_block(out, rndr, work_data, work_size);
-	if (rndr->make.blockquote)
+	rndr->src.size = group;
+	if (rndr->make.blockquote) {
 		rndr->make.blockquote(ob, out, rndr->make.opaque);
+		emit_block_source(rndr, data, data + end); }
 	release_work_buffer(rndr, out);
 	return end; }
 
@@ -1019,9 +1211,11 @@ parse_paragraph(struct buf *ob, struct render *rndr,
 		work.size -= 1;
 	if (!level) {
 		struct buf *tmp = new_work_buffer(rndr);
-		parse_inline(tmp, rndr, work.data, work.size);
-		if (rndr->make.paragraph)
+		parse_block_inline(tmp, rndr, work.data, work.size);
+		if (rndr->make.paragraph) {
 			rndr->make.paragraph(ob, tmp, rndr->make.opaque);
+			emit_block_source(rndr, work.data,
+						work.data + work.size); }
 		release_work_buffer(rndr, tmp); }
 	else {
 		if (work.size) {
@@ -1035,18 +1229,21 @@ parse_paragraph(struct buf *ob, struct render *rndr,
 				work.size -= 1;
 			if (work.size) {
 				struct buf *tmp = new_work_buffer(rndr);
-				parse_inline(tmp, rndr, work.data, work.size);
-				if (rndr->make.paragraph)
+				parse_block_inline(tmp, rndr, work.data, work.size);
+				if (rndr->make.paragraph) {
 					rndr->make.paragraph(ob, tmp,
 							rndr->make.opaque);
+					emit_block_source(rndr, work.data,
+						work.data + work.size); }
 				release_work_buffer(rndr, tmp);
 				work.data += beg;
 				work.size = i - beg; }
 			else work.size = i; }
 		if (rndr->make.header) {
 			struct buf *span = new_work_buffer(rndr);
-			parse_inline(span, rndr, work.data, work.size);
+			parse_block_inline(span, rndr, work.data, work.size);
 			rndr->make.header(ob, span, level,rndr->make.opaque);
+			emit_block_source(rndr, work.data, data + end);
 			release_work_buffer(rndr, span); } }
 	return end; }
 
@@ -1078,8 +1275,9 @@ parse_blockcode(struct buf *ob, struct render *rndr,
 	while (work->size && work->data[work->size - 1] == '\n')
 		work->size -= 1;
 	bufputc(work, '\n');
-	if (rndr->make.blockcode)
+	if (rndr->make.blockcode) {
 		rndr->make.blockcode(ob, work, rndr->make.opaque);
+		emit_block_source(rndr, data, data + beg); }
 	release_work_buffer(rndr, work);
 	return beg; }
 
@@ -1091,7 +1289,8 @@ parse_listitem(struct buf *ob, struct render *rndr,
 			char *data, size_t size, int *flags) {
 	struct buf *work = 0, *inter = 0;
 	size_t beg = 0, end, pre, sublist = 0, orgpre = 0, i;
-	int in_empty = 0, has_inside_empty = 0;
+	size_t group = rndr->src.size, empty = 0;
+	int in_empty = 0, has_inside_empty = 0, track = !!rndr->make.source;
 
 	/* keeping book of the first indentation prefix */
 	if (size > 1 && data[0] == ' ') { orgpre = 1;
@@ -1109,6 +1308,7 @@ parse_listitem(struct buf *ob, struct render *rndr,
 	inter = new_work_buffer(rndr);
 
 	/* putting the first line into the working buffer */
+	if (track) push_src(rndr, group, 0, data + beg, end - beg);
 	bufput(work, data + beg, end - beg);
 	beg = end;
 
@@ -1119,6 +1319,7 @@ parse_listitem(struct buf *ob, struct render *rndr,
 
 		/* process an empty line */
 		if (is_empty(data + beg, end - beg)) {
+			if (!in_empty) empty = end - 1;
 			in_empty = 1;
 			beg = end;
 			continue; }
@@ -1146,13 +1347,18 @@ parse_listitem(struct buf *ob, struct render *rndr,
 				*flags |= MKD_LI_END;
 				break; }
 		else if (in_empty) {
+			if (track) push_src(rndr, group, work->size,
+							data + empty, 1);
 			bufputc(work, '\n');
 			has_inside_empty = 1; }
 		in_empty = 0;
 
 		/* adding the line without prefix into the working buffer */
+		if (track) push_src(rndr, group, work->size, data + beg + i,
+							end - beg - i);
 		bufput(work, data + beg + i, end - beg - i);
 		beg = end; }
+	rebase_src(rndr, group, work->data);
 
 	/* render of li contents */
 	if (has_inside_empty) *flags |= MKD_LI_BLOCK;
@@ -1167,15 +1373,17 @@ parse_listitem(struct buf *ob, struct render *rndr,
 	else {
 		/* intermediate render of inline li */
 		if (sublist && sublist < work->size) {
-			parse_inline(inter, rndr, work->data, sublist);
+			parse_block_inline(inter, rndr, work->data, sublist);
 			parse_block(inter, rndr, work->data + sublist,
 						work->size - sublist); }
 		else
-			parse_inline(inter, rndr, work->data, work->size); }
+			parse_block_inline(inter, rndr, work->data, work->size); }
 
 	/* render of li itself */
-	if (rndr->make.listitem)
+	rndr->src.size = group;
+	if (rndr->make.listitem) {
 		rndr->make.listitem(ob, inter, *flags, rndr->make.opaque);
+		emit_block_source(rndr, data, data + beg); }
 	release_work_buffer(rndr, inter);
 	release_work_buffer(rndr, work);
 	return beg; }
@@ -1191,10 +1399,11 @@ parse_list(struct buf *ob, struct render *rndr,
 	while (i < size) {
 		j = parse_listitem(work, rndr, data + i, size - i, &flags);
 		i += j;
-		if (!j || (flags & MKD_LI_END)) break; }
+		if (!j || (flags & MKD_LI_END) || is_halted(rndr)) break; }
 
-	if (rndr->make.list)
+	if (rndr->make.list) {
 		rndr->make.list(ob, work, flags, rndr->make.opaque);
+		emit_block_source(rndr, data, data + i); }
 	release_work_buffer(rndr, work);
 	return i; }
 
@@ -1225,8 +1434,9 @@ parse_atxheader(struct buf *ob, struct render *rndr,
 	span_size = end - span_beg;
 	if (rndr->make.header) {
 		struct buf *span = new_work_buffer(rndr);
-		parse_inline(span, rndr, data + span_beg, span_size);
+		parse_block_inline(span, rndr, data + span_beg, span_size);
 		rndr->make.header(ob, span, level, rndr->make.opaque);
+		emit_block_source(rndr, data, data + skip);
 		release_work_buffer(rndr, span); }
 	return skip; }
 
@@ -1285,9 +1495,11 @@ parse_htmlblock(struct buf *ob, struct render *rndr,
 				j = is_empty(data + i, size - i);
 				if (j) {
 					work.size = i + j;
-					if (rndr->make.blockhtml)
+					if (rndr->make.blockhtml) {
 						rndr->make.blockhtml(ob, &work,
 							rndr->make.opaque);
+						emit_block_source(rndr, data,
+							data + work.size); }
 					return work.size; } }
 
 		/* HR, which is the only self-closing block tag considered */
@@ -1302,9 +1514,11 @@ parse_htmlblock(struct buf *ob, struct render *rndr,
 				j = is_empty(data + i, size - i);
 				if (j) {
 					work.size = i + j;
-					if (rndr->make.blockhtml)
+					if (rndr->make.blockhtml) {
 						rndr->make.blockhtml(ob, &work,
 							rndr->make.opaque);
+						emit_block_source(rndr, data,
+							data + work.size); }
 					return work.size; } } }
 
 		/* no special case recognised */
@@ -1348,8 +1562,9 @@ parse_htmlblock(struct buf *ob, struct render *rndr,
 
 	/* the end of the block has been found */
 	work.size = i;
-	if (rndr->make.blockhtml)
+	if (rndr->make.blockhtml) {
 		rndr->make.blockhtml(ob, &work, rndr->make.opaque);
+		emit_block_source(rndr, data, data + i); }
 	return i; }
 
 
@@ -1358,8 +1573,9 @@ static void
 parse_table_cell(struct buf *ob, struct render *rndr, char *data, size_t size,
 				int flags) {
 	struct buf *span = new_work_buffer(rndr);
-	parse_inline(span, rndr, data, size);
+	parse_block_inline(span, rndr, data, size);
 	rndr->make.table_cell(ob, span, flags, rndr->make.opaque);
+	emit_source(rndr, data, data + size);
 	release_work_buffer(rndr, span); }
 
 
@@ -1426,6 +1642,7 @@ parse_table_row(struct buf *ob, struct render *rndr, char *data, size_t size,
 
 	/* render the whole row and clean up */
 	rndr->make.table_row(ob, cells, flags, rndr->make.opaque);
+	emit_block_source(rndr, data, data + (total ? total : size));
 	release_work_buffer(rndr, cells);
 	return total ? total : size; }
 
@@ -1448,6 +1665,7 @@ parse_table(struct buf *ob, struct render *rndr, char *data, size_t size) {
 	if (i >= size) {
 		parse_table_row(rows, rndr, data, size, 0, 0, 0);
 		rndr->make.table(ob, 0, rows, rndr->make.opaque);
+		emit_block_source(rndr, data, data + i);
 		release_work_buffer(rndr, rows);
 		return i; }
 
@@ -1507,6 +1725,7 @@ parse_table(struct buf *ob, struct render *rndr, char *data, size_t size) {
 
 	/* render the full table */
 	rndr->make.table(ob, head, rows, rndr->make.opaque);
+	emit_block_source(rndr, data, data + i);
 
 	/* cleanup */
 	if (head) release_work_buffer(rndr, head);
@@ -1515,48 +1734,53 @@ parse_table(struct buf *ob, struct render *rndr, char *data, size_t size) {
 	return i; }
 
 
+/* parse_block_one • parsing of a single block, returning its size */
+static size_t
+parse_block_one(struct buf *ob, struct render *rndr,
+			char *data, size_t size) {
+	size_t i;
+	int has_table = (rndr->make.table && rndr->make.table_row
+	    && rndr->make.table_cell);
+
+	if (data[0] == '#')
+		return parse_atxheader(ob, rndr, data, size);
+	if (data[0] == '<' && rndr->make.blockhtml
+	&& (i = parse_htmlblock(ob, rndr, data, size)) != 0)
+		return i;
+	if ((i = is_empty(data, size)) != 0)
+		return i;
+	if (is_hrule(data, size)) {
+		for (i = 0; i < size && data[i] != '\n'; i += 1);
+		if (rndr->make.hrule) {
+			rndr->make.hrule(ob, rndr->make.opaque);
+			emit_block_source(rndr, data, data + i); }
+		return (i < size) ? i + 1 : size; }
+	if (prefix_quote(data, size))
+		return parse_blockquote(ob, rndr, data, size);
+	if (prefix_code(data, size))
+		return parse_blockcode(ob, rndr, data, size);
+	if (prefix_uli(data, size))
+		return parse_list(ob, rndr, data, size, 0);
+	if (prefix_oli(data, size))
+		return parse_list(ob, rndr, data, size, MKD_LIST_ORDERED);
+	if (has_table && is_tableline(data, size))
+		return parse_table(ob, rndr, data, size);
+	return parse_paragraph(ob, rndr, data, size); }
+
+
 /* parse_block • parsing of one block, returning next char to parse */
 static void
 parse_block(struct buf *ob, struct render *rndr,
 			char *data, size_t size) {
-	size_t beg, end, i;
-	char *txt_data;
-	int has_table = (rndr->make.table && rndr->make.table_row
-	    && rndr->make.table_cell);
+	size_t beg;
 
 	if (rndr->work.size > rndr->make.max_work_stack) {
 		if (size) bufput(ob, data, size);
 		return; }
 
 	beg = 0;
-	while (beg < size) {
-		txt_data = data + beg;
-		end = size - beg;
-		if (data[beg] == '#')
-			beg += parse_atxheader(ob, rndr, txt_data, end);
-		else if (data[beg] == '<' && rndr->make.blockhtml
-			&& (i = parse_htmlblock(ob, rndr, txt_data, end)) != 0)
-			beg += i;
-		else if ((i = is_empty(txt_data, end)) != 0)
-			beg += i;
-		else if (is_hrule(txt_data, end)) {
-			if (rndr->make.hrule)
-				rndr->make.hrule(ob, rndr->make.opaque);
-			while (beg < size && data[beg] != '\n') beg += 1;
-			beg += 1; }
-		else if (prefix_quote(txt_data, end))
-			beg += parse_blockquote(ob, rndr, txt_data, end);
-		else if (prefix_code(txt_data, end))
-			beg += parse_blockcode(ob, rndr, txt_data, end);
-		else if (prefix_uli(txt_data, end))
-			beg += parse_list(ob, rndr, txt_data, end, 0);
-		else if (prefix_oli(txt_data, end))
-			beg += parse_list(ob, rndr, txt_data, end,
-						MKD_LIST_ORDERED);
-		else if (has_table && is_tableline(txt_data, end))
-			beg += parse_table(ob, rndr, txt_data, end);
-		else
-			beg += parse_paragraph(ob, rndr, txt_data, end); } }
+	while (beg < size && !is_halted(rndr))
+		beg += parse_block_one(ob, rndr, data + beg, size - beg); }
 
 
 
@@ -1669,65 +1893,155 @@ is_ref(char *data, size_t beg, size_t end, size_t *last, struct array *refs) {
 
 
 
+/* add_line_map • records where the text at the given offset comes from */
+static void
+add_line_map(struct array *lines, size_t text, size_t input) {
+	struct line_map *lm;
+
+	/* nothing to record while the copy is in step with the input */
+	if (lines->size) {
+		lm = arr_item(lines, lines->size - 1);
+		if (input - lm->input == text - lm->text) return; }
+	else if (input == text) return;
+
+	lm = arr_item(lines, arr_newitem(lines));
+	lm->text = text;
+	lm->input = input; }
+
+
+/* measure_* • stand-ins keeping the block structure of a renderer */
+static void
+measure_text(struct buf *ob, struct buf *text, void *opaque) {}
+
+static void
+measure_flags(struct buf *ob, struct buf *text, int flags, void *opaque) {}
+
+static void
+measure_rule(struct buf *ob, void *opaque) {}
+
+static void
+measure_table(struct buf *ob, struct buf *head_row, struct buf *rows,
+						void *opaque) {}
+
+static int
+measure_defer(struct buf *ob, struct buf *text, void *opaque) {
+	return 1; }
+
+
+/* new_measure • copies a render, stubbing out every callback */
+/*	block extents only depend on which block callbacks are set */
+static struct render *
+new_measure(const struct render *rndr) {
+	struct render *m = malloc(sizeof *m);
+	if (!m) return 0;
+	*m = *rndr;
+	memset(&m->make, 0, sizeof m->make);
+	m->make.max_work_stack = rndr->make.max_work_stack;
+	if (rndr->make.blockcode) m->make.blockcode = measure_text;
+	if (rndr->make.blockquote) m->make.blockquote = measure_text;
+	if (rndr->make.blockhtml) m->make.blockhtml = measure_text;
+	if (rndr->make.header) m->make.header = measure_flags;
+	if (rndr->make.hrule) m->make.hrule = measure_rule;
+	if (rndr->make.list) m->make.list = measure_flags;
+	if (rndr->make.listitem) m->make.listitem = measure_flags;
+	if (rndr->make.paragraph) m->make.paragraph = measure_text;
+	if (rndr->make.table) m->make.table = measure_table;
+	if (rndr->make.table_cell) m->make.table_cell = measure_flags;
+	if (rndr->make.table_row) m->make.table_row = measure_flags;
+	m->make.defer_inline = measure_defer;
+	m->halted = 0;
+	m->measure = 1;
+	parr_init(&m->work);
+	arr_init(&m->src, sizeof (struct src_map));
+	return m; }
+
+
+
 /**********************
  * EXPORTED FUNCTIONS *
  **********************/
 
-/* markdown • parses the input buffer and renders it into the output buffer */
-void
-markdown(struct buf *ob, struct buf *ib, const struct mkd_renderer *rndrer) {
-	struct link_ref *lr;
-	struct buf *text = bufnew(TEXT_UNIT);
+/* mkd_document_new • runs the reference pass and prepares the rendering */
+struct mkd_document *
+mkd_document_new(struct buf *ib, const struct mkd_renderer *rndrer) {
+	struct mkd_document *doc;
+	struct render *rndr;
+	struct buf *text;
 	size_t i, beg, end;
-	struct render rndr;
 
 	/* filling the render structure */
-	if (!rndrer) return;
-	rndr.make = *rndrer;
-	if (rndr.make.max_work_stack < 1)
-		rndr.make.max_work_stack = 1;
-	arr_init(&rndr.refs, sizeof (struct link_ref));
-	parr_init(&rndr.work);
-	for (i = 0; i < 256; i += 1) rndr.active_char[i] = 0;
-	if ((rndr.make.emphasis || rndr.make.double_emphasis
-						|| rndr.make.triple_emphasis)
-	&& rndr.make.emph_chars)
-		for (i = 0; rndr.make.emph_chars[i]; i += 1)
-			rndr.active_char[(unsigned char)rndr.make.emph_chars[i]]
+	if (!ib || !rndrer) return 0;
+	doc = malloc(sizeof *doc);
+	if (!doc) return 0;
+	rndr = &doc->rndr;
+	text = doc->text = bufnew(TEXT_UNIT);
+	doc->beg = 0;
+	doc->input_size = ib->size;
+	doc->measure = 0;
+	arr_init(&doc->lines, sizeof (struct line_map));
+	arr_init(&doc->ref_lines, sizeof (struct ref_line));
+	rndr->make = *rndrer;
+	rndr->halted = 0;
+	rndr->measure = 0;
+	if (rndr->make.max_work_stack < 1)
+		rndr->make.max_work_stack = 1;
+	arr_init(&rndr->refs, sizeof (struct link_ref));
+	parr_init(&rndr->work);
+	rndr->origin = text;
+	rndr->lines = &doc->lines;
+	rndr->input_size = ib->size;
+	arr_init(&rndr->src, sizeof (struct src_map));
+	for (i = 0; i < 256; i += 1) rndr->active_char[i] = 0;
+	if ((rndr->make.emphasis || rndr->make.double_emphasis
+						|| rndr->make.triple_emphasis)
+	&& rndr->make.emph_chars)
+		for (i = 0; rndr->make.emph_chars[i]; i += 1)
+			rndr->active_char[(unsigned char)rndr->make.emph_chars[i]]
 				= char_emphasis;
-	if (rndr.make.codespan) rndr.active_char['`'] = char_codespan;
-	if (rndr.make.linebreak) rndr.active_char['\n'] = char_linebreak;
-	if (rndr.make.image || rndr.make.link)
-		rndr.active_char['['] = char_link;
-	rndr.active_char['<'] = char_langle_tag;
-	rndr.active_char['\\'] = char_escape;
-	rndr.active_char['&'] = char_entity;
+	if (rndr->make.codespan) rndr->active_char['`'] = char_codespan;
+	if (rndr->make.linebreak) rndr->active_char['\n'] = char_linebreak;
+	if (rndr->make.image || rndr->make.link)
+		rndr->active_char['['] = char_link;
+	rndr->active_char['<'] = char_langle_tag;
+	rndr->active_char['\\'] = char_escape;
+	rndr->active_char['&'] = char_entity;
 
 	/* first pass: looking for references, copying everything else */
 	beg = 0;
 	while (beg < ib->size) /* iterating over lines */
-		if (is_ref(ib->data, beg, ib->size, &end, &rndr.refs))
-			beg = end;
+		if (is_ref(ib->data, beg, ib->size, &end, &rndr->refs)) {
+			struct ref_line *rl;
+			rl = arr_item(&doc->ref_lines,
+					arr_newitem(&doc->ref_lines));
+			rl->beg = beg;
+			rl->end = end;
+			beg = end; }
 		else { /* skipping to the next line */
 			end = beg;
 			while (end < ib->size
 			&& ib->data[end] != '\n' && ib->data[end] != '\r')
 				end += 1;
 			/* adding the line body if present */
-			if (end > beg) bufput(text, ib->data + beg, end - beg);
+			if (end > beg) {
+				add_line_map(&doc->lines, text->size, beg);
+				bufput(text, ib->data + beg, end - beg); }
 			while (end < ib->size
 			&& (ib->data[end] == '\n' || ib->data[end] == '\r')) {
 				/* add one \n per newline */
 				if (ib->data[end] == '\n'
 				|| (end + 1 < ib->size
-						&& ib->data[end + 1] != '\n'))
+						&& ib->data[end + 1] != '\n')) {
+					add_line_map(&doc->lines, text->size,
+								end);
 					bufputc(text, '\n');
+					add_line_map(&doc->lines, text->size,
+								end + 1); }
 				end += 1; }
 			beg = end; }
 
 	/* sorting the reference array */
-	if (rndr.refs.size)
-		qsort(rndr.refs.base, rndr.refs.size, rndr.refs.unit,
+	if (rndr->refs.size)
+		qsort(rndr->refs.base, rndr->refs.size, rndr->refs.unit,
 					cmp_link_ref_sort);
 
 	/* adding a final newline if not already present */
@@ -1736,24 +2050,178 @@ markdown(struct buf *ob, struct buf *ib, const struct mkd_renderer *rndrer) {
 	&&  text->data[text->size - 1] != '\r')
 		bufputc(text, '\n');
 
-	/* second pass: actual rendering */
-	if (rndr.make.prolog)
-		rndr.make.prolog(ob, rndr.make.opaque);
-	parse_block(ob, &rndr, text->data, text->size);
-	if (rndr.make.epilog)
-		rndr.make.epilog(ob, rndr.make.opaque);
+	return doc; }
 
-	/* clean-up */
-	bufrelease(text);
-	lr = rndr.refs.base;
-	for (i = 0; i < rndr.refs.size; i += 1) {
+
+/* mkd_document_step • renders top-level blocks until max bytes are consumed */
+size_t
+mkd_document_step(struct buf *ob, struct mkd_document *doc, size_t max) {
+	struct buf *text = doc->text;
+	size_t beg = doc->beg;
+
+	/* at least one block is rendered whatever the budget */
+	while (doc->beg < text->size && !is_halted(&doc->rndr)) {
+		doc->beg += parse_block_one(ob, &doc->rndr,
+				text->data + doc->beg, text->size - doc->beg);
+		if (doc->beg - beg >= max) break; }
+	return doc->beg - beg; }
+
+
+/* mkd_document_remaining • number of bytes of text left to render */
+size_t
+mkd_document_remaining(const struct mkd_document *doc) {
+	if (doc->rndr.halted) return 0;
+	return doc->text->size - doc->beg; }
+
+
+/* mkd_document_offset • input offset of the next block to render */
+size_t
+mkd_document_offset(const struct mkd_document *doc) {
+	size_t input;
+
+	if (doc->beg >= doc->text->size) return doc->input_size;
+	input = text_input(&doc->lines, doc->beg);
+	return (input < doc->input_size) ? input : doc->input_size; }
+
+
+/* mkd_document_extent • input size of the next size bytes of text */
+size_t
+mkd_document_extent(const struct mkd_document *doc, size_t size) {
+	size_t beg = mkd_document_offset(doc), end;
+
+	if (size > doc->text->size - doc->beg)
+		size = doc->text->size - doc->beg;
+	if (doc->beg + size >= doc->text->size) return doc->input_size - beg;
+	end = text_input(&doc->lines, doc->beg + size);
+	return ((end < doc->input_size) ? end : doc->input_size) - beg; }
+
+
+/* mkd_document_position • input offset of a char of the text being rendered */
+size_t
+mkd_document_position(struct mkd_document *doc, const char *data) {
+	return src_input(&doc->rndr, data); }
+
+
+/* mkd_inline • renders the inline text of a single block */
+void
+mkd_inline(struct buf *ob, struct buf *ib, struct buf *refs,
+				const struct mkd_renderer *rndrer) {
+	struct mkd_document *doc = mkd_document_new(refs, rndrer);
+
+	if (!doc) return;
+	doc->rndr.origin = ib;
+	doc->rndr.lines = 0;
+	doc->rndr.input_size = ib->size;
+	parse_inline(ob, &doc->rndr, ib->data, ib->size);
+	mkd_document_free(doc); }
+
+
+/* mkd_document_next • normalized text of the next top-level block */
+size_t
+mkd_document_next(struct mkd_document *doc, const char **data) {
+	struct buf *text = doc->text;
+	struct buf *ob;
+	size_t size;
+
+	*data = text->data + doc->beg;
+	if (doc->beg >= text->size || doc->rndr.halted) return 0;
+	if (!doc->measure && (doc->measure = new_measure(&doc->rndr)) == 0)
+		return 0;
+	ob = bufnew(64);
+	size = parse_block_one(ob, doc->measure,
+			text->data + doc->beg, text->size - doc->beg);
+	bufrelease(ob);
+	return size; }
+
+
+/* mkd_document_skip • moves past text without rendering it */
+void
+mkd_document_skip(struct mkd_document *doc, size_t size) {
+	if (size > doc->text->size - doc->beg)
+		size = doc->text->size - doc->beg;
+	doc->beg += size; }
+
+
+/* mkd_document_reference • input range of the n-th reference definition */
+int
+mkd_document_reference(const struct mkd_document *doc, size_t n,
+				size_t *beg, size_t *end) {
+	struct ref_line *rl = doc->ref_lines.base;
+	if (n >= (size_t)doc->ref_lines.size) return 0;
+	*beg = rl[n].beg;
+	*end = rl[n].end;
+	return 1; }
+
+
+/* mkd_document_free • releases the document and its reference table */
+void
+mkd_document_free(struct mkd_document *doc) {
+	struct link_ref *lr;
+	struct render *rndr;
+	size_t i;
+
+	if (!doc) return;
+	rndr = &doc->rndr;
+	bufrelease(doc->text);
+	lr = rndr->refs.base;
+	for (i = 0; i < rndr->refs.size; i += 1) {
 		bufrelease(lr[i].id);
 		bufrelease(lr[i].link);
 		bufrelease(lr[i].title); }
-	arr_free(&rndr.refs);
-	assert(rndr.work.size == 0);
-	for (i = 0; i < rndr.work.asize; i += 1)
-		bufrelease(rndr.work.item[i]);
-	parr_free(&rndr.work); }
+	arr_free(&rndr->refs);
+	arr_free(&rndr->src);
+	arr_free(&doc->lines);
+	arr_free(&doc->ref_lines);
+	assert(rndr->work.size == 0);
+	for (i = 0; i < rndr->work.asize; i += 1)
+		bufrelease(rndr->work.item[i]);
+	parr_free(&rndr->work);
+	if (doc->measure) {
+		for (i = 0; i < doc->measure->work.asize; i += 1)
+			bufrelease(doc->measure->work.item[i]);
+		parr_free(&doc->measure->work);
+		arr_free(&doc->measure->src);
+		free(doc->measure); }
+	free(doc); }
+
+
+/* mkd_references • copies the reference definitions of ib into ob */
+size_t
+mkd_references(struct buf *ob, struct buf *ib, size_t limit) {
+	size_t beg = 0, end;
+
+	if (limit > ib->size) limit = ib->size;
+	while (beg < limit)
+		if (is_ref(ib->data, beg, ib->size, &end, 0)) {
+			bufput(ob, ib->data + beg, end - beg);
+			bufputc(ob, '\n');
+			beg = end; }
+		else {
+			while (beg < ib->size
+			&& ib->data[beg] != '\n' && ib->data[beg] != '\r')
+				beg += 1;
+			while (beg < ib->size
+			&& (ib->data[beg] == '\n' || ib->data[beg] == '\r'))
+				beg += 1; }
+	return beg; }
+
+
+/* markdown • parses the input buffer and renders it into the output buffer */
+void
+markdown(struct buf *ob, struct buf *ib, const struct mkd_renderer *rndrer) {
+	struct mkd_document *doc = mkd_document_new(ib, rndrer);
+
+	if (!doc) return;
+
+	/* second pass: actual rendering */
+	if (doc->rndr.make.prolog)
+		doc->rndr.make.prolog(ob, doc->rndr.make.opaque);
+	while (mkd_document_remaining(doc))
+		mkd_document_step(ob, doc, (size_t)-1);
+	if (doc->rndr.make.epilog)
+		doc->rndr.make.epilog(ob, doc->rndr.make.opaque);
+
+	/* clean-up */
+	mkd_document_free(doc); }
 
 /* vim: set filetype=c: */
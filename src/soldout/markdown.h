@@ -78,6 +78,15 @@ struct mkd_renderer {
 	void (*entity)(struct buf *ob, struct buf *entity, void *opaque);
 	void (*normal_text)(struct buf *ob, struct buf *text, void *opaque);
 
+	/* control callbacks - NULL never stops the parse */
+	int (*halt)(void *opaque); /* non-zero stops at the next boundary */
+	int (*defer_inline)(struct buf *ob, struct buf *text, void *opaque);
+		/* non-zero leaves the inline text of a block unparsed */
+
+	/* position callback - NULL skips position tracking */
+	void (*source)(size_t beg, size_t end, void *opaque);
+		/* input range of the block, span or text just rendered */
+
 	/* renderer data */
 	int max_work_stack; /* prevent arbitrary deep recursion, cf README */
 	const char *emph_chars; /* chars that trigger emphasis rendering */
@@ -86,6 +95,11 @@ struct mkd_renderer {
 
 
 
+/* mkd_document • opaque state of a resumable rendering */
+struct mkd_document;
+
+
+
 /*********
  * FLAGS *
  *********/
@@ -112,6 +126,73 @@ struct mkd_renderer {
 void
 markdown(struct buf *ob, struct buf *ib, const struct mkd_renderer *rndr);
 
+/* mkd_document_new • runs the reference pass over the input buffer */
+/*   the renderer is copied, the input is not needed after the call */
+/*   prolog and epilog are left to the caller */
+struct mkd_document *
+mkd_document_new(struct buf *ib, const struct mkd_renderer *rndr);
+
+/* mkd_document_step • renders whole top-level blocks into the output buffer */
+/*   until at least max bytes of text are consumed (always at least one */
+/*   block), returns the number of bytes consumed */
+size_t
+mkd_document_step(struct buf *ob, struct mkd_document *doc, size_t max);
+
+/* mkd_document_remaining • number of bytes of text left to render */
+/*   a halted document has nothing left to render */
+size_t
+mkd_document_remaining(const struct mkd_document *doc);
+
+/* mkd_document_offset • input offset of the next top-level block to render */
+/*   accounts for the reference lines and carriage returns of the first pass */
+size_t
+mkd_document_offset(const struct mkd_document *doc);
+
+/* mkd_document_extent • input size of the next size bytes of text */
+/*   equal to size when the text is an unchanged copy of the input */
+size_t
+mkd_document_extent(const struct mkd_document *doc, size_t size);
+
+/* mkd_document_position • input offset of a char of the text being rendered */
+/*   data has to point into a buffer handed to a callback of the current */
+/*   step, returns (size_t)-1 when the char does not come from the input */
+size_t
+mkd_document_position(struct mkd_document *doc, const char *data);
+
+/* mkd_inline • renders the inline text of a single block */
+/*   refs holds the reference definitions the text may use, one per line */
+/*   source positions are offsets into ib */
+void
+mkd_inline(struct buf *ob, struct buf *ib, struct buf *refs,
+				const struct mkd_renderer *rndr);
+
+/* mkd_document_next • normalized text of the next top-level block */
+/*   points data at it and returns its size, finding where it ends with */
+/*   the block callbacks stubbed out and without parsing any inline text */
+size_t
+mkd_document_next(struct mkd_document *doc, const char **data);
+
+/* mkd_document_skip • moves past size bytes of text without rendering */
+void
+mkd_document_skip(struct mkd_document *doc, size_t size);
+
+/* mkd_document_reference • input range of the n-th reference definition */
+/*   in input order, returns 0 when there are fewer than n + 1 definitions */
+int
+mkd_document_reference(const struct mkd_document *doc, size_t n,
+				size_t *beg, size_t *end);
+
+/* mkd_document_free • releases a document created by mkd_document_new */
+void
+mkd_document_free(struct mkd_document *doc);
+
+/* mkd_references • appends the reference definitions found in ib to ob */
+/*   one definition per line, so that ob can prefix a later input; only */
+/*   definitions starting before limit are copied, and the offset of the */
+/*   first line left unscanned is returned */
+size_t
+mkd_references(struct buf *ob, struct buf *ib, size_t limit);
+
 
 #endif /* ndef LITHIUM_MARKDOWN_H */
 
@@ -0,0 +1,281 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <algorithm>
+#include <unordered_map>
+#include "source_index.h"
+
+namespace Bypass {
+
+	const size_t SourceIndex::NO_NODE;
+	const uint32_t SourceIndex::NO_PARENT;
+
+	SourceIndex::SourceIndex()
+	: nodes()
+	, starts()
+	, blocks()
+	{
+	}
+
+	SourceIndex::SourceIndex(const Document& document)
+	: nodes()
+	, starts()
+	, blocks()
+	{
+		index(document, NULL);
+	}
+
+	SourceIndex::SourceIndex(const Document& document, const SourceIndex& previous)
+	: nodes()
+	, starts()
+	, blocks()
+	{
+		index(document, &previous);
+	}
+
+	void SourceIndex::index(const Document& document, const SourceIndex* previous) {
+		std::unordered_map<const Element*, const Block*> reusable;
+
+		if (previous) {
+			for (std::vector<Block>::const_iterator it = previous->blocks.begin(); it != previous->blocks.end(); ++it) {
+				reusable[it->element.get()] = &*it;
+			}
+		}
+
+		blocks.reserve(document.blocks.size());
+
+		for (std::vector<Document::Block>::const_iterator it = document.blocks.begin(); it != document.blocks.end(); ++it) {
+			Block block;
+			block.element = it->element;
+			block.offset = it->offset;
+			block.firstNode = nodes.size();
+			block.firstStart = starts.size();
+
+			std::unordered_map<const Element*, const Block*>::const_iterator shared = reusable.find(it->element.get());
+
+			if (shared != reusable.end()) {
+				const Block& old = *shared->second;
+				nodes.insert(nodes.end(), previous->nodes.begin() + old.firstNode, previous->nodes.begin() + old.firstNode + old.nodeCount);
+				starts.insert(starts.end(), previous->starts.begin() + old.firstStart, previous->starts.begin() + old.firstStart + old.startCount);
+			}
+			else {
+				add(*it->element, NO_PARENT, block.firstNode);
+
+				for (size_t i = block.firstNode; i < nodes.size(); i++) {
+					if (nodes[i].length > 0) {
+						Start start = { nodes[i].offset, nodes[i].offset + nodes[i].length, 0, (uint32_t) (i - block.firstNode) };
+						starts.push_back(start);
+					}
+				}
+
+				std::stable_sort(starts.begin() + block.firstStart, starts.end(), [](const Start& a, const Start& b) {
+					return a.offset < b.offset;
+				});
+			}
+
+			block.nodeCount = nodes.size() - block.firstNode;
+			block.startCount = starts.size() - block.firstStart;
+			block.rootLevel = shared != reusable.end() ? shared->second->rootLevel : buildTree(&starts[0] + block.firstStart, block.startCount);
+			blocks.push_back(block);
+		}
+	}
+
+	void SourceIndex::add(const Element& element, uint32_t parent, size_t first) {
+		Node node = { &element, parent, 0, element.sourceOffset, element.sourceLength };
+
+		if (parent != NO_PARENT) {
+			const Node& outer = nodes[first + parent];
+			node.depth = outer.depth + 1;
+
+			if (node.length > 0 && outer.length > 0) {
+				uint32_t begin = std::max(node.offset, outer.offset);
+				uint32_t end = std::min(node.offset + node.length, outer.offset + outer.length);
+				node.offset = begin;
+				node.length = end > begin ? end - begin : 0;
+			}
+		}
+
+		uint32_t id = (uint32_t) (nodes.size() - first);
+		nodes.push_back(node);
+
+		const std::vector<Element>& children = element.getChildren();
+
+		for (std::vector<Element>::const_iterator it = children.begin(); it != children.end(); ++it) {
+			add(*it, id, first);
+		}
+	}
+
+	size_t SourceIndex::getNodeCount() const {
+		return nodes.size();
+	}
+
+	Type SourceIndex::getNodeType(size_t node) const {
+		return nodes[node].element->type;
+	}
+
+	size_t SourceIndex::getNodeParent(size_t node) const {
+		uint32_t parent = nodes[node].parent;
+		return parent == NO_PARENT ? NO_NODE : blocks[getNodeBlock(node)].firstNode + parent;
+	}
+
+	size_t SourceIndex::getNodeBlock(size_t node) const {
+		return std::upper_bound(blocks.begin(), blocks.end(), node, nodeStartsAfter) - blocks.begin() - 1;
+	}
+
+	size_t SourceIndex::getBlockNode(size_t i) const {
+		return blocks[i].firstNode;
+	}
+
+	size_t SourceIndex::getNodeOffset(size_t node) const {
+		return blocks[getNodeBlock(node)].offset + nodes[node].offset;
+	}
+
+	size_t SourceIndex::getNodeLength(size_t node) const {
+		return nodes[node].length;
+	}
+
+	Element SourceIndex::getElement(size_t node) const {
+		return *nodes[node].element;
+	}
+
+	size_t SourceIndex::getNode(size_t offset) const {
+		std::vector<Block>::const_iterator block = std::upper_bound(blocks.begin(), blocks.end(), offset, blockStartsAfter);
+
+		if (block == blocks.begin()) {
+			return NO_NODE;
+		}
+
+		--block;
+
+		if (block->startCount == 0 || offset - block->offset >= UINT32_MAX) {
+			return NO_NODE;
+		}
+
+		uint32_t relative = (uint32_t) (offset - block->offset);
+		const Start* tree = &starts[block->firstStart];
+		size_t count = block->startCount;
+		const Node* best = NULL;
+		uint32_t found = NO_PARENT;
+
+		// Walks the tree from the root, skipping a left subtree whose ranges
+		// all end at or before the offset, and a node and its right subtree
+		// when the node starts after it. Small subtrees are scanned in order.
+		struct Frame {
+			int level;
+			size_t index;
+			bool leftDone;
+		};
+
+		Frame stack[64];
+		size_t depth = 0;
+		Frame root = { block->rootLevel, ((size_t) 1 << block->rootLevel) - 1, false };
+		stack[depth++] = root;
+
+		while (depth > 0) {
+			Frame frame = stack[--depth];
+			size_t from = frame.index;
+			size_t to = frame.index + 1;
+
+			if (frame.level <= 3) {
+				from = frame.index >> frame.level << frame.level;
+				to = std::min(count, from + ((size_t) 1 << (frame.level + 1)) - 1);
+			}
+			else if (!frame.leftDone) {
+				size_t left = frame.index - ((size_t) 1 << (frame.level - 1));
+				Frame self = { frame.level, frame.index, true };
+				stack[depth++] = self;
+
+				if (left >= count || tree[left].maxEnd > relative) {
+					Frame next = { frame.level - 1, left, false };
+					stack[depth++] = next;
+				}
+
+				continue;
+			}
+			else if (frame.index < count && tree[frame.index].offset <= relative) {
+				Frame next = { frame.level - 1, frame.index + ((size_t) 1 << (frame.level - 1)), false };
+				stack[depth++] = next;
+			}
+			else {
+				continue;
+			}
+
+			for (size_t i = from; i < to && i < count && tree[i].offset <= relative; i++) {
+				if (relative >= tree[i].end) {
+					continue;
+				}
+
+				// Of the nodes that hold the offset, the deepest wins; among
+				// overlapping siblings, the shorter and then the later one.
+				const Node& node = nodes[block->firstNode + tree[i].node];
+
+				if (!best || node.depth > best->depth || (node.depth == best->depth && (node.length < best->length || (node.length == best->length && tree[i].node > found)))) {
+					best = &node;
+					found = tree[i].node;
+				}
+			}
+		}
+
+		return best ? block->firstNode + found : NO_NODE;
+	}
+
+	int SourceIndex::buildTree(Start* tree, size_t count) {
+		if (count == 0) {
+			return -1;
+		}
+
+		// Leaves are at the even indices, and the node at level k at index
+		// i covers the 2^(k+1) - 1 starts around it. When the tree is not
+		// full, `last` carries the greatest end of the rightmost subtree up
+		// to the parents that lack a right child.
+		size_t lastIndex = 0;
+		uint32_t last = 0;
+
+		for (size_t i = 0; i < count; i += 2) {
+			lastIndex = i;
+			last = tree[i].maxEnd = tree[i].end;
+		}
+
+		int level = 1;
+
+		for (; ((size_t) 1 << level) <= count; level++) {
+			size_t half = (size_t) 1 << (level - 1);
+
+			for (size_t i = (half << 1) - 1; i < count; i += half << 2) {
+				uint32_t left = tree[i - half].maxEnd;
+				uint32_t right = i + half < count ? tree[i + half].maxEnd : last;
+				tree[i].maxEnd = std::max(tree[i].end, std::max(left, right));
+			}
+
+			lastIndex = (lastIndex >> level & 1) ? lastIndex - half : lastIndex + half;
+
+			if (lastIndex < count && tree[lastIndex].maxEnd > last) {
+				last = tree[lastIndex].maxEnd;
+			}
+		}
+
+		return level - 1;
+	}
+
+	bool SourceIndex::blockStartsAfter(size_t offset, const Block& block) {
+		return offset < block.offset;
+	}
+
+	bool SourceIndex::nodeStartsAfter(size_t node, const Block& block) {
+		return node < block.firstNode;
+	}
+
+}
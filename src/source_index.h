@@ -0,0 +1,164 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_SOURCE_INDEX_H
+#define BYPASS_SOURCE_INDEX_H
+
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include "document.h"
+#include "element.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief Finds the `Element` at a given offset into the markdown of a
+	        `Document`, for hit testing.
+
+	 Nodes are numbered in document order, each before its descendants, as in
+	 `PlainText`. Ranges are those of `Element::getSourceOffset` made absolute
+	 with `Document::getOffset`, and clipped to the range of the parent so
+	 that they nest. Siblings may still overlap, since the parser gives a
+	 span the range of its first child and places the later children beside
+	 it, so the deepest node holding an offset need not be the last one to
+	 start before it. A lookup is a binary search over the top-level
+	 elements, then a search of an implicit interval tree over the nodes of
+	 one block: the starts sorted by offset, where each one also keeps the
+	 greatest end below it in the tree.
+
+	 Each top-level element is indexed on its own with offsets relative to
+	 its start, so an index built against the previous one after
+	 `Parser::reparse` copies the nodes of every element the two documents
+	 share and only walks the new ones.
+
+	 Building the index parses the inline text of deferred elements. The
+	 index keeps the top-level elements alive and may outlive the document.
+	 */
+	class SourceIndex {
+	public:
+		static const size_t NO_NODE = (size_t) -1;
+
+		/*!
+		 \brief Creates an empty `SourceIndex`.
+		 */
+		SourceIndex();
+
+		/*!
+		 \brief Creates the index of a document.
+		 */
+		SourceIndex(const Document& document);
+
+		/*!
+		 \brief Creates the index of a document, reusing the nodes of the
+		        top-level elements it shares with an earlier one.
+		 \param document The document to index.
+		 \param previous The index of a document that `document` was reparsed
+		                 from.
+		 */
+		SourceIndex(const Document& document, const SourceIndex& previous);
+
+		size_t getNodeCount() const;
+		Type getNodeType(size_t node) const;
+
+		/*!
+		 \brief Gets the parent of a node, or `NO_NODE` for a top-level element.
+		 */
+		size_t getNodeParent(size_t node) const;
+
+		/*!
+		 \brief Gets the index in the document of the top-level element that
+		        holds a node.
+		 */
+		size_t getNodeBlock(size_t node) const;
+
+		/*!
+		 \brief Gets the node of a top-level element.
+		 \param i The index of the element in the document.
+		 */
+		size_t getBlockNode(size_t i) const;
+
+		/*!
+		 \brief Gets where a node starts in the markdown.
+		 */
+		size_t getNodeOffset(size_t node) const;
+
+		/*!
+		 \brief Gets the length of the markdown of a node, or 0 when the node
+		        has no known range.
+		 */
+		size_t getNodeLength(size_t node) const;
+
+		/*!
+		 \brief Gets a copy of the element of a node.
+		 */
+		Element getElement(size_t node) const;
+
+		/*!
+		 \brief Gets the deepest node whose markdown holds the given byte.
+		 \param offset An offset into the markdown.
+		 \return The node, or `NO_NODE` for an offset between top-level
+		         elements or past the end.
+		 */
+		size_t getNode(size_t offset) const;
+	private:
+		static const uint32_t NO_PARENT = (uint32_t) -1;
+
+		// Parents are numbered from the first node of the block, and ranges
+		// are relative to the start of the block, so that the nodes of a
+		// block can be copied as they are.
+		struct Node {
+			const Element* element;
+			uint32_t parent;
+			uint32_t depth;
+			uint32_t offset;
+			uint32_t length;
+		};
+
+		// The range of a node, ordered by offset and then by node. Within a
+		// block the starts form an implicit tree, in which the node at index
+		// i has level k when its lowest k bits are set, and `maxEnd` is the
+		// greatest end in the subtree under it.
+		struct Start {
+			uint32_t offset;
+			uint32_t end;
+			uint32_t maxEnd;
+			uint32_t node;
+		};
+
+		struct Block {
+			std::shared_ptr<const Element> element;
+			size_t offset;
+			size_t firstNode;
+			size_t nodeCount;
+			size_t firstStart;
+			size_t startCount;
+			int rootLevel;
+		};
+
+		std::vector<Node> nodes;
+		std::vector<Start> starts;
+		std::vector<Block> blocks;
+		void index(const Document& document, const SourceIndex* previous);
+		void add(const Element& element, uint32_t parent, size_t first);
+		static int buildTree(Start* starts, size_t count);
+		static bool blockStartsAfter(size_t offset, const Block& block);
+		static bool nodeStartsAfter(size_t node, const Block& block);
+	};
+
+}
+
+#endif // BYPASS_SOURCE_INDEX_H
@@ -0,0 +1,365 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+#include "streaming_parser.h"
+#include "utf8.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief Something markdown can be read from in chunks.
+	 */
+	class StreamingParser::Source {
+	public:
+		virtual ~Source() {}
+
+		/*!
+		 \brief Reads up to `size` bytes, returning 0 at the end of the input.
+		 */
+		virtual size_t read(char* data, size_t size) = 0;
+
+		/*!
+		 \brief Remembers the current position, if the source is seekable.
+		 \return Whether or not the source can be rewound.
+		 */
+		virtual bool mark() = 0;
+
+		/*!
+		 \brief Returns to the position remembered by `mark`.
+		 */
+		virtual bool rewind() = 0;
+	};
+
+	class StreamingParser::StreamSource : public StreamingParser::Source {
+	public:
+		StreamSource(std::istream& in) : in(in), position(-1) {}
+
+		size_t read(char* data, size_t size) {
+			in.read(data, size);
+			return in.gcount();
+		}
+
+		bool mark() {
+			position = in.tellg();
+			return position != std::streampos(-1);
+		}
+
+		bool rewind() {
+			in.clear();
+			in.seekg(position);
+			return !in.fail();
+		}
+
+	private:
+		std::istream& in;
+		std::streampos position;
+	};
+
+	class StreamingParser::DescriptorSource : public StreamingParser::Source {
+	public:
+		DescriptorSource(int fd) : fd(fd), position(-1) {}
+
+		size_t read(char* data, size_t size) {
+			ssize_t count;
+
+			do {
+				count = ::read(fd, data, size);
+			} while (count < 0 && errno == EINTR);
+
+			return count > 0 ? count : 0;
+		}
+
+		bool mark() {
+			position = lseek(fd, 0, SEEK_CUR);
+			return position != -1;
+		}
+
+		bool rewind() {
+			return lseek(fd, position, SEEK_SET) != -1;
+		}
+
+	private:
+		int fd;
+		off_t position;
+	};
+
+	StreamingParser::StreamingParser(Listener& listener)
+	: listener(listener)
+	, parser()
+	, references()
+	, tail()
+	, partial()
+	{
+		finalizedCount = 0;
+		collectReferences = true;
+		reportTail = true;
+	}
+
+	StreamingParser::~StreamingParser() {
+
+	}
+
+	void StreamingParser::feed(const char* chunk, size_t length) {
+		if (chunk && length) {
+			appendTail(chunk, length);
+			parseTail(false);
+		}
+	}
+
+	void StreamingParser::feed(const std::string& chunk) {
+		feed(chunk.data(), chunk.size());
+	}
+
+	void StreamingParser::finish() {
+		if (!partial.empty()) {
+			tail.append(repairUtf8(partial.data(), partial.size()));
+			partial.clear();
+		}
+
+		parseTail(true);
+	}
+
+	void StreamingParser::read(std::istream& in, size_t chunkSize) {
+		StreamSource source(in);
+		read(source, chunkSize);
+	}
+
+	void StreamingParser::read(int fd, size_t chunkSize) {
+		DescriptorSource source(fd);
+		read(source, chunkSize);
+	}
+
+	void StreamingParser::read(Source& source, size_t chunkSize) {
+		std::vector<char> chunk(chunkSize > 0 ? chunkSize : READ_UNIT);
+		size_t count;
+
+		if (source.mark()) {
+			scanReferences(source, chunk.size());
+
+			if (source.rewind()) {
+				collectReferences = false;
+			} else {
+				references.clear();
+			}
+		}
+
+		reportTail = false;
+
+		while ((count = source.read(&chunk[0], chunk.size())) > 0) {
+			feed(&chunk[0], count);
+		}
+
+		finish();
+
+		reportTail = true;
+		collectReferences = true;
+	}
+
+	// Whether a line, of which only `length` bytes may have been read yet,
+	// can still start a reference definition: up to three spaces and `[`.
+	static bool mayStartReference(const char* line, size_t length) {
+		for (size_t i = 0; i < 4; i++) {
+			if (i == length) {
+				return true;
+			}
+
+			if (line[i] != ' ') {
+				return line[i] == '[';
+			}
+		}
+
+		return false;
+	}
+
+	void StreamingParser::scanReferences(Source& source, size_t chunkSize) {
+		struct buf *ib = bufnew(chunkSize);
+		struct buf *ob = bufnew(OUTPUT_UNIT);
+		bool more = true;
+		bool skipLine = false;
+
+		while (more && bufgrow(ib, ib->size + chunkSize)) {
+			size_t count = source.read(ib->data + ib->size, chunkSize);
+			ib->size += count;
+			more = count > 0;
+
+			// The rest of a line dropped below is skipped, so that it is not
+			// taken for the start of one.
+
+			if (skipLine) {
+				size_t end = 0;
+
+				while (end < ib->size && ib->data[end] != '\n' && ib->data[end] != '\r') {
+					end++;
+				}
+
+				skipLine = end == ib->size;
+				bufslurp(ib, end);
+			}
+
+			// A definition may span up to three lines, so the last two
+			// complete lines and any partial one are kept for the next chunk.
+
+			size_t limit = ib->size;
+
+			if (more) {
+				size_t newlines = 0;
+
+				for (limit = ib->size; limit > 0; limit--) {
+					if (ib->data[limit - 1] == '\n' && ++newlines == 3) {
+						break;
+					}
+				}
+
+				// They are only needed while one of them can start a
+				// definition, and a partial line is not kept past a limit, so
+				// that a long line cannot grow the buffer without bound.
+
+				size_t lineStart = ib->size;
+
+				while (lineStart > limit && ib->data[lineStart - 1] != '\n') {
+					lineStart--;
+				}
+
+				bool needed = mayStartReference(ib->data + lineStart, ib->size - lineStart);
+
+				for (size_t i = limit; i < lineStart && !needed; i = std::find(ib->data + i, ib->data + lineStart, '\n') - ib->data + 1) {
+					needed = mayStartReference(ib->data + i, lineStart - i);
+				}
+
+				if (!needed || ib->size - lineStart > REFERENCE_LINE_LIMIT) {
+					limit = ib->size;
+					skipLine = lineStart < ib->size;
+				}
+			}
+
+			bufslurp(ib, mkd_references(ob, ib, limit));
+		}
+
+		references.append(repairUtf8(ob->data, ob->size));
+
+		bufrelease(ib);
+		bufrelease(ob);
+	}
+
+	size_t StreamingParser::getFinalizedCount() {
+		return finalizedCount;
+	}
+
+	void StreamingParser::appendTail(const char* chunk, size_t length) {
+		// The tail is kept valid UTF-8, so that the parser never repairs it
+		// and its offsets stay offsets into the tail. A character cut by the
+		// end of the chunk waits for the next one.
+
+		if (!partial.empty()) {
+			partial.append(chunk, length);
+			chunk = partial.data();
+			length = partial.size();
+		}
+
+		size_t complete = completeUtf8Length(chunk, length);
+
+		if (findInvalidUtf8(chunk, complete) == complete) {
+			tail.append(chunk, complete);
+		} else {
+			tail.append(repairUtf8(chunk, complete));
+		}
+
+		partial.assign(chunk + complete, length - complete);
+	}
+
+	void StreamingParser::parseTail(bool final) {
+		std::string input = references + tail;
+		std::vector<size_t> starts;
+
+		// Parse block by block, remembering where each block started so that
+		// the input can be cut at a block boundary.
+
+		parser.begin(input);
+
+		for (bool more = true; more; ) {
+			size_t start = parser.getOffset();
+			more = parser.step(0);
+
+			while (starts.size() < parser.getDocument().size()) {
+				starts.push_back(start);
+			}
+		}
+
+		Document& document = parser.getDocument();
+		size_t frozen = document.size();
+
+		if (!final) {
+			// A block is settled once the first line of the block after it is
+			// complete; the block starting on the last complete line is not.
+
+			size_t last = input.rfind('\n');
+			frozen = 0;
+
+			for (size_t i = starts.size(); i > 0; i--) {
+				if (last != std::string::npos && starts[i - 1] <= last) {
+					frozen = i - 1;
+					break;
+				}
+			}
+
+			while (frozen > 0 && starts[frozen - 1] == starts[frozen]) {
+				frozen--;
+			}
+		}
+
+		std::vector<Element> finalized;
+		std::vector<Element> open;
+
+		for (size_t i = 0; i < document.size(); i++) {
+			if (i < frozen) {
+				finalized.push_back(document[i]);
+			} else if (reportTail) {
+				open.push_back(document[i]);
+			}
+		}
+
+		if (final) {
+			tail.clear();
+		} else if (frozen > 0) {
+			size_t cut = starts[frozen] - references.size();
+
+			if (collectReferences) {
+				struct buf *ib = bufnew(INPUT_UNIT);
+				struct buf *ob = bufnew(OUTPUT_UNIT);
+				bufput(ib, tail.data(), cut);
+				mkd_references(ob, ib, ib->size);
+				references.append(ob->data, ob->size);
+				bufrelease(ib);
+				bufrelease(ob);
+			}
+
+			tail.erase(0, cut);
+		}
+
+		if (!finalized.empty()) {
+			listener.blocksFinalized(finalizedCount, finalized);
+			finalizedCount += finalized.size();
+		}
+
+		if (reportTail) {
+			listener.tailReplaced(finalizedCount, open);
+		}
+	}
+
+}
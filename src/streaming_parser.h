@@ -0,0 +1,156 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_STREAMING_PARSER_H
+#define BYPASS_STREAMING_PARSER_H
+
+#include <string>
+#include <vector>
+#include <istream>
+#include "element.h"
+#include "parser.h"
+
+#define READ_UNIT 65536
+#define REFERENCE_LINE_LIMIT (1 << 20)
+
+namespace Bypass {
+
+	/*!
+	 \brief A parser for markdown that arrives in pieces and is only ever
+	        appended to.
+
+	 Top-level blocks are numbered in document order, and that number serves as
+	 a stable id for the block. A block is finalized once the input that follows
+	 it can no longer change how it parses, which is the case as soon as the
+	 first line of the next block is complete. Finalized blocks are reported
+	 exactly once and are never parsed again; only the open tail of the input
+	 is re-parsed by each call to `feed`.
+
+	 Reference definitions found in finalized input are kept and apply to every
+	 later block. A definition that arrives after a block using it has been
+	 finalized does not apply retroactively.
+
+	 Very large inputs can be parsed with `read`, which only ever holds the
+	 open tail of the input, the block being parsed, and the reference
+	 definitions in memory.
+	 */
+	class StreamingParser {
+	public:
+
+		/*!
+		 \brief Receives the blocks produced by a `StreamingParser`.
+		 */
+		class Listener {
+		public:
+			virtual ~Listener() {}
+
+			/*!
+			 \brief Called with blocks that will not change anymore.
+			 \param firstId The id of the first block in `blocks`.
+			 \param blocks The finalized blocks, in document order.
+			 */
+			virtual void blocksFinalized(size_t firstId, const std::vector<Element>& blocks) = 0;
+
+			/*!
+			 \brief Called with the provisional blocks that follow the finalized
+			        ones, replacing any tail that was previously reported.
+			 \param firstId The id of the first block in `blocks`.
+			 \param blocks The provisional blocks, in document order. This is
+			               empty once `finish` has been called.
+			 */
+			virtual void tailReplaced(size_t firstId, const std::vector<Element>& blocks) = 0;
+		};
+
+		/*!
+		 \brief Creates a `StreamingParser` that reports to the given listener.
+		 \param listener The listener to report blocks to.
+		 */
+		StreamingParser(Listener& listener);
+
+		/*!
+		 \brief Destroys the `StreamingParser`.
+		 */
+		~StreamingParser();
+
+		/*!
+		 \brief Appends a chunk of markdown to the input.
+		 \param chunk The chunk of markdown.
+		 \param length The length of the chunk in bytes.
+		 */
+		void feed(const char* chunk, size_t length);
+
+		/*!
+		 \brief Appends a chunk of markdown to the input.
+		 \param chunk The chunk of markdown.
+		 */
+		void feed(const std::string& chunk);
+
+		/*!
+		 \brief Signals the end of the input, finalizing every remaining block.
+		 */
+		void finish();
+
+		/*!
+		 \brief Reads and parses markdown from a stream until it ends.
+
+		 Every block is reported through `Listener::blocksFinalized` as soon as
+		 it is settled; the provisional tail is not reported. When the stream
+		 is seekable it is read twice, first to collect every reference
+		 definition and then to parse, so that links resolve exactly as they
+		 would with `Parser::parse`. Otherwise a definition only applies to the
+		 blocks that follow it.
+
+		 \param in The stream to read markdown from.
+		 \param chunkSize The number of bytes to read at a time.
+		 */
+		void read(std::istream& in, size_t chunkSize = READ_UNIT);
+
+		/*!
+		 \brief Reads and parses markdown from a file descriptor until it ends.
+
+		 This behaves like the `std::istream` variant, and seeks with `lseek`.
+
+		 \param fd The file descriptor to read markdown from.
+		 \param chunkSize The number of bytes to read at a time.
+		 */
+		void read(int fd, size_t chunkSize = READ_UNIT);
+
+		/*!
+		 \brief The number of blocks that have been finalized so far.
+		 */
+		size_t getFinalizedCount();
+
+	private:
+		class Source;
+		class StreamSource;
+		class DescriptorSource;
+		Listener& listener;
+		Parser parser;
+		std::string references;
+		std::string tail;
+		std::string partial;
+		size_t finalizedCount;
+		bool collectReferences;
+		bool reportTail;
+		void appendTail(const char* chunk, size_t length);
+		void parseTail(bool final);
+		void read(Source& source, size_t chunkSize);
+		void scanReferences(Source& source, size_t chunkSize);
+	};
+
+}
+
+#endif // BYPASS_STREAMING_PARSER_H
@@ -0,0 +1,144 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <algorithm>
+#include <cstring>
+#include "utf16.h"
+
+namespace Bypass {
+
+	static const uint64_t HIGHS = 0x8080808080808080ULL;
+
+	// A byte starts a character unless it is a continuation byte, 10xxxxxx,
+	// and a lead byte of 11110xxx adds the second unit of a surrogate pair.
+	static size_t unitsOf(unsigned char c) {
+		return ((c & 0xC0) != 0x80) + (c >= 0xF0);
+	}
+
+	size_t utf16Length(const char* data, size_t length) {
+		size_t units = 0;
+		size_t i = 0;
+
+		for (; i + 8 <= length; i += 8) {
+			uint64_t word;
+			memcpy(&word, data + i, 8);
+
+			if ((word & HIGHS) == 0) {
+				units += 8;
+				continue;
+			}
+
+			// Bit 7 of each byte, combined with the bits below it shifted
+			// up into place; nothing crosses into the next byte's bit 7.
+
+			uint64_t continuations = word & ~(word << 1) & HIGHS;
+			uint64_t fourByteLeads = word & (word << 1) & (word << 2) & (word << 3) & HIGHS;
+			units += 8 - __builtin_popcountll(continuations) + __builtin_popcountll(fourByteLeads);
+		}
+
+		for (; i < length; i++) {
+			units += unitsOf(data[i]);
+		}
+
+		return units;
+	}
+
+	Utf16Index::Utf16Index()
+	: checkpoints()
+	{
+		bytes = 0;
+		units = 0;
+	}
+
+	Utf16Index::Utf16Index(const char* data, size_t length)
+	: checkpoints()
+	{
+		bytes = 0;
+		units = 0;
+		append(data, length);
+	}
+
+	void Utf16Index::append(const char* data, size_t length) {
+		while (length > 0) {
+			size_t step = std::min(length, UTF16_CHECKPOINT_STRIDE - bytes % UTF16_CHECKPOINT_STRIDE);
+			units += utf16Length(data, step);
+			bytes += step;
+			data += step;
+			length -= step;
+
+			if (bytes % UTF16_CHECKPOINT_STRIDE == 0) {
+				checkpoints.push_back(units);
+			}
+		}
+	}
+
+	void Utf16Index::truncate(const char* data, size_t length) {
+		if (length >= bytes) {
+			return;
+		}
+
+		size_t kept = std::min(checkpoints.size(), length / UTF16_CHECKPOINT_STRIDE);
+		checkpoints.resize(kept);
+		bytes = kept * UTF16_CHECKPOINT_STRIDE;
+		units = kept > 0 ? checkpoints.back() : 0;
+		append(data + bytes, length - bytes);
+	}
+
+	size_t Utf16Index::getByteLength() const {
+		return bytes;
+	}
+
+	size_t Utf16Index::getLength() const {
+		return units;
+	}
+
+	size_t Utf16Index::toUtf16(const char* data, size_t byteOffset) const {
+		byteOffset = std::min(byteOffset, bytes);
+		size_t checkpoint = std::min(checkpoints.size(), byteOffset / UTF16_CHECKPOINT_STRIDE);
+		size_t start = checkpoint * UTF16_CHECKPOINT_STRIDE;
+		size_t base = checkpoint > 0 ? checkpoints[checkpoint - 1] : 0;
+		return base + utf16Length(data + start, byteOffset - start);
+	}
+
+	size_t Utf16Index::toUtf8(const char* data, size_t utf16Offset) const {
+		if (utf16Offset >= units) {
+			return bytes;
+		}
+
+		size_t checkpoint = std::upper_bound(checkpoints.begin(), checkpoints.end(), utf16Offset) - checkpoints.begin();
+		size_t position = checkpoint * UTF16_CHECKPOINT_STRIDE;
+		size_t count = checkpoint > 0 ? checkpoints[checkpoint - 1] : 0;
+
+		for (; position < bytes; position++) {
+			unsigned char c = data[position];
+
+			if ((c & 0xC0) != 0x80) {
+				if (count >= utf16Offset) {
+					return position;
+				}
+
+				count += unitsOf(c);
+			}
+		}
+
+		return bytes;
+	}
+
+	size_t Utf16Index::getFootprint() const {
+		return checkpoints.capacity() * sizeof(uint32_t);
+	}
+
+}
@@ -0,0 +1,111 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_UTF16_H
+#define BYPASS_UTF16_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#define UTF16_CHECKPOINT_STRIDE 64
+
+namespace Bypass {
+
+	/*!
+	 \brief Counts the UTF-16 code units that UTF-8 text converts to.
+
+	 Characters of four bytes count as two units, a surrogate pair. ASCII is
+	 counted eight bytes at a time.
+	 */
+	size_t utf16Length(const char* data, size_t length);
+
+	/*!
+	 \brief Converts between UTF-8 byte offsets and UTF-16 offsets of a text
+	        in constant time.
+
+	 The index keeps the UTF-16 offset of every `UTF16_CHECKPOINT_STRIDE`th
+	 byte, so a conversion scans at most that many bytes from the nearest
+	 checkpoint. Text shorter than the stride needs no checkpoints at all.
+	 The text itself is not kept and is passed to each conversion.
+	 */
+	class Utf16Index {
+	public:
+
+		/*!
+		 \brief Creates the index of an empty text.
+		 */
+		Utf16Index();
+
+		/*!
+		 \brief Creates the index of a text.
+		 */
+		Utf16Index(const char* data, size_t length);
+
+		/*!
+		 \brief Extends the index as bytes are appended to its text.
+		 \param data The bytes appended.
+		 \param length The number of bytes appended.
+		 */
+		void append(const char* data, size_t length);
+
+		/*!
+		 \brief Shortens the index as its text is shortened.
+		 \param data The text.
+		 \param length The new length of the text, in bytes.
+		 */
+		void truncate(const char* data, size_t length);
+
+		/*!
+		 \brief Gets the length of the text in bytes of UTF-8.
+		 */
+		size_t getByteLength() const;
+
+		/*!
+		 \brief Gets the length of the text in UTF-16 code units.
+		 */
+		size_t getLength() const;
+
+		/*!
+		 \brief Converts a byte offset to a UTF-16 offset.
+		 \param data The text.
+		 \param byteOffset An offset at the start of a character, or the end
+		                   of the text.
+		 */
+		size_t toUtf16(const char* data, size_t byteOffset) const;
+
+		/*!
+		 \brief Converts a UTF-16 offset to a byte offset.
+		 \param data The text.
+		 \param utf16Offset An offset into the text in UTF-16 code units. One
+		                    that falls inside a surrogate pair maps to the
+		                    character after it.
+		 */
+		size_t toUtf8(const char* data, size_t utf16Offset) const;
+
+		/*!
+		 \brief Gets the heap memory held by the index, in bytes.
+		 */
+		size_t getFootprint() const;
+	private:
+		size_t bytes;
+		size_t units;
+		std::vector<uint32_t> checkpoints;
+	};
+
+}
+
+#endif // BYPASS_UTF16_H
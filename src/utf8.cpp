@@ -0,0 +1,164 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstring>
+#include <stdint.h>
+#include "utf8.h"
+
+namespace Bypass {
+
+	static const uint64_t HIGHS = 0x8080808080808080ULL;
+
+	static const char REPLACEMENT_CHARACTER[] = "\xef\xbf\xbd";
+
+	// Measures the sequence that starts with a byte of 0x80 or above: its
+	// length when it is valid, or the length of its longest valid prefix,
+	// at least one byte, when it is not.
+	static size_t scanSequence(const unsigned char* s, size_t remaining, bool& valid) {
+		unsigned char c = s[0];
+		unsigned char low = 0x80;
+		unsigned char high = 0xBF;
+		size_t length;
+
+		if (c >= 0xC2 && c <= 0xDF) {
+			length = 2;
+		} else if (c >= 0xE0 && c <= 0xEF) {
+			length = 3;
+			low = c == 0xE0 ? 0xA0 : low;
+			high = c == 0xED ? 0x9F : high;
+		} else if (c >= 0xF0 && c <= 0xF4) {
+			length = 4;
+			low = c == 0xF0 ? 0x90 : low;
+			high = c == 0xF4 ? 0x8F : high;
+		} else {
+			valid = false;
+			return 1;
+		}
+
+		for (size_t i = 1; i < length; i++) {
+			if (i >= remaining || s[i] < low || s[i] > high) {
+				valid = false;
+				return i;
+			}
+
+			low = 0x80;
+			high = 0xBF;
+		}
+
+		valid = true;
+		return length;
+	}
+
+	// Skips the ASCII at the start of text, sixteen bytes at a time and then
+	// one at a time.
+	static size_t skipAscii(const unsigned char* s, size_t length) {
+		size_t i = 0;
+
+		for (; i + 16 <= length; i += 16) {
+			uint64_t first;
+			uint64_t second;
+			memcpy(&first, s + i, 8);
+			memcpy(&second, s + i + 8, 8);
+
+			if ((first | second) & HIGHS) {
+				break;
+			}
+		}
+
+		while (i < length && s[i] < 0x80) {
+			i++;
+		}
+
+		return i;
+	}
+
+	size_t findInvalidUtf8(const char* data, size_t length) {
+		const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+		size_t i = 0;
+
+		while (i < length) {
+			i += skipAscii(s + i, length - i);
+
+			if (i == length) {
+				break;
+			}
+
+			bool valid;
+			size_t scanned = scanSequence(s + i, length - i, valid);
+
+			if (!valid) {
+				return i;
+			}
+
+			i += scanned;
+		}
+
+		return length;
+	}
+
+	bool isValidUtf8(const char* data, size_t length) {
+		return findInvalidUtf8(data, length) == length;
+	}
+
+	size_t completeUtf8Length(const char* data, size_t length) {
+		const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+
+		for (size_t back = 1; back <= 3 && back <= length; back++) {
+			if (s[length - back] >= 0xC0) {
+				bool valid;
+				size_t scanned = scanSequence(s + length - back, back, valid);
+				return !valid && scanned == back ? length - back : length;
+			}
+
+			if (s[length - back] < 0x80) {
+				break;
+			}
+		}
+
+		return length;
+	}
+
+	std::string repairUtf8(const char* data, size_t length) {
+		const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+		std::string repaired;
+		size_t start = 0;
+		size_t i = 0;
+		repaired.reserve(length + 16);
+
+		while (i < length) {
+			i += skipAscii(s + i, length - i);
+
+			if (i == length) {
+				break;
+			}
+
+			bool valid;
+			size_t scanned = scanSequence(s + i, length - i, valid);
+
+			if (!valid) {
+				repaired.append(data + start, i - start);
+				repaired.append(REPLACEMENT_CHARACTER, 3);
+				start = i + scanned;
+			}
+
+			i += scanned;
+		}
+
+		repaired.append(data + start, length - start);
+		return repaired;
+	}
+
+}
@@ -0,0 +1,61 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_UTF8_H
+#define BYPASS_UTF8_H
+
+#include <cstddef>
+#include <string>
+
+namespace Bypass {
+
+	/*!
+	 \brief Finds the first byte of text that is not well-formed UTF-8.
+
+	 Overlong forms, surrogates and code points above U+10FFFF are invalid,
+	 as is a sequence cut short by the end of the text. ASCII is checked
+	 sixteen bytes at a time.
+
+	 \return The offset of the first invalid byte, or `length` when the text
+	         is valid.
+	 */
+	size_t findInvalidUtf8(const char* data, size_t length);
+
+	/*!
+	 \brief Indicates whether text is well-formed UTF-8.
+	 */
+	bool isValidUtf8(const char* data, size_t length);
+
+	/*!
+	 \brief Gets the length of text without the sequence it ends with, if
+	        that sequence is valid so far but cut short.
+
+	 Text that arrives in chunks can be checked up to this length, and the
+	 rest held back until the next chunk.
+	 */
+	size_t completeUtf8Length(const char* data, size_t length);
+
+	/*!
+	 \brief Copies text, replacing what is not well-formed UTF-8 with U+FFFD.
+
+	 Each maximal part of an invalid sequence becomes one replacement
+	 character, as the Unicode standard recommends.
+	 */
+	std::string repairUtf8(const char* data, size_t length);
+
+}
+
+#endif // BYPASS_UTF8_H
@@ -0,0 +1,253 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <algorithm>
+#include "utf8.h"
+#include "window_parser.h"
+
+static void scan_block(struct buf *ob, struct buf *text, void *opaque);
+static void scan_header(struct buf *ob, struct buf *text, int level, void *opaque);
+static void scan_list(struct buf *ob, struct buf *text, int flags, void *opaque);
+static int scan_defer_inline(struct buf *ob, struct buf *text, void *opaque);
+
+// Only the block callbacks that produce a top-level element in a `Document`
+// are set; each one marks its output buffer, so that the size of the
+// top-level output tells how many elements a step produced. Inline text is
+// never parsed.
+
+struct mkd_renderer scan_callbacks = {
+	/* document-level callbacks */
+	NULL,                 // prolog
+	NULL,                 // epilogue
+
+	/* block-level callbacks */
+	scan_block,           // block code
+	scan_block,           // block quote
+	NULL,                 // block html
+	scan_header,          // header
+	NULL,                 // hrule
+	scan_list,            // list
+	NULL,                 // listitem
+	scan_block,           // paragraph
+	NULL,                 // table
+	NULL,                 // table cell
+	NULL,                 // table row
+
+	/* span-level callbacks */
+	NULL,                 // autolink
+	NULL,                 // codespan
+	NULL,                 // double emphasis
+	NULL,                 // emphasis
+	NULL,                 // image
+	NULL,                 // line break
+	NULL,                 // link
+	NULL,                 // raw html tag
+	NULL,                 // triple emphasis
+
+	/* low-level callbacks */
+	NULL,                 // entity
+	NULL,                 // normal text
+
+	/* control callbacks */
+	NULL,                 // halt
+	scan_defer_inline,    // defer inline
+
+	/* position callback */
+	NULL,                 // source
+
+	/* renderer data */
+	64, // max stack
+	NULL,
+	NULL // opaque
+};
+
+namespace Bypass {
+
+	WindowParser::WindowParser()
+	: markdown()
+	, references()
+	, groups()
+	, blocks()
+	, parser()
+	{
+
+	}
+
+	WindowParser::~WindowParser() {
+
+	}
+
+	void WindowParser::load(const char* mkd) {
+		markdown = mkd ? mkd : "";
+		references.clear();
+
+		// Blocks are parsed from the text as Parser would repair it, so that
+		// their offsets match.
+
+		if (!isValidUtf8(markdown.data(), markdown.size())) {
+			markdown = repairUtf8(markdown.data(), markdown.size());
+		}
+
+		groups.clear();
+		blocks.clear();
+
+		struct buf *ib = bufnew(INPUT_UNIT);
+		struct buf *ob = bufnew(OUTPUT_UNIT);
+		bufput(ib, markdown.data(), markdown.size());
+
+		struct mkd_document *scan = mkd_document_new(ib, &scan_callbacks);
+		size_t refBegin, refEnd;
+
+		for (size_t i = 0; mkd_document_reference(scan, i, &refBegin, &refEnd); i++) {
+			references.append(markdown, refBegin, refEnd - refBegin);
+			references.push_back('\n');
+		}
+
+		while (mkd_document_remaining(scan)) {
+			Group group;
+			group.offset = mkd_document_offset(scan);
+			group.firstBlock = blocks.size();
+
+			ob->size = 0;
+			mkd_document_step(ob, scan, 0);
+
+			// Steps that produce no element, such as horizontal rules, are
+			// parsed along with the group before them.
+
+			if (ob->size > 0) {
+				groups.push_back(group);
+				blocks.resize(blocks.size() + ob->size);
+			}
+		}
+
+		mkd_document_free(scan);
+		bufrelease(ib);
+		bufrelease(ob);
+	}
+
+	void WindowParser::load(const std::string& markdown) {
+		load(markdown.c_str());
+	}
+
+	size_t WindowParser::getBlockCount() {
+		return blocks.size();
+	}
+
+	size_t WindowParser::getBlockOffset(size_t i) {
+		return groups[findGroup(i)].offset;
+	}
+
+	std::vector<Element> WindowParser::getBlocks(size_t first, size_t count) {
+		std::vector<Element> result;
+
+		if (first >= blocks.size() || count == 0) {
+			return result;
+		}
+
+		size_t last = std::min(blocks.size(), first + count) - 1;
+		size_t lastGroup = findGroup(last);
+
+		// Neighbouring groups that have not been parsed yet are parsed in
+		// one go.
+
+		for (size_t g = findGroup(first); g <= lastGroup; g++) {
+			if (!blocks[groups[g].firstBlock]) {
+				size_t end = g;
+
+				while (end < lastGroup && !blocks[groups[end + 1].firstBlock]) {
+					end++;
+				}
+
+				parseGroups(g, end);
+				g = end;
+			}
+		}
+
+		for (size_t i = first; i <= last; i++) {
+			result.push_back(*blocks[i]);
+		}
+
+		return result;
+	}
+
+	bool WindowParser::isParsed(size_t i) {
+		return blocks[i] != NULL;
+	}
+
+	size_t WindowParser::findGroup(size_t block) {
+		size_t lo = 0, hi = groups.size();
+
+		while (hi - lo > 1) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if (groups[mid].firstBlock <= block) {
+				lo = mid;
+			} else {
+				hi = mid;
+			}
+		}
+
+		return lo;
+	}
+
+	void WindowParser::parseGroups(size_t first, size_t last) {
+		size_t begin = groups[first].offset;
+		size_t end = last + 1 < groups.size() ? groups[last + 1].offset : markdown.size();
+		size_t firstBlock = groups[first].firstBlock;
+		size_t blockCount = (last + 1 < groups.size() ? groups[last + 1].firstBlock : blocks.size()) - firstBlock;
+
+		// The reference definitions of the whole input are put in front, so
+		// that links resolve as they would in a full parse.
+
+		parser.begin(references + markdown.substr(begin, end - begin));
+		while (parser.step((size_t) -1));
+		const Document& document = parser.getDocument();
+
+		// Spans that libsoldout backs out of are left behind by Parser as
+		// stray top-level elements, which the scan does not count.
+
+		size_t next = 0;
+
+		for (size_t i = 0; i < document.blocks.size() && next < blockCount; i++) {
+			if (document.blocks[i].element->isBlockElement()) {
+				blocks[firstBlock + next++] = document.blocks[i].element;
+			}
+		}
+
+		for (; next < blockCount; next++) {
+			blocks[firstBlock + next] = std::make_shared<const Element>();
+		}
+	}
+
+}
+
+// Scan callbacks
+
+static void scan_block(struct buf *ob, struct buf *text, void *opaque) {
+	bufputc(ob, '.');
+}
+
+static void scan_header(struct buf *ob, struct buf *text, int level, void *opaque) {
+	bufputc(ob, '.');
+}
+
+static void scan_list(struct buf *ob, struct buf *text, int flags, void *opaque) {
+	bufputc(ob, '.');
+}
+
+static int scan_defer_inline(struct buf *ob, struct buf *text, void *opaque) {
+	return 1;
+}
@@ -0,0 +1,131 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_WINDOW_PARSER_H
+#define BYPASS_WINDOW_PARSER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "element.h"
+#include "parser.h"
+
+namespace Bypass {
+
+	/*!
+	 \brief A parser that only fully parses the top-level blocks that are
+	        asked for.
+
+	 `load` runs a block-level scan over the whole input which finds where the
+	 top-level blocks start and how many there are, without parsing any
+	 inline text or building any elements. Ranges of blocks are then parsed
+	 on demand by `getBlocks`, and kept, so that a virtualized list can jump
+	 anywhere in a large document for the cost of the scan and of the blocks
+	 it shows.
+
+	 Blocks returned by `getBlocks` are identical to the ones `Parser::parse`
+	 produces for the same markdown, including links to reference definitions
+	 found anywhere in the input, with one exception: spans that libsoldout
+	 parses and then backs out of, such as around entities, which `Parser`
+	 leaves behind as stray top-level elements, are not counted or returned.
+	 `getBlockCount` can then be less than the size of the `Document`.
+	 */
+	class WindowParser {
+	public:
+
+		/*!
+		 \brief Creates a `WindowParser` with no input.
+		 */
+		WindowParser();
+
+		/*!
+		 \brief Destroys the `WindowParser`.
+		 */
+		~WindowParser();
+
+		/*!
+		 \brief Scans the given markdown for top-level blocks, dropping any
+		        blocks parsed from earlier input.
+
+		 Input that is not well-formed UTF-8 is repaired first, as
+		 `Parser::parse` does by default, and offsets refer to the repaired
+		 text.
+
+		 \param markdown The textual representation of the markdown as a
+		                 character array.
+		 */
+		void load(const char* markdown);
+
+		/*!
+		 \brief Scans the given markdown for top-level blocks.
+		 \param markdown The textual representation of the markdown as a string.
+		 */
+		void load(const std::string& markdown);
+
+		/*!
+		 \brief The number of top-level blocks in the input.
+		 */
+		size_t getBlockCount();
+
+		/*!
+		 \brief Gets where a top-level block starts in the input.
+
+		 Blocks that libsoldout parses in one go, such as a paragraph and the
+		 setext header right after it, share an offset.
+
+		 \param i The index of the block.
+		 \return The offset in bytes of the block.
+		 */
+		size_t getBlockOffset(size_t i);
+
+		/*!
+		 \brief Gets a range of top-level blocks, parsing the ones that have
+		        not been parsed yet.
+		 \param first The index of the first block.
+		 \param count The number of blocks, clipped to the end of the input.
+		 \return The blocks, in document order.
+		 */
+		std::vector<Element> getBlocks(size_t first, size_t count);
+
+		/*!
+		 \brief Indicates whether a top-level block has been parsed yet.
+		 \param i The index of the block.
+		 */
+		bool isParsed(size_t i);
+
+	private:
+
+		/*!
+		 \brief The blocks libsoldout parses in one go, which are also parsed
+		        together here.
+		 */
+		struct Group {
+			size_t offset;
+			size_t firstBlock;
+		};
+
+		std::string markdown;
+		std::string references;
+		std::vector<Group> groups;
+		std::vector<std::shared_ptr<const Element> > blocks;
+		Parser parser;
+		size_t findGroup(size_t block);
+		void parseGroups(size_t first, size_t last);
+	};
+
+}
+
+#endif // BYPASS_WINDOW_PARSER_H
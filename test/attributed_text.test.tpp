@@ -0,0 +1,141 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include "attributed_text.h"
+
+using namespace Bypass;
+
+static bool
+hasRun(const AttributedBlock& block, size_t index, uint32_t start, uint32_t end, uint32_t style)
+{
+	return index < block.runs.size() && block.runs[index].start == start && block.runs[index].end == end
+		&& block.runs[index].style == style;
+}
+
+void
+test_blocks()
+{
+	AttributedText text = AttributedText::parse("# Title\n\nplain\n\n    code\n\n* a\n* b\n");
+
+	sut_assert(text.size() == 4);
+	sut_assert(text[0].type == HEADER && text[0].level == 1 && text[0].text == "Title");
+	sut_assert(text[1].type == PARAGRAPH && text[1].text == "plain" && text[1].runs.empty());
+	sut_assert(text[2].type == BLOCK_CODE && text[2].text == "code");
+	sut_assert(hasRun(text[2], 0, 0, 4, STYLE_CODE));
+	sut_assert(text[3].type == LIST && text[3].text == "a\nb");
+}
+
+void
+test_entities_are_kept()
+{
+	AttributedText text = AttributedText::parse("a &amp; *b*\n");
+
+	sut_assert(text[0].text == "a &amp; b");
+	sut_assert(hasRun(text[0], 0, 8, 9, STYLE_ITALIC));
+}
+
+void
+test_styles()
+{
+	AttributedText text = AttributedText::parse("*i* **b** ***bi*** `c` ~~s~~\n");
+	const AttributedBlock& block = text[0];
+
+	sut_assert(block.text == "i b bi c s");
+	sut_assert(block.runs.size() == 5);
+	sut_assert(hasRun(block, 0, 0, 1, STYLE_ITALIC));
+	sut_assert(hasRun(block, 1, 2, 3, STYLE_BOLD));
+	sut_assert(hasRun(block, 2, 4, 6, STYLE_BOLD | STYLE_ITALIC));
+	sut_assert(hasRun(block, 3, 7, 8, STYLE_CODE));
+	sut_assert(hasRun(block, 4, 9, 10, STYLE_STRIKETHROUGH));
+}
+
+void
+test_nested_spans_are_flattened()
+{
+	AttributedText text = AttributedText::parse("**a *b* c**\n");
+	const AttributedBlock& block = text[0];
+
+	sut_assert(block.text == "a b c");
+	sut_assert(block.runs.size() == 3);
+	sut_assert(hasRun(block, 0, 0, 2, STYLE_BOLD));
+	sut_assert(hasRun(block, 1, 2, 3, STYLE_BOLD | STYLE_ITALIC));
+	sut_assert(hasRun(block, 2, 3, 5, STYLE_BOLD));
+}
+
+void
+test_adjacent_runs_merge()
+{
+	AttributedText text = AttributedText::parse("**one two\nthree**\n");
+	const AttributedBlock& block = text[0];
+
+	sut_assert(block.runs.size() == 1);
+	sut_assert(hasRun(block, 0, 0, block.text.size(), STYLE_BOLD));
+}
+
+void
+test_links()
+{
+	AttributedText text = AttributedText::parse("[go **now**](http://a.com) or <http://b.com>\n");
+	const AttributedBlock& block = text[0];
+
+	sut_assert(block.text == "go now or http://b.com");
+	sut_assert(block.links.size() == 2);
+	sut_assert(block.links[0] == "http://a.com");
+	sut_assert(block.links[1] == "http://b.com");
+	sut_assert(block.runs.size() == 3);
+	sut_assert(hasRun(block, 0, 0, 3, STYLE_LINK) && block.runs[0].link == 0);
+	sut_assert(hasRun(block, 1, 3, 6, STYLE_LINK | STYLE_BOLD) && block.runs[1].link == 0);
+	sut_assert(hasRun(block, 2, 10, 22, STYLE_LINK) && block.runs[2].link == 1);
+}
+
+void
+test_linebreak()
+{
+	AttributedText text = AttributedText::parse("*a*  \nb  \nc\n");
+
+	sut_assert(text[0].text == "a\nb\nc");
+	sut_assert(hasRun(text[0], 0, 0, 1, STYLE_ITALIC));
+}
+
+void
+test_unstyled_copies()
+{
+	AttributedText text = AttributedText::parse("AT&amp;T ~x~\n");
+
+	sut_assert(text[0].text == "AT&amp;T ~x~");
+	sut_assert(text[0].runs.empty());
+}
+
+void
+test_utf16_offsets()
+{
+	AttributedText text = AttributedText::parse("\xc3\xa9t\xc3\xa9 **\xf0\x9f\x98\x80 b**\n");
+	const AttributedBlock& block = text[0];
+
+	sut_assert(block.utf16.getByteLength() == block.text.size());
+	sut_assert(block.utf16.getLength() == 8);
+	sut_assert(block.utf16.toUtf16(block.text.data(), block.runs[0].start) == 4);
+	sut_assert(block.utf16.toUtf16(block.text.data(), block.runs[0].end) == 8);
+}
+
+void
+test_empty()
+{
+	sut_assert(AttributedText::parse("").size() == 0);
+	sut_assert(AttributedText::parse((const char*) NULL).size() == 0);
+	sut_assert(AttributedText::parse("[a]: http://a.com\n").size() == 0);
+}
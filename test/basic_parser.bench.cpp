@@ -0,0 +1,112 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Compares the backends of BasicParser with each other and with Parser.
+// The NullBuilder row is the cost of libsoldout alone.
+//
+// Usage: basic_parser.bench [repetitions]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "basic_parser.h"
+#include "builders.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+class TextCounter : public Handler {
+public:
+	size_t bytes;
+
+	TextCounter() : bytes(0) {}
+
+	void text(const TextView& text) {
+		bytes += text.length;
+	}
+};
+
+static double
+seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void
+report(const char* name, size_t bytes, double elapsed)
+{
+	printf("%-14s %8.1f MB/s\n", name, bytes / elapsed / 1e6);
+}
+
+int
+main(int argc, char** argv)
+{
+	int repetitions = argc > 1 ? atoi(argv[1]) : 10;
+	std::string markdown;
+
+	while (markdown.size() < 1 << 20) {
+		markdown +=
+			"Header\n======\n\n"
+			"Some *emphasis*, a \"quote\" and a [link](http://example.com/path \"Title\").\n\n"
+			"* one\n* **two**\n* `three`\n\n"
+			"    code with\ttabs\\and backslashes\n\n";
+	}
+
+	size_t bytes = markdown.size() * repetitions;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		NullBuilder builder;
+		BasicParser<NullBuilder>(builder).parse(markdown);
+	}
+
+	report("NullBuilder", bytes, seconds(start));
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		TextCounter counter;
+		EventBuilder builder(counter);
+		BasicParser<EventBuilder>(builder).parse(markdown);
+	}
+
+	report("EventBuilder", bytes, seconds(start));
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		FlatBuilder builder;
+		BasicParser<FlatBuilder>(builder).parse(markdown);
+	}
+
+	report("FlatBuilder", bytes, seconds(start));
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		TreeBuilder builder;
+		BasicParser<TreeBuilder>(builder).parse(markdown);
+	}
+
+	report("TreeBuilder", bytes, seconds(start));
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		Parser parser;
+		parser.parse(markdown);
+	}
+
+	report("Parser", bytes, seconds(start));
+	return 0;
+}
@@ -0,0 +1,169 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include <stdio.h>
+#include "basic_parser.h"
+#include "builders.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+static void
+describe(std::string& out, Element element)
+{
+	char type[8];
+	snprintf(type, sizeof type, "%x(", element.getType());
+	out += type;
+	out += element.getText();
+
+	for (Element::AttributeMap::iterator it = element.attrBegin(); it != element.attrEnd(); ++it) {
+		out += " " + it->first + "=" + it->second;
+	}
+
+	for (size_t i = 0; i < element.size(); i++) {
+		describe(out, element[i]);
+	}
+
+	out += ")";
+}
+
+static std::string
+describe(Document document)
+{
+	std::string out;
+
+	for (size_t i = 0; i < document.size(); i++) {
+		describe(out, document[i]);
+	}
+
+	return out;
+}
+
+// Describes the subtree at node i of a flat array, returning the index
+// past it.
+static size_t
+describe(std::string& out, const FlatBuilder& flat, size_t i)
+{
+	const FlatNode& node = flat.getNodes()[i];
+	const std::string& strings = flat.getStrings();
+	char type[8];
+	snprintf(type, sizeof type, "%x(", node.type);
+	out += type;
+	out += strings.substr(node.textOffset, node.textLength);
+
+	for (size_t j = 0; j < node.attributeCount; j++) {
+		const FlatAttribute& attribute = flat.getAttributes()[node.firstAttribute + j];
+		out += " " + strings.substr(attribute.nameOffset, attribute.nameLength)
+			+ "=" + strings.substr(attribute.valueOffset, attribute.valueLength);
+	}
+
+	for (size_t child = i + 1; child < node.end; ) {
+		sut_assert(flat.getNodes()[child].parent == i);
+		child = describe(out, flat, child);
+	}
+
+	out += ")";
+	return node.end;
+}
+
+static std::string
+describe(const FlatBuilder& flat)
+{
+	std::string out;
+
+	for (size_t i = 0; i < flat.getNodes().size(); ) {
+		sut_assert(flat.getNodes()[i].parent == FlatNode::NO_PARENT);
+		i = describe(out, flat, i);
+	}
+
+	return out;
+}
+
+static const char* MARKDOWN =
+	"Header\n======\n\n"
+	"Some *emphasis*, **strong**, ~~struck~~ and `code`.  \n"
+	"A [link][a] and <http://example.com>.\n\n"
+	"* one\n* **two**\n  * nested\n\n"
+	"> quoted\n\n"
+	"    block code\n\n"
+	"[a]: http://example.com \"Example\"\n";
+
+void
+test_tree_builder_matches_parser()
+{
+	Parser parser;
+	Document expected = parser.parse(MARKDOWN);
+	TreeBuilder builder;
+	BasicParser<TreeBuilder>(builder).parse(MARKDOWN);
+	Document& document = builder.getDocument();
+
+	sut_assert(describe(document) == describe(expected));
+	sut_assert(document.size() == expected.size());
+
+	for (size_t i = 0; i < document.size(); i++) {
+		sut_assert(document.getOffset(i) == expected.getOffset(i));
+		sut_assert(document[i].getHash() == expected[i].getHash());
+	}
+}
+
+void
+test_flat_builder_matches_parser()
+{
+	Parser parser;
+	FlatBuilder builder;
+	BasicParser<FlatBuilder>(builder).parse(MARKDOWN);
+
+	sut_assert(describe(builder) == describe(parser.parse(MARKDOWN)));
+}
+
+void
+test_flat_nodes_are_in_document_order()
+{
+	FlatBuilder builder;
+	BasicParser<FlatBuilder>(builder).parse("# Title\n\ntext\n");
+	const std::vector<FlatNode>& nodes = builder.getNodes();
+
+	sut_assert(nodes.size() == 4);
+	sut_assert(nodes[0].type == HEADER && nodes[0].end == 2);
+	sut_assert(nodes[1].type == TEXT && nodes[1].parent == 0);
+	sut_assert(nodes[2].type == PARAGRAPH && nodes[2].end == 4);
+	sut_assert(builder.getStrings().substr(nodes[3].textOffset, nodes[3].textLength) == "text");
+}
+
+void
+test_null_builder()
+{
+	NullBuilder builder;
+	BasicParser<NullBuilder> parser(builder);
+	parser.parse(MARKDOWN);
+	parser.parse("");
+	parser.parse((const char*) NULL);
+
+	sut_assert(&parser.getBuilder() == &builder);
+}
+
+void
+test_builders_accumulate()
+{
+	TreeBuilder builder;
+	BasicParser<TreeBuilder> parser(builder);
+	parser.parse("one\n");
+	parser.parse("two\n");
+
+	sut_assert(builder.getDocument().size() == 2);
+	sut_assert(builder.getDocument().getId(1) == 1);
+}
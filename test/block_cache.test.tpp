@@ -0,0 +1,134 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include <stdio.h>
+#include "block_cache.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+static void
+describe(std::string& out, Element element)
+{
+	char type[8];
+	snprintf(type, sizeof type, "%x(", element.getType());
+	out += type;
+	out += element.getText();
+
+	for (Element::AttributeMap::iterator it = element.attrBegin(); it != element.attrEnd(); ++it) {
+		out += " " + it->first + "=" + it->second;
+	}
+
+	for (size_t i = 0; i < element.size(); i++) {
+		describe(out, element[i]);
+	}
+
+	out += ")";
+}
+
+static std::string
+describe(Document document)
+{
+	std::string out;
+
+	for (size_t i = 0; i < document.size(); i++) {
+		describe(out, document[i]);
+	}
+
+	return out;
+}
+
+static ParseOptions
+cached(BlockCache& cache)
+{
+	ParseOptions options;
+	options.blockCache = &cache;
+	return options;
+}
+
+void
+test_cached_parse_matches_uncached_parse()
+{
+	BlockCache cache(1 << 20);
+	Parser parser;
+	std::string markdown =
+		"> quoted *post*\n\nreply\n\n> quoted *post*\n\n"
+		"* one\n* two\n\nsetext\n---\n\n* one\n* two\n\n[link][a]\n\n[a]: http://example.com\n";
+
+	std::string expected = describe(parser.parse(markdown));
+	sut_assert(describe(parser.parse(markdown, cached(cache))) == expected);
+	sut_assert(describe(parser.parse(markdown, cached(cache))) == expected);
+}
+
+void
+test_repeated_blocks_hit()
+{
+	BlockCache cache(1 << 20);
+	Parser parser;
+	Document document = parser.parse("same\n\nsame\n\nother\n\nsame\n\n", cached(cache));
+	BlockCache::Statistics statistics = cache.getStatistics();
+
+	sut_assert(document.size() == 4);
+	sut_assert(document.getOffset(3) == 19);
+	sut_assert(statistics.hits == 2);
+	sut_assert(statistics.entries == 2);
+	sut_assert(cache.getHitRate() > 0.3);
+}
+
+void
+test_reference_definitions_are_part_of_the_key()
+{
+	BlockCache cache(1 << 20);
+	Parser parser;
+	Document first = parser.parse("[x][a]\n\n[a]: http://one.com\n", cached(cache));
+	Document second = parser.parse("[x][a]\n\n[a]: http://two.com\n", cached(cache));
+
+	sut_assert(first[0][0].getAttribute("link") == "http://one.com");
+	sut_assert(second[0][0].getAttribute("link") == "http://two.com");
+	sut_assert(cache.getStatistics().hits == 0);
+}
+
+void
+test_budget_evicts_least_recently_used()
+{
+	BlockCache probe(1 << 20);
+	Parser parser;
+	parser.parse("a block\n", cached(probe));
+	size_t entryBytes = probe.getStatistics().bytes;
+
+	BlockCache cache(entryBytes * 2 + entryBytes / 2);
+	parser.parse("a block\n\nb block\n\na block\n\nc block\n\nb block\n", cached(cache));
+	BlockCache::Statistics statistics = cache.getStatistics();
+
+	sut_assert(statistics.entries == 2);
+	sut_assert(statistics.evictions == 2);
+	sut_assert(statistics.hits == 1);
+	sut_assert(statistics.bytes <= entryBytes * 2 + entryBytes / 2);
+}
+
+void
+test_limits_bypass_the_cache()
+{
+	BlockCache cache(1 << 20);
+	Parser parser;
+	ParseOptions options = cached(cache);
+	options.maxVisibleChars = 100;
+	parser.parse("same\n\nsame\n", options);
+
+	sut_assert(cache.getStatistics().misses == 0);
+	sut_assert(cache.getStatistics().entries == 0);
+}
@@ -0,0 +1,128 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include <vector>
+#include "diff.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+static std::vector<DiffOperation> diffMarkdown(const std::string& before, const std::string& after) {
+	Parser parser;
+	Document old = parser.parse(before);
+	Document neu = parser.parse(after);
+	return diff(old, neu);
+}
+
+static std::vector<size_t> path(size_t first) {
+	return std::vector<size_t>(1, first);
+}
+
+static std::vector<size_t> path(size_t first, size_t second) {
+	std::vector<size_t> result = path(first);
+	result.push_back(second);
+	return result;
+}
+
+void
+test_equal_documents_have_no_operations()
+{
+	std::string markdown = "# Title\n\nSome *text*.\n\n* one\n* two\n";
+	sut_assert(diffMarkdown(markdown, markdown).empty());
+}
+
+void
+test_inserted_block()
+{
+	std::vector<DiffOperation> operations = diffMarkdown("one\n\nthree\n", "one\n\ntwo\n\nthree\n");
+
+	sut_assert(operations.size() == 1);
+	sut_assert(operations[0].type == DIFF_INSERT);
+	sut_assert(operations[0].newPath == path(1));
+	sut_assert(operations[0].oldPath.empty());
+}
+
+void
+test_removed_block()
+{
+	std::vector<DiffOperation> operations = diffMarkdown("one\n\ntwo\n\nthree\n", "one\n\nthree\n");
+
+	sut_assert(operations.size() == 1);
+	sut_assert(operations[0].type == DIFF_REMOVE);
+	sut_assert(operations[0].oldPath == path(1));
+	sut_assert(operations[0].newPath.empty());
+}
+
+void
+test_moved_block()
+{
+	std::vector<DiffOperation> operations = diffMarkdown("one\n\ntwo\n\nthree\n", "two\n\nthree\n\none\n");
+
+	sut_assert(operations.size() == 1);
+	sut_assert(operations[0].type == DIFF_MOVE);
+	sut_assert(operations[0].oldPath == path(0));
+	sut_assert(operations[0].newPath == path(2));
+}
+
+void
+test_updated_text_is_found_in_place()
+{
+	std::vector<DiffOperation> operations = diffMarkdown("one\n\ntwo\n\nthree\n", "one\n\nTWO\n\nthree\n");
+
+	sut_assert(operations.size() == 1);
+	sut_assert(operations[0].type == DIFF_UPDATE_TEXT);
+	sut_assert(operations[0].oldPath == path(1, 0));
+	sut_assert(operations[0].newPath == path(1, 0));
+}
+
+void
+test_changed_type_replaces_block()
+{
+	std::vector<DiffOperation> operations = diffMarkdown("one\n\ntwo\n", "one\n\n# two\n");
+
+	sut_assert(operations.size() == 2);
+	sut_assert(operations[0].type == DIFF_REMOVE);
+	sut_assert(operations[0].oldPath == path(1));
+	sut_assert(operations[1].type == DIFF_INSERT);
+	sut_assert(operations[1].newPath == path(1));
+}
+
+void
+test_nested_insert_in_list()
+{
+	std::vector<DiffOperation> operations = diffMarkdown("* one\n* three\n", "* one\n* two\n* three\n");
+
+	sut_assert(operations.size() == 1);
+	sut_assert(operations[0].type == DIFF_INSERT);
+	sut_assert(operations[0].newPath == path(0, 1));
+}
+
+void
+test_reparsed_document_diffs_against_previous()
+{
+	Parser parser;
+	std::string markdown = "one\n\ntwo\n\nthree\n";
+	Document old = parser.parse(markdown);
+	EditRange edit = { 5, 0, 4 };
+	markdown.insert(5, "new ");
+	Document neu = parser.reparse(old, edit, markdown);
+	std::vector<DiffOperation> operations = diff(old, neu);
+
+	sut_assert(operations.size() == 1);
+	sut_assert(operations[0].type == DIFF_UPDATE_TEXT);
+	sut_assert(operations[0].newPath == path(1, 0));
+}
@@ -86,4 +86,48 @@ test_document_access_multiple()
 	sut_assert(document[0].getText() == "0");
 	sut_assert(document[1].getText() == "1");
 	sut_assert(document[2].getText() == "2");
-}
\ No newline at end of file
+}
+
+static Element
+make_element(Type type, const std::string& text)
+{
+	Element element;
+	element.setType(type);
+	element.setText(text);
+	return element;
+}
+
+void
+test_document_elements_of_type()
+{
+	Document typed;
+	Element paragraph = make_element(PARAGRAPH, "");
+	paragraph.append(make_element(LINK, "one"));
+	paragraph.append(make_element(TEXT, " and "));
+	paragraph.append(make_element(LINK, "two"));
+	typed.append(make_element(HEADER, "title"));
+	typed.append(paragraph);
+
+	const std::vector<const Element*>& links = typed.getElementsOfType(LINK);
+	sut_assert(links.size() == 2);
+	sut_assert(links[0]->getText() == "one");
+	sut_assert(links[1]->getText() == "two");
+	sut_assert(typed.getElementsOfType(HEADER).size() == 1);
+	sut_assert(typed.getElementsOfType(PARAGRAPH)[0]->size() == 3);
+	sut_assert(typed.getElementsOfType(IMAGE).empty());
+}
+
+void
+test_document_elements_of_type_after_append()
+{
+	Document typed;
+	typed.append(make_element(HEADER, "one"));
+	sut_assert(typed.getElementsOfType(HEADER).size() == 1);
+
+	Document copy = typed;
+	typed.append(make_element(HEADER, "two"));
+
+	sut_assert(typed.getElementsOfType(HEADER).size() == 2);
+	sut_assert(typed.getElementsOfType(HEADER)[1]->getText() == "two");
+	sut_assert(copy.getElementsOfType(HEADER).size() == 1);
+}
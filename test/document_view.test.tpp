@@ -0,0 +1,334 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <sstream>
+#include <string>
+#include <stdio.h>
+#include <unistd.h>
+#include "document_view.h"
+#include "document_writer.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+static void
+describe(std::string& out, Element element)
+{
+	char type[8];
+	snprintf(type, sizeof type, "%x(", element.getType());
+	out += type;
+	out += element.getText();
+
+	for (Element::AttributeMap::iterator it = element.attrBegin(); it != element.attrEnd(); ++it) {
+		out += " " + it->first + "=" + it->second;
+	}
+
+	for (size_t i = 0; i < element.size(); i++) {
+		describe(out, element[i]);
+	}
+
+	out += ")";
+}
+
+static std::string
+describe(Document document)
+{
+	std::string out;
+
+	for (size_t i = 0; i < document.size(); i++) {
+		describe(out, document[i]);
+	}
+
+	return out;
+}
+
+static const char* MARKDOWN =
+	"Header\n======\n\n"
+	"Some *emphasis* and a [link][a] and ![an image](http://example.com/i.png \"title\").\n\n"
+	"* one\n* **two**\n\n"
+	"> quoted `code`\n\n"
+	"    block code\n\n"
+	"[a]: http://example.com \"Example\"\n";
+
+static std::string
+serialize(Document document)
+{
+	std::ostringstream out;
+	DocumentWriter::write(out, document);
+	return out.str();
+}
+
+void
+test_round_trip()
+{
+	Parser parser;
+	Document document = parser.parse(MARKDOWN);
+	std::string binary = serialize(document);
+	DocumentView view(binary.data(), binary.size());
+
+	sut_assert(view.isValid());
+	sut_assert(view.size() == document.size());
+	sut_assert(view.getStatus() == PARSE_COMPLETE);
+	sut_assert(describe(view.toDocument()) == describe(document));
+
+	for (size_t i = 0; i < document.size(); i++) {
+		sut_assert(view.getId(i) == document.getId(i));
+		sut_assert(view.getOffset(i) == document.getOffset(i));
+	}
+}
+
+void
+test_round_trip_keeps_hashes()
+{
+	Parser parser;
+	Document document = parser.parse(MARKDOWN);
+	std::string binary = serialize(document);
+	Document copy = DocumentView(binary.data(), binary.size()).toDocument();
+
+	for (size_t i = 0; i < document.size(); i++) {
+		sut_assert(copy[i].getHash() == document[i].getHash());
+	}
+}
+
+void
+test_view_reads_in_place()
+{
+	Parser parser;
+	std::string binary = serialize(parser.parse("# Title\n\nA [link](http://example.com).\n"));
+	DocumentView view(binary.data(), binary.size());
+
+	sut_assert(view.size() == 2);
+	sut_assert(view[0].getType() == HEADER);
+	sut_assert(view[0].getAttribute("level") == "1");
+	sut_assert(view[0][0].getText() == "Title");
+
+	NodeView link = view[1][1];
+	sut_assert(link.getType() == LINK);
+	sut_assert(link.getAttribute("link") == "http://example.com");
+	sut_assert(link.getAttribute("missing") == "");
+
+	const char* text = view[0][0].getTextData();
+	sut_assert(text >= binary.data() && text < binary.data() + binary.size());
+}
+
+void
+test_attribute_keys_are_stored_once()
+{
+	Parser parser;
+	std::string markdown;
+
+	for (int i = 0; i < 100; i++) {
+		markdown += "[link](http://example.com/somewhere)\n\n";
+	}
+
+	std::string binary = serialize(parser.parse(markdown));
+	size_t keys = 0;
+
+	for (size_t at = binary.find("link"); at != std::string::npos; at = binary.find("link", at + 1)) {
+		keys++;
+	}
+
+	// The text of every link, plus the key once.
+	sut_assert(keys == 101);
+}
+
+void
+test_writer_streams_from_a_parse()
+{
+	Parser parser;
+	std::ostringstream out;
+	DocumentWriter writer(out);
+
+	parser.begin(MARKDOWN);
+	size_t size = writer.getSize();
+
+	while (parser.step(1)) {
+		writer.write(parser.getDocument());
+		sut_assert(writer.getSize() >= size);
+		sut_assert(writer.getSize() == out.str().size());
+		size = writer.getSize();
+	}
+
+	sut_assert(size > BINARY_HEADER_SIZE);
+	writer.finish(parser.getDocument());
+
+	std::string binary = out.str();
+	DocumentView view(binary.data(), binary.size());
+	sut_assert(view.isValid());
+	sut_assert(describe(view.toDocument()) == describe(parser.parse(MARKDOWN)));
+}
+
+void
+test_status_is_kept()
+{
+	Parser parser;
+	ParseOptions options;
+	options.maxBlocks = 1;
+	std::string binary = serialize(parser.parse(MARKDOWN, options));
+	DocumentView view(binary.data(), binary.size());
+
+	sut_assert(view.size() == 1);
+	sut_assert(view.getStatus() == PARSE_BLOCK_LIMIT_REACHED);
+}
+
+void
+test_lazy_document_is_written_in_full()
+{
+	Parser parser;
+	ParseOptions options;
+	options.lazyInline = true;
+	std::string binary = serialize(parser.parse(MARKDOWN, options));
+
+	sut_assert(describe(DocumentView(binary.data(), binary.size()).toDocument()) == describe(parser.parse(MARKDOWN)));
+}
+
+void
+test_empty_document()
+{
+	std::string binary = serialize(Document());
+	DocumentView view(binary.data(), binary.size());
+
+	sut_assert(view.isValid());
+	sut_assert(view.size() == 0);
+}
+
+void
+test_invalid_buffers_are_rejected()
+{
+	Parser parser;
+	std::string binary = serialize(parser.parse(MARKDOWN));
+
+	sut_assert(!DocumentView().isValid());
+	sut_assert(!DocumentView(binary.data(), 10).isValid());
+	sut_assert(!DocumentView(binary.data(), binary.size() - 1).isValid());
+
+	std::string version = binary;
+	version[4] = BINARY_VERSION + 1;
+	sut_assert(!DocumentView(version.data(), version.size()).isValid());
+}
+
+void
+test_corrupt_nodes_are_bounded()
+{
+	Parser parser;
+	std::string binary = serialize(parser.parse("* one\n* two\n"));
+
+	// Point the child range of the list at itself and its text past the
+	// end of the frame.
+	unsigned char* list = (unsigned char*) &binary[BINARY_HEADER_SIZE + BINARY_FRAME_HEADER_SIZE];
+	writeBinary32(list + 8, 1000);
+	writeBinary32(list + 12, 0);
+
+	DocumentView view(binary.data(), binary.size());
+	sut_assert(view.isValid());
+	sut_assert(view[0].size() == 0);
+	sut_assert(view[0].getTextLength() == 0);
+	sut_assert(view[0].getText() == "");
+}
+
+void
+test_corrupt_types_are_rejected()
+{
+	Parser parser;
+	std::string binary = serialize(parser.parse("one *two*\n\nthree\n"));
+
+	// Flip a high bit in the type of the emphasis, the third node of the
+	// first frame.
+	unsigned char* emphasis = (unsigned char*) &binary[BINARY_HEADER_SIZE + BINARY_FRAME_HEADER_SIZE + 2 * BINARY_NODE_SIZE];
+	writeBinary32(emphasis, readBinary32(emphasis) | 0x9000);
+
+	DocumentView view(binary.data(), binary.size());
+	sut_assert(view.isValid());
+	sut_assert(view[0].size() == 0);
+	sut_assert(view[1].getType() == PARAGRAPH);
+	sut_assert(view[1][0].getText() == "three");
+}
+
+static Document
+chain(size_t depth)
+{
+	Element element;
+	element.setType(TEXT);
+	element.setText("leaf");
+
+	for (size_t i = 1; i < depth; i++) {
+		Element parent;
+		parent.setType(BLOCK_QUOTE);
+		parent.append(element);
+		element = parent;
+	}
+
+	Document document;
+	document.append(element);
+	return document;
+}
+
+void
+test_deep_frames_are_rejected()
+{
+	std::string shallow = serialize(chain(BINARY_MAX_DEPTH));
+	std::string deep = serialize(chain(BINARY_MAX_DEPTH + 1));
+
+	DocumentView shallowView(shallow.data(), shallow.size());
+	NodeView node = shallowView[0];
+
+	for (size_t i = 1; i < BINARY_MAX_DEPTH; i++) {
+		node = node[0];
+	}
+
+	sut_assert(node.getText() == "leaf");
+
+	DocumentView deepView(deep.data(), deep.size());
+	sut_assert(deepView.isValid());
+	sut_assert(deepView[0].size() == 0);
+	sut_assert(deepView.toDocument()[0].size() == 0);
+}
+
+void
+test_shared_children_are_rejected()
+{
+	Parser parser;
+	std::string binary = serialize(parser.parse("one *two* three\n"));
+
+	// Make the text after the emphasis claim the emphasis as its child.
+	unsigned char* text = (unsigned char*) &binary[BINARY_HEADER_SIZE + BINARY_FRAME_HEADER_SIZE + 3 * BINARY_NODE_SIZE];
+	writeBinary32(text + 12, 2);
+	writeBinary32(text + 16, 1);
+
+	DocumentView view(binary.data(), binary.size());
+	sut_assert(view[0].size() == 0);
+}
+
+void
+test_mapped_document()
+{
+	Parser parser;
+	Document document = parser.parse(MARKDOWN);
+	char path[] = "/tmp/bypass_document_view_XXXXXX";
+	int fd = mkstemp(path);
+	std::string binary = serialize(document);
+	sut_assert(write(fd, binary.data(), binary.size()) == (ssize_t) binary.size());
+	close(fd);
+
+	MappedDocument mapped;
+	sut_assert(mapped.open(path));
+	sut_assert(describe(mapped.getView().toDocument()) == describe(document));
+
+	mapped.close();
+	sut_assert(!mapped.getView().isValid());
+	sut_assert(!mapped.open("/nonexistent/bypass"));
+	unlink(path);
+}
@@ -291,3 +291,50 @@ test_get_attribute_names_with_multiple_attributes()
 	sut_assert(std::find(res.begin(), res.end(), "b") != res.end());
 }
 
+
+void
+test_child_hash_matches_equal_content()
+{
+	Element first, second;
+	first.setText("same");
+	second.setText("same");
+	element.append(first);
+	element.append(second);
+
+	sut_assert(element[0].getHash() != 0);
+	sut_assert(element[0].getHash() == element[1].getHash());
+}
+
+void
+test_child_hash_covers_type_text_and_attributes()
+{
+	Element plain, retyped, retexted, attributed;
+	plain.setText("text");
+	retyped.setText("text");
+	retyped.setType(HEADER);
+	retexted.setText("other");
+	attributed.setText("text");
+	attributed.addAttribute("level", "1");
+	element.append(plain);
+	element.append(retyped);
+	element.append(retexted);
+	element.append(attributed);
+
+	sut_assert(element[0].getHash() != element[1].getHash());
+	sut_assert(element[0].getHash() != element[2].getHash());
+	sut_assert(element[0].getHash() != element[3].getHash());
+}
+
+void
+test_child_hash_covers_grandchildren()
+{
+	Element left, right, leaf;
+	leaf.setText("a");
+	left.append(leaf);
+	leaf.setText("b");
+	right.append(leaf);
+	element.append(left);
+	element.append(right);
+
+	sut_assert(element[0].getHash() != element[1].getHash());
+}
@@ -0,0 +1,212 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include <stdio.h>
+#include "event_parser.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+static void
+describe(std::string& out, Element element)
+{
+	char type[8];
+	snprintf(type, sizeof type, "%x(", element.getType());
+	out += type;
+	out += element.getText();
+
+	for (Element::AttributeMap::iterator it = element.attrBegin(); it != element.attrEnd(); ++it) {
+		out += " " + it->first + "=" + it->second;
+	}
+
+	for (size_t i = 0; i < element.size(); i++) {
+		describe(out, element[i]);
+	}
+
+	out += ")";
+}
+
+static std::string
+describe(Document document)
+{
+	std::string out;
+
+	for (size_t i = 0; i < document.size(); i++) {
+		describe(out, document[i]);
+	}
+
+	return out;
+}
+
+// Describes the events in the same way as describe() does elements.
+class Recorder : public Handler {
+public:
+	std::string out;
+	int depth;
+	int maxDepth;
+
+	Recorder() : depth(0), maxDepth(0) {}
+
+	void enterBlock(Type type, const Attributes& attributes) {
+		open(type, TextView(), attributes);
+		maxDepth = std::max(maxDepth, ++depth);
+	}
+
+	void exitBlock(Type type) {
+		depth--;
+		out += ")";
+	}
+
+	void text(const TextView& text) {
+		open(TEXT, text, Attributes());
+		out += ")";
+	}
+
+	void span(Type type, const TextView& text, const Attributes& attributes) {
+		open(type, text, attributes);
+		out += ")";
+	}
+private:
+	void open(Type type, const TextView& text, const Attributes& attributes) {
+		char name[8];
+		snprintf(name, sizeof name, "%x(", type);
+		out += name;
+		out += text.toString();
+
+		for (size_t i = 0; i < attributes.size(); i++) {
+			out += " " + attributes.getName(i).toString() + "=" + attributes.getValue(i).toString();
+		}
+	}
+};
+
+static std::string
+events(const std::string& markdown)
+{
+	EventParser parser;
+	Recorder recorder;
+	parser.parse(markdown, recorder);
+	return recorder.out;
+}
+
+static bool
+matchesTree(const std::string& markdown)
+{
+	Parser parser;
+	return events(markdown) == describe(parser.parse(markdown));
+}
+
+void
+test_paragraphs_and_headers()
+{
+	sut_assert(matchesTree("Header\n======\n\nSome text.\n\n## Level two\n\nMore\ntext.\n"));
+	sut_assert(events("# Title\n") == "3( level=1114(Title))");
+}
+
+void
+test_spans()
+{
+	sut_assert(matchesTree("Some *emphasis*, **strong**, ***both*** and `code`.\n"));
+	sut_assert(matchesTree("~~struck~~ and ~not struck~\n"));
+	sut_assert(matchesTree("*a **b** c* and **a *b* c**\n"));
+}
+
+void
+test_links()
+{
+	sut_assert(matchesTree("A [link](http://example.com \"Title\") and [another][a].\n\n[a]: http://example.com/a\n"));
+	sut_assert(matchesTree("An autolink <http://example.com> and [*emphasized*](http://example.com).\n"));
+	sut_assert(matchesTree("*[a link inside emphasis](http://example.com)*\n"));
+}
+
+void
+test_linebreak()
+{
+	sut_assert(matchesTree("one  \ntwo  \nthree\n"));
+	sut_assert(matchesTree("`code`  \n*emphasis*  \n  \nend\n"));
+}
+
+void
+test_lists_and_quotes()
+{
+	sut_assert(matchesTree("* one\n* **two**\n  * nested\n\n1. first\n2. second\n"));
+	sut_assert(matchesTree("* loose\n\n* list\n"));
+	sut_assert(matchesTree("> quoted *text*\n>\n> > nested\n"));
+}
+
+void
+test_block_code()
+{
+	sut_assert(matchesTree("    code\n    more code\n\ntext\n"));
+	sut_assert(events("    x\n") == "0(114(x))");
+}
+
+void
+test_blocks_are_balanced()
+{
+	EventParser parser;
+	Recorder recorder;
+	parser.parse("* a\n  * b\n\n> > c\n", recorder);
+
+	sut_assert(recorder.depth == 0);
+	sut_assert(recorder.maxDepth == 4);
+}
+
+void
+test_entities_are_text()
+{
+	sut_assert(events("a &amp; b\n") == "7(114(a )114(&amp;)114( b))");
+}
+
+void
+test_empty_input()
+{
+	EventParser parser;
+	Recorder recorder;
+	parser.parse("", recorder);
+	parser.parse((const char*) NULL, recorder);
+
+	sut_assert(recorder.out == "");
+}
+
+void
+test_default_handler_ignores_events()
+{
+	EventParser parser;
+	Handler handler;
+	parser.parse("# Title\n\n* a [link](http://example.com)\n", handler);
+}
+
+void
+test_attributes_lookup()
+{
+	Recorder recorder;
+	EventParser parser;
+
+	class Links : public Handler {
+	public:
+		std::string links;
+
+		void span(Type type, const TextView& text, const Attributes& attributes) {
+			if (type == LINK) {
+				links += attributes.get("link").toString() + "|" + attributes.get("title").toString() + ";";
+			}
+		}
+	} links;
+
+	parser.parse("[a](http://a \"A\") [b](http://b)\n", links);
+	sut_assert(links.links == "http://a|A;http://b|;");
+}
@@ -0,0 +1,186 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include "export.h"
+#include "export_reader.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+static void
+describe(std::string& out, Element element)
+{
+	char type[8];
+	snprintf(type, sizeof type, "%x(", element.getType());
+	out += type;
+	out += element.getText();
+
+	for (Element::AttributeMap::iterator it = element.attrBegin(); it != element.attrEnd(); ++it) {
+		out += " " + it->first + "=" + it->second;
+	}
+
+	for (size_t i = 0; i < element.size(); i++) {
+		describe(out, element[i]);
+	}
+
+	out += ")";
+}
+
+static std::string
+describe(Document document)
+{
+	std::string out;
+
+	for (size_t i = 0; i < document.size(); i++) {
+		describe(out, document[i]);
+	}
+
+	return out;
+}
+
+// Describes an exported buffer through the C reader.
+static std::string
+read(const unsigned char* buffer, size_t size)
+{
+	std::vector<char> out(1 << 16);
+
+	if (!export_describe(buffer, size, &out[0], out.size())) {
+		return "invalid";
+	}
+
+	return &out[0];
+}
+
+static const char* MARKDOWN =
+	"Header\n======\n\n"
+	"Some *emphasis* and a [link][a] and ![an image](http://example.com/i.png \"title\").\n\n"
+	"* one\n* **two**\n  * nested [link][a]\n\n"
+	"> quoted `code`\n\n"
+	"| a | b |\n|---|--:|\n| 1 | 2 |\n\n"
+	"[a]: http://example.com \"Example\"\n";
+
+void
+test_export_matches_document()
+{
+	Parser parser;
+	Document document = parser.parse(MARKDOWN);
+	std::vector<unsigned char> buffer;
+
+	sut_assert(exportDocument(document, buffer));
+	sut_assert(read(&buffer[0], buffer.size()) == describe(document));
+}
+
+void
+test_header()
+{
+	Parser parser;
+	Document document = parser.parse(MARKDOWN);
+	std::vector<unsigned char> buffer;
+	exportDocument(document, buffer);
+	const bypass_export_header* header = reinterpret_cast<const bypass_export_header*>(&buffer[0]);
+
+	sut_assert(header->magic == BYPASS_EXPORT_MAGIC);
+	sut_assert(header->version == BYPASS_EXPORT_VERSION);
+	sut_assert(header->root_count == document.size());
+	sut_assert(header->status == PARSE_COMPLETE);
+	sut_assert(header->total_size == buffer.size());
+	sut_assert(header->strings_offset + header->string_pool_size == buffer.size());
+}
+
+void
+test_attribute_names_are_stored_once()
+{
+	Parser parser;
+	std::string markdown;
+
+	for (int i = 0; i < 50; i++) {
+		markdown += "[text](http://example.com \"title\")\n\n";
+	}
+
+	std::vector<unsigned char> buffer;
+	exportDocument(parser.parse(markdown), buffer);
+	const bypass_export_header* header = reinterpret_cast<const bypass_export_header*>(&buffer[0]);
+	std::string pool(reinterpret_cast<const char*>(&buffer[header->strings_offset]), header->string_pool_size);
+	size_t titles = 0;
+
+	for (size_t at = pool.find("title"); at != std::string::npos; at = pool.find("title", at + 1)) {
+		titles++;
+	}
+
+	// The value of every link, plus the name once.
+	sut_assert(titles == 51);
+	sut_assert(read(&buffer[0], buffer.size()) == describe(parser.parse(markdown)));
+}
+
+void
+test_buffer_is_relocatable()
+{
+	Parser parser;
+	std::vector<unsigned char> buffer;
+	exportDocument(parser.parse(MARKDOWN), buffer);
+
+	// The buffer holds no pointers, so a copy reads the same.
+	std::vector<unsigned char> copy(buffer);
+	buffer.assign(buffer.size(), 0);
+	sut_assert(read(&copy[0], copy.size()) == describe(parser.parse(MARKDOWN)));
+}
+
+void
+test_c_entry_point()
+{
+	Parser parser;
+	std::string markdown = MARKDOWN;
+	size_t size = 0;
+	unsigned char* buffer = bypass_export_markdown(markdown.data(), markdown.size(), &size);
+
+	sut_assert(buffer != NULL);
+	sut_assert(size > sizeof(bypass_export_header));
+	sut_assert(read(buffer, size) == describe(parser.parse(markdown)));
+	bypass_export_free(buffer);
+}
+
+void
+test_empty_document()
+{
+	std::vector<unsigned char> buffer;
+
+	sut_assert(exportDocument(Document(), buffer));
+	sut_assert(buffer.size() == sizeof(bypass_export_header));
+	sut_assert(read(&buffer[0], buffer.size()) == "");
+}
+
+void
+test_reader_rejects_a_broken_layout()
+{
+	Parser parser;
+	std::vector<unsigned char> buffer;
+	exportDocument(parser.parse(MARKDOWN), buffer);
+	bypass_export_header* header = reinterpret_cast<bypass_export_header*>(&buffer[0]);
+
+	sut_assert(read(&buffer[0], buffer.size() - 1) == "invalid");
+
+	header->version++;
+	sut_assert(read(&buffer[0], buffer.size()) == "invalid");
+	header->version--;
+
+	// Make the first root its own child.
+	bypass_export_node* root = reinterpret_cast<bypass_export_node*>(&buffer[header->nodes_offset]);
+	root->first_child = 0;
+	sut_assert(read(&buffer[0], buffer.size()) == "invalid");
+}
@@ -0,0 +1,135 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+/* A reader for exported buffers written in plain C, as an FFI consumer
+   would write it: it only knows the layout documented in export.h. */
+
+#include <stdio.h>
+#include <string.h>
+#include "export.h"
+#include "export_reader.h"
+
+/* reader • what is needed to walk a buffer */
+struct reader {
+	const unsigned char *buffer;
+	const struct bypass_export_header *header;
+	char *out;
+	size_t used;
+	size_t capacity;
+};
+
+/* node • the n-th node record */
+static const struct bypass_export_node *
+node(const struct reader *r, uint32_t n) {
+	return (const struct bypass_export_node *)(r->buffer
+		+ r->header->nodes_offset + (size_t)n * r->header->node_size); }
+
+/* attribute • the n-th attribute record */
+static const struct bypass_export_attribute *
+attribute(const struct reader *r, uint32_t n) {
+	return (const struct bypass_export_attribute *)(r->buffer
+		+ r->header->attributes_offset + (size_t)n * r->header->attribute_size); }
+
+/* string • checks a range of the string pool and its NUL terminator */
+static const char *
+string(const struct reader *r, uint32_t offset, uint32_t length) {
+	const char *pool = (const char *)r->buffer + r->header->strings_offset;
+	if ((uint64_t)offset + length >= r->header->string_pool_size
+	|| pool[offset + length] != '\0')
+		return 0;
+	return pool + offset; }
+
+/* put • appends to the description */
+static int
+put(struct reader *r, const char *data, size_t length) {
+	if (r->used + length >= r->capacity) return 0;
+	memcpy(r->out + r->used, data, length);
+	r->used += length;
+	r->out[r->used] = '\0';
+	return 1; }
+
+/* describe • appends "type(text name=value children)" for a node */
+static int
+describe(struct reader *r, uint32_t n) {
+	const struct bypass_export_node *nd = node(r, n);
+	const struct bypass_export_attribute *attr;
+	const char *text, *name, *value;
+	char type[16];
+	uint32_t i;
+
+	if ((uint64_t)nd->first_child + nd->child_count > r->header->node_count
+	|| (nd->child_count && nd->first_child <= n)
+	|| (uint64_t)nd->first_attribute + nd->attribute_count
+						> r->header->attribute_count)
+		return 0;
+	text = string(r, nd->text_offset, nd->text_length);
+	snprintf(type, sizeof type, "%x(", nd->type);
+	if (!text || !put(r, type, strlen(type))
+	|| !put(r, text, nd->text_length))
+		return 0;
+
+	for (i = 0; i < nd->attribute_count; i++) {
+		attr = attribute(r, nd->first_attribute + i);
+		name = string(r, attr->name_offset, attr->name_length);
+		value = string(r, attr->value_offset, attr->value_length);
+		if (!name || !value
+		|| !put(r, " ", 1) || !put(r, name, attr->name_length)
+		|| !put(r, "=", 1) || !put(r, value, attr->value_length))
+			return 0; }
+
+	for (i = 0; i < nd->child_count; i++) {
+		if (node(r, nd->first_child + i)->parent != n
+		|| !describe(r, nd->first_child + i))
+			return 0; }
+
+	return put(r, ")", 1); }
+
+int
+export_describe(const unsigned char *buffer, size_t size, char *out, size_t capacity) {
+	struct reader r;
+	const struct bypass_export_header *h;
+	uint32_t i;
+
+	if (size < sizeof *h || capacity == 0) return 0;
+	h = (const struct bypass_export_header *)buffer;
+	if (h->magic != BYPASS_EXPORT_MAGIC
+	|| h->version != BYPASS_EXPORT_VERSION
+	|| h->total_size != size
+	|| h->header_size < sizeof *h
+	|| h->node_size < sizeof(struct bypass_export_node)
+	|| h->attribute_size < sizeof(struct bypass_export_attribute)
+	|| h->root_count > h->node_count
+	|| h->nodes_offset < h->header_size
+	|| h->attributes_offset < h->nodes_offset
+				+ (uint64_t)h->node_count * h->node_size
+	|| h->strings_offset < h->attributes_offset
+				+ (uint64_t)h->attribute_count * h->attribute_size
+	|| (uint64_t)h->strings_offset + h->string_pool_size > size)
+		return 0;
+
+	r.buffer = buffer;
+	r.header = h;
+	r.out = out;
+	r.used = 0;
+	r.capacity = capacity;
+	out[0] = '\0';
+
+	for (i = 0; i < h->root_count; i++) {
+		if (node(&r, i)->parent != BYPASS_EXPORT_NO_PARENT
+		|| !describe(&r, i))
+			return 0; }
+
+	return 1; }
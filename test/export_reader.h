@@ -0,0 +1,35 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef BYPASS_EXPORT_READER_H
+#define BYPASS_EXPORT_READER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* export_describe • checks the layout of an exported buffer and describes */
+/*   the tree in it, returns 0 when the layout is broken or out is too small */
+int
+export_describe(const unsigned char *buffer, size_t size, char *out, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BYPASS_EXPORT_READER_H
@@ -0,0 +1,130 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Compares HtmlRenderer with the usual way of producing HTML with Bypass:
+// parsing into a Document, then walking it through the public, copying
+// accessors and concatenating strings.
+//
+// Usage: html_renderer.bench [repetitions]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include "html_renderer.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+static std::string
+escape(const std::string& text)
+{
+	std::string out;
+
+	for (size_t i = 0; i < text.size(); i++) {
+		switch (text[i]) {
+			case '&': out += "&amp;"; break;
+			case '<': out += "&lt;"; break;
+			case '>': out += "&gt;"; break;
+			case '"': out += "&quot;"; break;
+			default: out += text[i]; break;
+		}
+	}
+
+	return out;
+}
+
+static std::string
+walk(Element element)
+{
+	std::string inner = escape(element.getText());
+
+	for (size_t i = 0; i < element.size(); i++) {
+		inner += walk(element[i]);
+	}
+
+	switch (element.getType()) {
+		case BLOCK_CODE: return "<pre><code>" + inner + "</code></pre>\n";
+		case BLOCK_QUOTE: return "<blockquote>\n" + inner + "</blockquote>\n";
+		case HEADER: return "<h" + element.getAttribute("level") + ">" + inner + "</h" + element.getAttribute("level") + ">\n";
+		case LIST: return "<ul>\n" + inner + "</ul>\n";
+		case LIST_ITEM: return "<li>" + inner + "</li>\n";
+		case PARAGRAPH: return "<p>" + inner + "</p>\n";
+		case CODE_SPAN: return "<code>" + inner + "</code>";
+		case DOUBLE_EMPHASIS: return "<strong>" + inner + "</strong>";
+		case EMPHASIS: return "<em>" + inner + "</em>";
+		case TRIPLE_EMPHASIS: return "<strong><em>" + inner + "</em></strong>";
+		case STRIKETHROUGH: return "<del>" + inner + "</del>";
+		case LINEBREAK: return "<br>\n";
+		case LINK: return "<a href=\"" + escape(element.getAttribute("link")) + "\">" + inner + "</a>";
+		default: return inner;
+	}
+}
+
+static double
+seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int
+main(int argc, char** argv)
+{
+	int repetitions = argc > 1 ? atoi(argv[1]) : 10;
+	std::string markdown;
+
+	while (markdown.size() < 1 << 20) {
+		markdown +=
+			"Digest for <you>\n================\n\n"
+			"Some *emphasis*, a \"quote\", ~~struck~~ and a [link](http://example.com/?a=1&b=2).\n\n"
+			"* one\n* **two**\n* `three < four`\n\n"
+			"> A longer quoted paragraph of ordinary text that needs no escaping at all.\n\n"
+			"    code & more\n\n";
+	}
+
+	size_t bytes = markdown.size() * repetitions;
+	size_t check = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		Parser parser;
+		Document document = parser.parse(markdown);
+		std::string html;
+
+		for (size_t j = 0; j < document.size(); j++) {
+			html += walk(document[j]);
+		}
+
+		check += html.size();
+	}
+
+	printf("%-14s %8.1f MB/s\n", "tree walk", bytes / seconds(start) / 1e6);
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		HtmlRenderer renderer([&check](const struct iovec* chunks, int count) {
+			for (int j = 0; j < count; j++) {
+				check += chunks[j].iov_len;
+			}
+		});
+
+		renderer.render(markdown);
+	}
+
+	printf("%-14s %8.1f MB/s\n", "HtmlRenderer", bytes / seconds(start) / 1e6);
+	return check == 0;
+}
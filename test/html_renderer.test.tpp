@@ -0,0 +1,205 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include "html_renderer.h"
+
+using namespace Bypass;
+
+static std::string
+toHtml(const std::string& markdown)
+{
+	std::ostringstream out;
+	HtmlRenderer::render(out, markdown);
+	return out.str();
+}
+
+static std::string
+escapeSlowly(const std::string& text)
+{
+	std::string out;
+
+	for (size_t i = 0; i < text.size(); i++) {
+		switch (text[i]) {
+			case '&': out += "&amp;"; break;
+			case '<': out += "&lt;"; break;
+			case '>': out += "&gt;"; break;
+			case '"': out += "&quot;"; break;
+			case '\'': out += "&#39;"; break;
+			default: out += text[i]; break;
+		}
+	}
+
+	return out;
+}
+
+void
+test_blocks()
+{
+	sut_assert(toHtml("Title\n=====\n\n## Sub\n") == "<h1>Title</h1>\n<h2>Sub</h2>\n");
+	sut_assert(toHtml("one\ntwo\n") == "<p>one\ntwo</p>\n");
+	sut_assert(toHtml("* a\n* b\n") == "<ul>\n<li>a</li>\n<li>b</li>\n</ul>\n");
+	sut_assert(toHtml("> quoted\n") == "<blockquote>\n<p>quoted</p>\n</blockquote>\n");
+	sut_assert(toHtml("    if (a < b)\n") == "<pre><code>if (a &lt; b)\n</code></pre>\n");
+}
+
+void
+test_spans()
+{
+	sut_assert(toHtml("*a* **b** ***c*** ~~d~~\n")
+		== "<p><em>a</em> <strong>b</strong> <strong><em>c</em></strong> <del>d</del></p>\n");
+	sut_assert(toHtml("`x<y`\n") == "<p><code>x&lt;y</code></p>\n");
+	sut_assert(toHtml("a  \nb\n") == "<p>a<br>\nb</p>\n");
+	sut_assert(toHtml("~single~\n") == "<p>~single~</p>\n");
+}
+
+void
+test_links()
+{
+	sut_assert(toHtml("[*a*](http://x.com/?a=1&b=2 \"T\")\n")
+		== "<p><a href=\"http://x.com/?a=1&amp;b=2\" title=\"T\"><em>a</em></a></p>\n");
+	sut_assert(toHtml("<http://x.com>\n") == "<p><a href=\"http://x.com\">http://x.com</a></p>\n");
+	sut_assert(toHtml("[a][r]\n\n[r]: http://r.com\n") == "<p><a href=\"http://r.com\">a</a></p>\n");
+}
+
+void
+test_ordered_lists()
+{
+	sut_assert(toHtml("1. one\n2. two\n") == "<ol>\n<li>one</li>\n<li>two</li>\n</ol>\n");
+}
+
+void
+test_mail_autolinks()
+{
+	sut_assert(toHtml("<foo@bar.com>\n") == "<p><a href=\"mailto:foo@bar.com\">foo@bar.com</a></p>\n");
+	sut_assert(toHtml("<mailto:foo@bar.com>\n") == "<p><a href=\"mailto:foo@bar.com\">mailto:foo@bar.com</a></p>\n");
+}
+
+void
+test_unsafe_links()
+{
+	sut_assert(toHtml("[x](javascript:alert(1))\n") == "<p>x)</p>\n");
+	sut_assert(toHtml("[x](JavaScript:alert)\n") == "<p>x</p>\n");
+	sut_assert(toHtml("[x](data:text/html,a)\n") == "<p>x</p>\n");
+	sut_assert(toHtml("[x](HTTPS://x.com)\n") == "<p><a href=\"HTTPS://x.com\">x</a></p>\n");
+	sut_assert(toHtml("[x](mailto:a@b.c)\n") == "<p><a href=\"mailto:a@b.c\">x</a></p>\n");
+	sut_assert(toHtml("[x](/page?a=b:c)\n") == "<p><a href=\"/page?a=b:c\">x</a></p>\n");
+}
+
+void
+test_escapes_text()
+{
+	sut_assert(toHtml("Tom & \"Jerry\" <3 'cheese'\n")
+		== "<p>Tom &amp; &quot;Jerry&quot; &lt;3 &#39;cheese&#39;</p>\n");
+	sut_assert(toHtml("<b>bold</b>\n") == "<p>&lt;b&gt;bold&lt;/b&gt;</p>\n");
+	sut_assert(toHtml("AT&amp;T\n") == "<p>AT&amp;T</p>\n");
+}
+
+void
+test_escape_matches_bytewise()
+{
+	const char alphabet[] = "ab&<>\"'\xc3\xa9 ";
+	srand(42);
+
+	for (int n = 0; n < 500; n++) {
+		std::string text;
+		size_t length = rand() % 40;
+
+		for (size_t i = 0; i < length; i++) {
+			text += alphabet[rand() % (sizeof(alphabet) - 1)];
+		}
+
+		struct buf *ob = bufnew(64);
+		escapeHtml(ob, text.data(), text.size());
+		sut_assert(std::string(ob->data, ob->size) == escapeSlowly(text));
+		bufrelease(ob);
+	}
+}
+
+void
+test_chunks_per_block()
+{
+	std::vector<std::string> chunks;
+	int calls = 0;
+	HtmlRenderer renderer([&](const struct iovec* iov, int count) {
+		calls++;
+
+		for (int i = 0; i < count; i++) {
+			chunks.push_back(std::string((const char*) iov[i].iov_base, iov[i].iov_len));
+		}
+	});
+
+	renderer.render("# a\n\nb\n\n* c\n");
+
+	sut_assert(calls == 1);
+	sut_assert(chunks.size() == 3);
+	sut_assert(chunks[0] == "<h1>a</h1>\n");
+	sut_assert(chunks[1] == "<p>b</p>\n");
+	sut_assert(chunks[2] == "<ul>\n<li>c</li>\n</ul>\n");
+
+	renderer.render("d\n");
+
+	sut_assert(calls == 2);
+	sut_assert(chunks.back() == "<p>d</p>\n");
+}
+
+void
+test_flushes_when_full()
+{
+	std::string markdown;
+	std::string expected;
+
+	for (int i = 0; i < HTML_MAX_CHUNKS * 3; i++) {
+		markdown += "para\n\n";
+		expected += "<p>para</p>\n";
+	}
+
+	std::string html;
+	int calls = 0;
+	int largest = 0;
+	HtmlRenderer renderer([&](const struct iovec* iov, int count) {
+		calls++;
+		largest = count > largest ? count : largest;
+
+		for (int i = 0; i < count; i++) {
+			html.append((const char*) iov[i].iov_base, iov[i].iov_len);
+		}
+	});
+
+	renderer.render(markdown);
+
+	sut_assert(html == expected);
+	sut_assert(calls == 3);
+	sut_assert(largest == HTML_MAX_CHUNKS);
+}
+
+void
+test_empty()
+{
+	int calls = 0;
+	HtmlRenderer renderer([&](const struct iovec* iov, int count) {
+		calls++;
+	});
+
+	renderer.render("");
+	renderer.render((const char*) NULL);
+	renderer.flush();
+
+	sut_assert(calls == 0);
+	sut_assert(toHtml("\n\n") == "");
+}
@@ -0,0 +1,192 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Compares JsonWriter with the usual way of producing JSON from a Document:
+// walking it through the public, copying accessors into the value tree of a
+// generic JSON library, then serializing that tree. The library is stood in
+// for by a minimal value type of the same shape.
+//
+// Usage: json_writer.bench [repetitions]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+#include "json_writer.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+struct Value {
+	enum Kind { STRING, ARRAY, OBJECT } kind;
+	std::string string;
+	std::vector<Value> array;
+	std::map<std::string, Value> object;
+
+	Value(Kind kind = OBJECT) : kind(kind) {}
+	Value(const std::string& string) : kind(STRING), string(string) {}
+
+	void dump(std::string& out) const {
+		switch (kind) {
+			case STRING:
+				out += '"';
+
+				for (size_t i = 0; i < string.size(); i++) {
+					unsigned char c = string[i];
+
+					if (c == '"' || c == '\\') {
+						out += '\\';
+						out += c;
+					}
+					else if (c < 0x20) {
+						char escaped[8];
+						snprintf(escaped, sizeof escaped, "\\u%04x", c);
+						out += escaped;
+					}
+					else {
+						out += c;
+					}
+				}
+
+				out += '"';
+				break;
+			case ARRAY:
+				out += '[';
+
+				for (size_t i = 0; i < array.size(); i++) {
+					if (i > 0) {
+						out += ',';
+					}
+
+					array[i].dump(out);
+				}
+
+				out += ']';
+				break;
+			case OBJECT:
+				out += '{';
+
+				for (std::map<std::string, Value>::const_iterator it = object.begin(); it != object.end(); ++it) {
+					if (it != object.begin()) {
+						out += ',';
+					}
+
+					Value(it->first).dump(out);
+					out += ':';
+					it->second.dump(out);
+				}
+
+				out += '}';
+				break;
+		}
+	}
+};
+
+static Value
+walk(Element element)
+{
+	Value value;
+	char type[8];
+	snprintf(type, sizeof type, "%x", element.getType());
+	value.object["type"] = Value(std::string(type));
+
+	if (!element.getText().empty()) {
+		value.object["text"] = Value(element.getText());
+	}
+
+	if (element.attrSize() > 0) {
+		Value attributes;
+
+		for (Element::AttributeMap::iterator it = element.attrBegin(); it != element.attrEnd(); ++it) {
+			attributes.object[it->first] = Value(it->second);
+		}
+
+		value.object["attributes"] = attributes;
+	}
+
+	if (element.size() > 0) {
+		Value children(Value::ARRAY);
+
+		for (size_t i = 0; i < element.size(); i++) {
+			children.array.push_back(walk(element[i]));
+		}
+
+		value.object["children"] = children;
+	}
+
+	return value;
+}
+
+static double
+seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int
+main(int argc, char** argv)
+{
+	int repetitions = argc > 1 ? atoi(argv[1]) : 10;
+	std::string markdown;
+
+	while (markdown.size() < 1 << 20) {
+		markdown +=
+			"Header\n======\n\n"
+			"Some *emphasis*, a \"quote\" and a [link](http://example.com/path \"Title\").\n\n"
+			"* one\n* **two**\n* `three`\n\n"
+			"    code with\ttabs\\and backslashes\n\n";
+	}
+
+	Parser parser;
+	Document document = parser.parse(markdown);
+	size_t bytes = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		Value root;
+		Value children(Value::ARRAY);
+
+		for (size_t j = 0; j < document.size(); j++) {
+			children.array.push_back(walk(document[j]));
+		}
+
+		root.object["children"] = children;
+		std::string out;
+		root.dump(out);
+		bytes += out.size();
+	}
+
+	double library = seconds(start);
+	size_t written = 0;
+	JsonWriter writer([&written](const char* data, size_t length) {
+		written += length;
+	});
+
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		writer.write(document);
+	}
+
+	double direct = seconds(start);
+
+	printf("walk + library: %8.1f MB/s\n", bytes / library / 1e6);
+	printf("JsonWriter:     %8.1f MB/s\n", written / direct / 1e6);
+	return 0;
+}
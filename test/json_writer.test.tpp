@@ -0,0 +1,193 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <sstream>
+#include <string>
+#include <stdio.h>
+#include "json_writer.h"
+#include "parser.h"
+
+using namespace Bypass;
+
+static std::string
+toJson(const Document& document)
+{
+	std::ostringstream out;
+	JsonWriter::write(out, document);
+	return out.str();
+}
+
+static std::string
+toJson(const Element& element)
+{
+	std::string out;
+	JsonWriter writer([&out](const char* data, size_t length) {
+		out.append(data, length);
+	});
+
+	writer.write(element);
+	return out;
+}
+
+static Element
+textElement(const std::string& text)
+{
+	Element element;
+	element.setType(TEXT);
+	element.setText(text);
+	return element;
+}
+
+// Escapes one byte at a time, to check the word-at-a-time scan against.
+static std::string
+quote(const std::string& text)
+{
+	std::string out = "\"";
+
+	for (size_t i = 0; i < text.size(); i++) {
+		unsigned char c = text[i];
+		char escaped[8];
+
+		switch (c) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\b': out += "\\b"; break;
+			case '\f': out += "\\f"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (c < 0x20) {
+					snprintf(escaped, sizeof escaped, "\\u%04x", c);
+					out += escaped;
+				}
+				else {
+					out += c;
+				}
+		}
+	}
+
+	return out + "\"";
+}
+
+void
+test_document()
+{
+	Parser parser;
+	std::string json = toJson(parser.parse("# Title\n\nSome *text*.\n"));
+
+	sut_assert(json ==
+		"{\"status\":\"COMPLETE\",\"children\":["
+		"{\"type\":\"HEADER\",\"attributes\":{\"level\":\"1\"},\"children\":[{\"type\":\"TEXT\",\"text\":\"Title\"}]},"
+		"{\"type\":\"PARAGRAPH\",\"children\":[{\"type\":\"TEXT\",\"text\":\"Some \"},"
+		"{\"type\":\"EMPHASIS\",\"text\":\"text\"},{\"type\":\"TEXT\",\"text\":\".\"}]}]}");
+}
+
+void
+test_empty_document()
+{
+	sut_assert(toJson(Document()) == "{\"status\":\"COMPLETE\",\"children\":[]}");
+}
+
+void
+test_status()
+{
+	Parser parser;
+	ParseOptions options;
+	options.maxBlocks = 1;
+	std::string json = toJson(parser.parse("one\n\ntwo\n", options));
+
+	sut_assert(json.find("{\"status\":\"BLOCK_LIMIT_REACHED\",") == 0);
+}
+
+void
+test_attributes()
+{
+	Element link;
+	link.setType(LINK);
+	link.addAttribute("link", "http://example.com/?a=\"b\"");
+	link.addAttribute("title", "T");
+
+	sut_assert(toJson(link) ==
+		"{\"type\":\"LINK\",\"attributes\":{\"link\":\"http://example.com/?a=\\\"b\\\"\",\"title\":\"T\"}}");
+}
+
+void
+test_escapes()
+{
+	sut_assert(toJson(textElement("a\"b\\c\nd\te\x01\x1f")) ==
+		"{\"type\":\"TEXT\",\"text\":\"a\\\"b\\\\c\\nd\\te\\u0001\\u001f\"}");
+}
+
+void
+test_utf8_is_copied()
+{
+	sut_assert(toJson(textElement("caf\xc3\xa9 \xe2\x9c\x93 \x7f")) ==
+		"{\"type\":\"TEXT\",\"text\":\"caf\xc3\xa9 \xe2\x9c\x93 \x7f\"}");
+}
+
+void
+test_escapes_at_every_position()
+{
+	const char specials[] = { '"', '\\', '\n', '\x00', '\x1f', ' ', '\x80', '!' };
+
+	for (size_t length = 1; length < 24; length++) {
+		for (size_t at = 0; at < length; at++) {
+			for (size_t s = 0; s < sizeof specials; s++) {
+				std::string text(length, 'x');
+				text[at] = specials[s];
+				sut_assert(toJson(textElement(text)) == "{\"type\":\"TEXT\",\"text\":" + quote(text) + "}");
+			}
+		}
+	}
+}
+
+void
+test_output_larger_than_the_buffer()
+{
+	Parser parser;
+	std::string markdown;
+
+	for (int i = 0; i < 200; i++) {
+		markdown += "A \"quoted\" paragraph with a [link](http://example.com) in it.\n\n";
+	}
+
+	markdown += std::string(3 * JSON_BUFFER_SIZE, 'x') + "\n";
+
+	Document document = parser.parse(markdown);
+	std::string chunked;
+	size_t chunks = 0;
+	JsonWriter writer([&chunked, &chunks](const char* data, size_t length) {
+		chunked.append(data, length);
+		chunks++;
+	});
+
+	writer.write(document);
+	sut_assert(chunks > 1);
+	sut_assert(chunked == toJson(document));
+	sut_assert(chunked.size() > 3 * JSON_BUFFER_SIZE);
+}
+
+void
+test_lazy_document()
+{
+	Parser parser;
+	ParseOptions options;
+	options.lazyInline = true;
+	std::string markdown = "Some *text* and a [link](http://example.com).\n\n* item\n";
+
+	sut_assert(toJson(parser.parse(markdown, options)) == toJson(parser.parse(markdown)));
+}
@@ -0,0 +1,57 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#include <string>
+#include "line_index.h"
+#include "sut_test.h"
+
+using namespace Bypass;
+
+void
+test_line_index_empty()
+{
+	LineIndex index("");
+	sut_assert(index.getLineCount() == 1);
+	sut_assert(index.getLine(0) == 0);
+	sut_assert(index.getColumn(0) == 0);
+}
+
+void
+test_line_index_lines_and_columns()
+{
+	LineIndex index(std::string("one\ntwo\n\nfour"));
+	sut_assert(index.getLineCount() == 4);
+	sut_assert(index.getLine(2) == 0);
+	sut_assert(index.getLine(3) == 0);
+	sut_assert(index.getLine(4) == 1);
+	sut_assert(index.getColumn(6) == 2);
+	sut_assert(index.getLine(8) == 2);
+	sut_assert(index.getLine(9) == 3);
+	sut_assert(index.getLineOffset(3) == 9);
+	sut_assert(index.getLine(100) == 3);
+}
+
+void
+test_line_index_carriage_returns()
+{
+	LineIndex index(std::string("a\r\nb\rc\n"));
+	sut_assert(index.getLineCount() == 4);
+	sut_assert(index.getLine(2) == 0);
+	sut_assert(index.getLine(3) == 1);
+	sut_assert(index.getLine(5) == 2);
+	sut_assert(index.getLineOffset(3) == 7);
+}
@@ -0,0 +1,141 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include "parse_cache.h"
+
+using namespace Bypass;
+
+void
+test_second_parse_hits()
+{
+	ParseCache cache(1 << 20);
+	Document first = cache.parse("# title\n\nbody *text*\n");
+	Document second = cache.parse("# title\n\nbody *text*\n");
+	ParseCache::Statistics statistics = cache.getStatistics();
+
+	sut_assert(statistics.misses == 1);
+	sut_assert(statistics.hits == 1);
+	sut_assert(statistics.entries == 1);
+	sut_assert(second.size() == 2);
+	sut_assert(second[1][1].getText() == "text");
+	sut_assert(second[1].getHash() == first[1].getHash());
+}
+
+void
+test_options_are_part_of_the_key()
+{
+	ParseCache cache(1 << 20);
+	ParseOptions preview;
+	preview.maxVisibleChars = 3;
+
+	cache.parse("some text\n");
+	Document truncated = cache.parse("some text\n", preview);
+
+	sut_assert(cache.getStatistics().hits == 0);
+	sut_assert(truncated[0][0].getText() == "som");
+}
+
+void
+test_utf8_policy_is_part_of_the_key()
+{
+	ParseCache cache(1 << 20);
+	ParseOptions reject;
+	reject.utf8Policy = UTF8_REJECT;
+
+	Document repaired = cache.parse("bad \xff byte\n");
+	Document rejected = cache.parse("bad \xff byte\n", reject);
+	Document again = cache.parse("bad \xff byte\n");
+
+	sut_assert(repaired.getStatus() == PARSE_COMPLETE);
+	sut_assert(repaired.size() == 1);
+	sut_assert(rejected.getStatus() == PARSE_INVALID_UTF8);
+	sut_assert(rejected.size() == 0);
+	sut_assert(again.getStatus() == PARSE_COMPLETE);
+	sut_assert(again.size() == 1);
+	sut_assert(cache.getStatistics().hits == 1);
+}
+
+void
+test_utf16_offsets_are_part_of_the_key()
+{
+	ParseCache cache(1 << 20);
+	ParseOptions utf16;
+	utf16.utf16Offsets = true;
+
+	cache.parse("caf\xc3\xa9\n");
+	cache.parse("caf\xc3\xa9\n", utf16);
+
+	sut_assert(cache.getStatistics().hits == 0);
+	sut_assert(cache.getStatistics().entries == 2);
+}
+
+void
+test_abandoned_parses_are_not_cached()
+{
+	ParseCache cache(1 << 20);
+	ParseOptions options;
+	options.deadline = ParseOptions::Clock::now();
+
+	Document document = cache.parse("one\n\ntwo\n", options);
+
+	sut_assert(document.getStatus() == PARSE_DEADLINE_EXCEEDED);
+	sut_assert(cache.getStatistics().entries == 0);
+}
+
+void
+test_budget_is_measured_in_document_bytes()
+{
+	ParseCache probe(1 << 20, 1);
+	probe.parse("a\n");
+	size_t entryBytes = probe.getStatistics().bytes;
+
+	sut_assert(entryBytes > sizeof(Document) + sizeof(Element));
+
+	ParseCache cache(entryBytes * 2 + entryBytes / 2, 1);
+	cache.parse("a\n");
+	cache.parse("b\n");
+	cache.parse("c\n");
+	ParseCache::Statistics statistics = cache.getStatistics();
+
+	sut_assert(statistics.entries == 2);
+	sut_assert(statistics.evictions == 1);
+	sut_assert(statistics.bytes <= entryBytes * 2 + entryBytes / 2);
+}
+
+void
+test_documents_larger_than_a_shard_are_not_cached()
+{
+	ParseCache cache(64);
+	cache.parse("one\n\ntwo\n");
+
+	sut_assert(cache.getStatistics().entries == 0);
+}
+
+void
+test_hash128_tells_inputs_and_seeds_apart()
+{
+	std::string text(100, 'x');
+	Hash128 plain = hash128(text.data(), text.size());
+	Hash128 seeded = hash128(text.data(), text.size(), 1);
+	text[99] = 'y';
+	Hash128 changed = hash128(text.data(), text.size());
+
+	sut_assert(plain == hash128(std::string(100, 'x').data(), 100));
+	sut_assert(!(plain == seeded));
+	sut_assert(!(plain == changed));
+	sut_assert(plain.low != changed.low && plain.high != changed.high);
+}
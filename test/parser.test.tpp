@@ -705,3 +705,712 @@ test_check_document_order()
 	sut_assert(document[0].getType() == HEADER);
 	sut_assert(document[1].getType() == PARAGRAPH);
 }
+
+
+// Resumable Parsing -----------------------------------------------------------
+
+void
+test_step_yields_between_blocks()
+{
+	Parser resumable;
+	resumable.begin("# One\n\nTwo\n\n* Three\n");
+
+	sut_assert(resumable.getDocument().size() == 0);
+	sut_assert(resumable.step(1));
+	sut_assert(resumable.getDocument().size() == 1);
+	sut_assert(resumable.getDocument()[0].getType() == HEADER);
+
+	while (resumable.step(1));
+
+	Document &document = resumable.getDocument();
+	sut_assert(document.size() == 3);
+	sut_assert(document[0].getType() == HEADER);
+	sut_assert(document[1].getType() == PARAGRAPH);
+	sut_assert(document[1][0].getText() == "Two");
+	sut_assert(document[2].getType() == LIST);
+}
+
+void
+test_step_resolves_references_defined_later()
+{
+	Parser resumable;
+	resumable.begin("[one][id]\n\n[id]: http://example.com\n");
+
+	while (resumable.step(0));
+
+	Document &document = resumable.getDocument();
+	sut_assert(document.size() == 1);
+	sut_assert(document[0][0].getType() == LINK);
+	sut_assert(document[0][0].getAttribute("link") == "http://example.com");
+}
+
+void
+test_step_for_matches_parse()
+{
+	Parser resumable;
+	resumable.begin("one\n\ntwo\n\n    three\n");
+
+	while (resumable.stepFor(0));
+
+	Document &document = resumable.getDocument();
+	sut_assert(document.size() == 3);
+	sut_assert(document[2].getType() == BLOCK_CODE);
+}
+
+void
+test_step_offset_accounts_for_references_and_carriage_returns()
+{
+	Parser resumable;
+	resumable.begin("[id]: http://example.com\r\none\r\n\r\ntwo\r\n");
+	sut_assert(resumable.getOffset() == 25);
+
+	resumable.step(0);
+	sut_assert(resumable.getOffset() == 26);
+
+	resumable.step(0);
+	sut_assert(resumable.getOffset() == 33);
+
+	while (resumable.step(0));
+	sut_assert(resumable.getOffset() == 38);
+}
+
+void
+test_parse_reused_parser_starts_empty()
+{
+	Parser reused;
+	reused.parse("one\n\ntwo");
+
+	Document document = reused.parse("three");
+	sut_assert(document.size() == 1);
+	sut_assert(document[0][0].getText() == "three");
+}
+
+// Parse Limits ----------------------------------------------------------------
+
+void
+test_parse_without_limits_is_complete()
+{
+	Document document = parser.parse("one\n\ntwo");
+	sut_assert(document.getStatus() == PARSE_COMPLETE);
+	sut_assert(document.size() == 2);
+}
+
+void
+test_parse_cancelled()
+{
+	std::atomic<bool> cancel(true);
+	ParseOptions options;
+	options.cancel = &cancel;
+
+	Document document = parser.parse("one\n\ntwo", options);
+	sut_assert(document.getStatus() == PARSE_CANCELLED);
+	sut_assert(document.size() == 0);
+}
+
+void
+test_parse_deadline_exceeded()
+{
+	ParseOptions options;
+	options.deadline = ParseOptions::Clock::now();
+
+	Document document = parser.parse("one\n\ntwo", options);
+	sut_assert(document.getStatus() == PARSE_DEADLINE_EXCEEDED);
+	sut_assert(document.size() == 0);
+}
+
+void
+test_parse_node_limit_keeps_completed_blocks()
+{
+	ParseOptions options;
+	options.maxNodes = 2;
+
+	Document document = parser.parse("one\n\ntwo\n\nthree", options);
+	sut_assert(document.getStatus() == PARSE_NODE_LIMIT_EXCEEDED);
+	sut_assert(document.size() == 1);
+	sut_assert(document[0].getType() == PARAGRAPH);
+	sut_assert(document[0][0].getText() == "one");
+}
+
+void
+test_parse_output_limit_closes_open_elements()
+{
+	ParseOptions options;
+	options.maxOutputBytes = 3;
+
+	Document document = parser.parse("one *two* three\n\nfour", options);
+	sut_assert(document.getStatus() == PARSE_OUTPUT_LIMIT_EXCEEDED);
+	sut_assert(document.size() == 1);
+	sut_assert(document[0].getType() == PARAGRAPH);
+	sut_assert(document[0].size() == 1);
+	sut_assert(document[0][0].getText() == "one ");
+}
+
+// Incremental Reparsing -------------------------------------------------------
+
+static void
+describe(std::string& out, Element element)
+{
+	char type[8];
+	snprintf(type, sizeof type, "%x(", element.getType());
+	out += type;
+	out += element.getText();
+
+	for (Element::AttributeMap::iterator it = element.attrBegin(); it != element.attrEnd(); ++it) {
+		out += " " + it->first + "=" + it->second;
+	}
+
+	for (size_t i = 0; i < element.size(); i++) {
+		describe(out, element[i]);
+	}
+
+	out += ")";
+}
+
+static std::string
+describe(Document document)
+{
+	std::string out;
+
+	for (size_t i = 0; i < document.size(); i++) {
+		describe(out, document[i]);
+	}
+
+	return out;
+}
+
+static Document
+edit(Parser& editor, Document previous, std::string& markdown, size_t offset, size_t removed, const std::string& inserted)
+{
+	EditRange range = { offset, removed, inserted.size() };
+	markdown.replace(offset, removed, inserted);
+	return editor.reparse(previous, range, markdown);
+}
+
+void
+test_reparse_keeps_untouched_blocks()
+{
+	Parser editor;
+	std::string markdown = "# one\n\ntwo\n\nthree\n\nfour\n";
+	Document before = editor.parse(markdown);
+	Document after = edit(editor, before, markdown, 8, 1, "W");
+
+	sut_assert(after.size() == 4);
+	sut_assert(after[1][0].getText() == "tWo");
+	sut_assert(after.getId(2) == before.getId(2));
+	sut_assert(after.getId(3) == before.getId(3));
+	sut_assert(after.getOffset(3) == before.getOffset(3));
+	sut_assert(after.getId(1) != before.getId(1));
+	sut_assert(describe(after) == describe(parser.parse(markdown)));
+}
+
+void
+test_reparse_widens_to_list_continuation()
+{
+	Parser editor;
+	std::string markdown = "* one\n\ntwo\n\nthree\n";
+	Document before = editor.parse(markdown);
+	sut_assert(before.size() == 3);
+
+	Document after = edit(editor, before, markdown, 7, 0, "    ");
+	sut_assert(after.size() == 2);
+	sut_assert(after[0].getType() == LIST);
+	sut_assert(after[0][0].size() == 2);
+	sut_assert(after.getId(1) == before.getId(2));
+	sut_assert(describe(after) == describe(parser.parse(markdown)));
+}
+
+void
+test_reparse_shifts_offsets_after_the_edit()
+{
+	Parser editor;
+	std::string markdown = "one\n\ntwo\n\nthree\n";
+	Document before = editor.parse(markdown);
+	Document after = edit(editor, before, markdown, 0, 3, "a much longer first paragraph");
+
+	sut_assert(after.getId(2) == before.getId(2));
+	sut_assert(after.getOffset(2) == before.getOffset(2) + 26);
+	sut_assert(markdown.compare(after.getOffset(2), 5, "three") == 0);
+}
+
+void
+test_reparse_reference_edit_resolves_links()
+{
+	Parser editor;
+	std::string markdown = "[link][id]\n\ntext\n\n[id]: http://one.example\n";
+	Document before = editor.parse(markdown);
+	Document after = edit(editor, before, markdown, 31, 3, "two");
+
+	sut_assert(after[0][0].getAttribute("link") == "http://two.example");
+	sut_assert(describe(after) == describe(parser.parse(markdown)));
+}
+
+void
+test_reparse_matches_full_parse_across_edits()
+{
+	const char *pieces[] = { "a", " ", "\n", "\n\n", "* ", "1. ", "> ", "    ", "#", "*", "`", "---", "[x][id]", "text" };
+	const size_t count = sizeof pieces / sizeof pieces[0];
+	Parser editor;
+	std::string markdown = "# Title\n\nSome *text* here.\n\n* one\n* two\n\n> quoted\n\n    code\n\n[id]: http://example.com\n";
+	Document document = editor.parse(markdown);
+	unsigned int seed = 42;
+
+	for (int i = 0; i < 300; i++) {
+		seed = seed * 1103515245 + 12345;
+		size_t offset = (seed >> 8) % (markdown.size() + 1);
+		size_t removed = (seed >> 4) % 3;
+		std::string inserted = pieces[(seed >> 16) % count];
+
+		if (offset + removed > markdown.size()) {
+			removed = markdown.size() - offset;
+		}
+
+		if ((seed >> 12) % 4 == 0) {
+			inserted.clear();
+		}
+
+		document = edit(editor, document, markdown, offset, removed, inserted);
+		sut_assert(describe(document) == describe(parser.parse(markdown)));
+	}
+}
+
+void
+test_reparse_keeps_options()
+{
+	Parser editor;
+	ParseOptions options;
+	options.lazyInline = true;
+	std::string markdown = "one *a*\n\ntwo *b*\n\nthree\n";
+	Document before = editor.parse(markdown, options);
+	EditRange range = { 10, 1, 1 };
+	markdown.replace(10, 1, "W");
+	Document after = editor.reparse(before, range, markdown, options);
+
+	sut_assert(after.getId(0) != before.getId(0));
+	sut_assert(after[0].isInlineDeferred());
+	sut_assert(after[1].isInlineDeferred());
+	sut_assert(describe(after) == describe(parser.parse(markdown)));
+}
+
+void
+test_reparse_keeps_limits()
+{
+	Parser editor;
+	ParseOptions options;
+	options.maxBlocks = 2;
+	std::string markdown = "one\n\ntwo\n\nthree\n\nfour\n";
+	Document before = editor.parse(markdown);
+	EditRange range = { 12, 1, 1 };
+	markdown.replace(12, 1, "T");
+	Document after = editor.reparse(before, range, markdown, options);
+
+	sut_assert(after.size() == 2);
+	sut_assert(after.getStatus() == PARSE_BLOCK_LIMIT_REACHED);
+	sut_assert(describe(after) == describe(parser.parse(markdown, options)));
+}
+
+void
+test_reparse_keeps_duplicate_reference_order()
+{
+	const char *cases[] = {
+		"[id]: http://a\n\n[x][id]\n\ntext\n\n[id]: http://b\n",
+		"[id]: http://a\n[id]: http://b\n[id]: http://c\n\n[x][id]\n\ntext\n",
+	};
+
+	for (size_t i = 0; i < sizeof cases / sizeof cases[0]; i++) {
+		Parser editor;
+		std::string markdown = cases[i];
+		Document before = editor.parse(markdown);
+		Document after = edit(editor, before, markdown, markdown.find("text"), 1, "T");
+
+		sut_assert(describe(after) == describe(parser.parse(markdown)));
+	}
+}
+
+// Lazy Inline Parsing ---------------------------------------------------------
+
+static ParseOptions
+lazyInline()
+{
+	ParseOptions options;
+	options.lazyInline = true;
+	return options;
+}
+
+void
+test_lazy_inline_matches_eager_parse()
+{
+	Parser parser;
+	std::string markdown =
+		"Title\n=====\n\n"
+		"## *Sub* header\n\n"
+		"Some **bold** and a [reference][ref] with a line  \nbreak.\n\n"
+		"* item `code`\n"
+		"* item with list\n"
+		"    * nested _item_\n\n"
+		"> quoted [link](http://example.com \"title\")\n\n"
+		"    block code\n\n"
+		"[ref]: http://example.org \"Ref\"\n";
+
+	std::string eager = describe(parser.parse(markdown));
+	sut_assert(describe(parser.parse(markdown, lazyInline())) == eager);
+}
+
+void
+test_lazy_inline_defers_until_accessed()
+{
+	Parser parser;
+	Document document = parser.parse("one *a*\n\ntwo *b*\n", lazyInline());
+
+	sut_assert(document.size() == 2);
+	sut_assert(document[0].isInlineDeferred());
+	sut_assert(document[1].isInlineDeferred());
+
+	Element first = document[0];
+	sut_assert(first.size() == 2);
+	sut_assert(first[1].getType() == EMPHASIS);
+
+	sut_assert(!document[0].isInlineDeferred());
+	sut_assert(document[1].isInlineDeferred());
+}
+
+void
+test_eager_parse_does_not_defer()
+{
+	Parser parser;
+	Document document = parser.parse("one *a*\n");
+
+	sut_assert(!document[0].isInlineDeferred());
+}
+
+// Preview Limits --------------------------------------------------------------
+
+void
+test_preview_cuts_text_at_visible_char_limit()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 10;
+
+	Document document = parser.parse("Hello *big* world\n\nnever parsed\n", options);
+	sut_assert(document.getStatus() == PARSE_VISIBLE_CHAR_LIMIT_REACHED);
+	sut_assert(document.size() == 1);
+	sut_assert(document[0].size() == 3);
+	sut_assert(document[0][0].getText() == "Hello ");
+	sut_assert(document[0][1].getText() == "big");
+	sut_assert(document[0][2].getText() == " ");
+}
+
+void
+test_preview_cuts_at_character_boundary()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 2;
+
+	Document document = parser.parse("h\xc3\xa9llo\n", options);
+	sut_assert(document[0][0].getText() == "h\xc3\xa9");
+}
+
+void
+test_preview_closes_open_list()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 5;
+
+	Document document = parser.parse("* one\n* two\n* three\n\nafter\n", options);
+	sut_assert(document.size() == 1);
+	sut_assert(document[0].getType() == LIST);
+	sut_assert(document[0].size() == 2);
+	sut_assert(document[0][1][0].getText() == "tw");
+}
+
+void
+test_preview_text_fitting_exactly_is_complete()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 5;
+
+	Document document = parser.parse("short\n", options);
+	sut_assert(document.getStatus() == PARSE_COMPLETE);
+	sut_assert(document[0][0].getText() == "short");
+}
+
+void
+test_preview_cuts_autolink_text()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 3;
+
+	Document document = parser.parse("<http://example.com/a/long/path>\n\nmore\n", options);
+	sut_assert(document.getStatus() == PARSE_VISIBLE_CHAR_LIMIT_REACHED);
+	sut_assert(document.size() == 1);
+	sut_assert(document[0][0].getType() == AUTOLINK);
+	sut_assert(document[0][0].getText() == "htt");
+	sut_assert(document[0][0].getAttribute("link") == "http://example.com/a/long/path");
+}
+
+void
+test_preview_drops_autolink_past_limit()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 4;
+
+	Document document = parser.parse("text <http://example.com>\n", options);
+	sut_assert(document.getStatus() == PARSE_VISIBLE_CHAR_LIMIT_REACHED);
+	sut_assert(document[0].size() == 1);
+	sut_assert(document[0][0].getText() == "text");
+}
+
+void
+test_preview_stops_at_block_limit()
+{
+	ParseOptions options;
+	options.maxBlocks = 2;
+
+	Document document = parser.parse("one\n\n    two\n\nthree\n\nfour\n", options);
+	sut_assert(document.getStatus() == PARSE_BLOCK_LIMIT_REACHED);
+	sut_assert(document.size() == 2);
+	sut_assert(document[1].getType() == BLOCK_CODE);
+}
+
+void
+test_preview_cut_at_end_of_block_is_reported()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 6;
+
+	Document document = parser.parse("ab  \ncd efgh\n", options);
+	sut_assert(document.getStatus() == PARSE_VISIBLE_CHAR_LIMIT_REACHED);
+	sut_assert(document[0].size() == 3);
+	sut_assert(document[0][0].getText() == "ab");
+	sut_assert(document[0][1].getType() == LINEBREAK);
+	sut_assert(document[0][2].getText() == "cd e");
+}
+
+void
+test_preview_cut_in_last_block_is_reported()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 8;
+
+	Document document = parser.parse("<http://a.b>\n> q\n> > r\nTitle\n===\n", options);
+	sut_assert(document.getStatus() == PARSE_VISIBLE_CHAR_LIMIT_REACHED);
+}
+
+void
+test_preview_line_break_spaces_are_not_counted()
+{
+	ParseOptions options;
+	options.maxVisibleChars = 40;
+
+	Document document = parser.parse("one two three  \nfour five six  \nseven eight nine ten eleven\n", options);
+	size_t visible = 0;
+
+	for (size_t i = 0; i < document[0].size(); i++) {
+		visible += document[0][i].getText().size();
+	}
+
+	sut_assert(document.getStatus() == PARSE_VISIBLE_CHAR_LIMIT_REACHED);
+	sut_assert(visible == 40);
+}
+
+void
+test_preview_block_limit_within_one_step()
+{
+	ParseOptions options;
+	options.maxBlocks = 1;
+
+	Document document = parser.parse("para\nTitle\n=====\n\nmore\n", options);
+	sut_assert(document.getStatus() == PARSE_BLOCK_LIMIT_REACHED);
+	sut_assert(document.size() == 1);
+	sut_assert(document[0].getType() == PARAGRAPH);
+}
+
+// Elements of Type ------------------------------------------------------------
+
+void
+test_elements_of_type_in_document_order()
+{
+	Document document = parser.parse("[a](http://a)\n\n* [b](http://b) **x**\n\n> [c](http://c)\n");
+	const std::vector<const Element*>& links = document.getElementsOfType(LINK);
+
+	sut_assert(links.size() == 3);
+	sut_assert(links[0]->getAttribute("link") == "http://a");
+	sut_assert(links[1]->getAttribute("link") == "http://b");
+	sut_assert(links[2]->getAttribute("link") == "http://c");
+	sut_assert(document.getElementsOfType(DOUBLE_EMPHASIS).size() == 1);
+	sut_assert(document.getElementsOfType(LIST_ITEM).size() == 1);
+}
+
+void
+test_elements_of_type_of_deferred_elements()
+{
+	ParseOptions options;
+	options.lazyInline = true;
+	Document document = parser.parse("a *b* c *d*\n", options);
+
+	sut_assert(document.getElementsOfType(EMPHASIS).size() == 2);
+	sut_assert(document.getElementsOfType(EMPHASIS)[1]->getText() == "d");
+}
+
+// Source Positions ------------------------------------------------------------
+
+static std::string
+source_of(Document& document, size_t block, Element element, const std::string& markdown)
+{
+	return markdown.substr(document.getOffset(block) + element.getSourceOffset(), element.getSourceLength());
+}
+
+void
+test_source_spans_include_their_markup()
+{
+	std::string markdown = "para **bold** and `code`  \nnext [l](http://a)\n";
+	Document document = parser.parse(markdown);
+	Element paragraph = document[0];
+
+	sut_assert(source_of(document, 0, paragraph, markdown) == "para **bold** and `code`  \nnext [l](http://a)");
+	sut_assert(source_of(document, 0, paragraph[0], markdown) == "para ");
+	sut_assert(source_of(document, 0, paragraph[1], markdown) == "**bold**");
+	sut_assert(source_of(document, 0, paragraph[3], markdown) == "`code`");
+	sut_assert(paragraph[5].getType() == LINEBREAK);
+	sut_assert(source_of(document, 0, paragraph[5], markdown) == "  \n");
+	sut_assert(source_of(document, 0, paragraph[7], markdown) == "[l](http://a)");
+}
+
+void
+test_source_offsets_are_relative_to_the_block()
+{
+	std::string markdown = "# Title\n\n\ntext *em*\n";
+	Document document = parser.parse(markdown);
+
+	sut_assert(document.getOffset(1) == 10);
+	sut_assert(document[1].getSourceOffset() == 0);
+	sut_assert(source_of(document, 0, document[0], markdown) == "# Title");
+	sut_assert(source_of(document, 0, document[0][0], markdown) == "Title");
+	sut_assert(source_of(document, 1, document[1][1], markdown) == "*em*");
+}
+
+void
+test_source_accounts_for_references_and_carriage_returns()
+{
+	std::string markdown = "one\r\n[id]: http://example.com\r\n*two*\r\n\r\n> [three][id]\r\n";
+	Document document = parser.parse(markdown);
+
+	sut_assert(source_of(document, 0, document[0], markdown) == "one");
+	sut_assert(source_of(document, 1, document[1][0], markdown) == "*two*");
+	sut_assert(source_of(document, 2, document[2], markdown) == "> [three][id]");
+	sut_assert(source_of(document, 2, document[2][0][0], markdown) == "[three][id]");
+}
+
+void
+test_source_follows_list_item_and_quote_lines()
+{
+	std::string markdown = "* one\n  two *b*\n* q\n\n    > a\n    > *r*\n";
+	Document document = parser.parse(markdown);
+	Element list = document[0];
+
+	sut_assert(source_of(document, 0, list[0], markdown) == "* one\n  two *b*");
+	sut_assert(source_of(document, 0, list[0][2], markdown) == "*b*");
+	sut_assert(source_of(document, 0, list[1][1], markdown) == "> a\n    > *r*");
+	sut_assert(source_of(document, 0, list[1][1][0][2], markdown) == "*r*");
+}
+
+void
+test_source_of_deferred_inline_text()
+{
+	std::string markdown = "* one\n  two *b*\n";
+	ParseOptions options;
+	options.lazyInline = true;
+	Document document = parser.parse(markdown, options);
+
+	sut_assert(source_of(document, 0, document[0][0][2], markdown) == "*b*");
+}
+
+void
+test_source_survives_reparse()
+{
+	std::string before = "one\n\ntwo *x*\n";
+	std::string after = "zero\n\none\n\ntwo *x*\n";
+	Document previous = parser.parse(before);
+	EditRange edit = { 0, 0, 6 };
+	Document document = parser.reparse(previous, edit, after);
+
+	sut_assert(document.size() == 3);
+	sut_assert(source_of(document, 2, document[2][1], after) == "*x*");
+}
+
+void
+test_source_of_cached_block_needs_same_line_endings()
+{
+	BlockCache cache(1 << 20);
+	ParseOptions options;
+	options.blockCache = &cache;
+	parser.parse("a *b* c\nd *e*\n", options);
+
+	std::string markdown = "a *b* c\r\nd *e*\r\n";
+	Document document = parser.parse(markdown, options);
+
+	sut_assert(source_of(document, 0, document[0][4], markdown) == "*e*");
+}
+
+static bool
+same_sources(Element eager, Element lazy)
+{
+	if (eager.getSourceOffset() != lazy.getSourceOffset() || eager.getSourceLength() != lazy.getSourceLength()
+		|| eager.size() != lazy.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < eager.size(); i++) {
+		if (!same_sources(eager[i], lazy[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool
+nested_sources(Element element)
+{
+	for (size_t i = 0; i < element.size(); i++) {
+		Element child = element[i];
+
+		if (child.getSourceLength() && (child.getSourceOffset() < element.getSourceOffset()
+			|| child.getSourceOffset() + child.getSourceLength() > element.getSourceOffset() + element.getSourceLength()
+			|| !nested_sources(child))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void
+test_source_of_deferred_inline_matches_eager()
+{
+	std::string markdown = "- a\n- b *c*\n  d  \n  e\n\n> q `r`\n> s\n\nTitle\n=====\n\n1. x\n\n   y [z](http://z)\n";
+	ParseOptions options;
+	options.lazyInline = true;
+	Document eager = parser.parse(markdown);
+	Document lazy = parser.parse(markdown, options);
+
+	sut_assert(eager.size() == lazy.size());
+
+	for (size_t i = 0; i < eager.size(); i++) {
+		sut_assert(eager.getOffset(i) == lazy.getOffset(i));
+		sut_assert(same_sources(eager[i], lazy[i]));
+	}
+}
+
+void
+test_source_of_children_within_parent()
+{
+	std::string markdown = "- a\n[x]: http://x.com\n\nb\n\n- c\n- d\n";
+	Document document = parser.parse(markdown);
+
+	sut_assert(source_of(document, 0, document[0][0], markdown) == "- a");
+	sut_assert(document.getOffset(0) + document[0][0][1].getSourceOffset() + document[0][0][1].getSourceLength() <= 3);
+
+	for (size_t i = 0; i < document.size(); i++) {
+		sut_assert(nested_sources(document[i]));
+	}
+}
@@ -0,0 +1,159 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include "basic_parser.h"
+#include "builders.h"
+#include "plain_text.h"
+
+using namespace Bypass;
+
+static const char* MARKDOWN =
+	"Header\n======\n\n"
+	"Some *emphasis*, **strong** and `code`.  \n"
+	"A [link](http://example.com \"Example\") and <http://example.com>.\r\n\r\n"
+	"* one\n* two\n  more\n\n"
+	"> quoted\n> twice\n\n"
+	"    block code\n    lines\n\n"
+	"[a]: http://example.com\n"
+	"Fin & done\n";
+
+void
+test_text()
+{
+	PlainText plainText = PlainText::parse("# Title\n\nSome *emphasis* here.\n\n* a\n* b\n");
+
+	sut_assert(plainText.getText() == "Title\nSome emphasis here.\na\nb\n");
+	sut_assert(plainText.getNodeCount() == 13);
+	sut_assert(plainText.getNodeType(4) == EMPHASIS);
+	sut_assert(plainText.getNodeParent(4) == 2);
+	sut_assert(plainText.getNodeParent(2) == PlainText::NO_NODE);
+}
+
+void
+test_entities_are_kept()
+{
+	sut_assert(PlainText::parse("a &amp; b\n").getText() == "a &amp; b\n");
+}
+
+void
+test_nodes()
+{
+	PlainText plainText = PlainText::parse("# Title\n\nSome *emphasis* here.\n");
+	size_t nodeOffset = 0;
+
+	sut_assert(plainText.getNode(13, &nodeOffset) == 4);
+	sut_assert(nodeOffset == 2);
+	sut_assert(plainText.getNode(0) == 1);
+	sut_assert(plainText.getNode(5) == PlainText::NO_NODE);
+	sut_assert(plainText.getNode(1000) == PlainText::NO_NODE);
+	sut_assert(plainText.getTextOffset(4) == 11);
+	sut_assert(plainText.getTextOffset(0) == std::string::npos);
+}
+
+void
+test_linebreak_is_a_node()
+{
+	PlainText plainText = PlainText::parse("a  \nb\n");
+
+	sut_assert(plainText.getText() == "a\nb\n");
+	sut_assert(plainText.getNodeType(plainText.getNode(1)) == LINEBREAK);
+}
+
+void
+test_source_offsets()
+{
+	std::string markdown = "# Title\n\nSome *emphasis* here.\n";
+	PlainText plainText = PlainText::parse(markdown);
+
+	sut_assert(plainText.getSourceOffset(0) == 2);
+	sut_assert(plainText.getSourceOffset(11) == 15);
+	sut_assert(plainText.getOffset(15) == 11);
+	sut_assert(plainText.getOffset(14) == 11);
+	sut_assert(plainText.getOffset(0) == 0);
+	sut_assert(plainText.getOffset(markdown.size()) == plainText.getText().size());
+}
+
+void
+test_indented_lines_map_exactly()
+{
+	std::string markdown = "* one\n* two\n  more\n\n> a\n> b\n";
+	PlainText plainText = PlainText::parse(markdown);
+	const std::string& text = plainText.getText();
+
+	sut_assert(text == "one\ntwo\nmore\na\nb\n");
+	sut_assert(plainText.getSourceOffset(text.find("more")) == markdown.find("more"));
+	sut_assert(plainText.getSourceOffset(text.rfind("b")) == markdown.rfind("b"));
+}
+
+void
+test_round_trip()
+{
+	std::string markdown = MARKDOWN;
+	PlainText plainText = PlainText::parse(markdown);
+	const std::string& text = plainText.getText();
+	size_t mapped = 0;
+
+	for (size_t offset = 0; offset < text.size(); offset++) {
+		size_t source = plainText.getSourceOffset(offset);
+
+		if (source < markdown.size() && markdown[source] == text[offset] && plainText.getOffset(source) == offset) {
+			mapped++;
+		}
+	}
+
+	sut_assert(text.find("emphasis, strong and code.\nA link and http://example.com.") != std::string::npos);
+	sut_assert(text.find("block code\nlines") != std::string::npos);
+	sut_assert(mapped > text.size() * 3 / 4);
+
+	for (size_t source = 1; source < markdown.size(); source++) {
+		sut_assert(plainText.getOffset(source - 1) <= plainText.getOffset(source));
+	}
+}
+
+void
+test_nodes_match_flat_builder()
+{
+	PlainText plainText = PlainText::parse(MARKDOWN);
+	FlatBuilder builder;
+	BasicParser<FlatBuilder>(builder).parse(MARKDOWN);
+	const std::vector<FlatNode>& nodes = builder.getNodes();
+
+	sut_assert(plainText.getNodeCount() == nodes.size());
+
+	for (size_t i = 0; i < nodes.size(); i++) {
+		sut_assert(plainText.getNodeType(i) == nodes[i].type);
+		sut_assert(plainText.getNodeParent(i) == nodes[i].parent);
+
+		if (nodes[i].textLength > 0) {
+			size_t offset = plainText.getTextOffset(i);
+			sut_assert(plainText.getText().compare(offset, nodes[i].textLength,
+				builder.getStrings(), nodes[i].textOffset, nodes[i].textLength) == 0);
+		}
+	}
+}
+
+void
+test_empty()
+{
+	PlainText plainText = PlainText::parse((const char*) NULL);
+
+	sut_assert(plainText.getText().empty());
+	sut_assert(plainText.getNode(0) == PlainText::NO_NODE);
+	sut_assert(plainText.getSourceOffset(0) == 0);
+	sut_assert(plainText.getOffset(0) == 0);
+	sut_assert(PlainText::parse("").getNodeCount() == 0);
+}
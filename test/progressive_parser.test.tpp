@@ -0,0 +1,106 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include <vector>
+#include "progressive_parser.h"
+
+using namespace Bypass;
+
+static std::vector<std::function<void()> > tasks;
+static std::vector<Document> completed;
+
+static void
+queue(const std::function<void()>& task)
+{
+	tasks.push_back(task);
+}
+
+static void
+record(const Document& rest)
+{
+	completed.push_back(rest);
+}
+
+static void
+runTasks()
+{
+	for (size_t i = 0; i < tasks.size(); i++) {
+		tasks[i]();
+	}
+
+	tasks.clear();
+}
+
+void
+test_first_screen_is_limited_by_blocks()
+{
+	ProgressiveParser parser(queue);
+	Document first = parser.parse("one\n\ntwo\n\nthree\n\nfour\n", 2, 1000, record);
+
+	sut_assert(first.size() == 2);
+	sut_assert(first[1][0].getText() == "two");
+	sut_assert(completed.empty());
+	sut_assert(tasks.size() == 1);
+
+	runTasks();
+
+	sut_assert(completed.size() == 1);
+	sut_assert(completed[0].size() == 2);
+	sut_assert(completed[0][0].getText().empty());
+	sut_assert(completed[0][0][0].getText() == "three");
+	sut_assert(completed[0].getId(0) == 2);
+	sut_assert(completed[0].getOffset(1) == 17);
+	sut_assert(completed[0].getStatus() == PARSE_COMPLETE);
+}
+
+void
+test_first_screen_is_limited_by_output()
+{
+	ProgressiveParser parser(queue);
+	Document first = parser.parse("a long first paragraph\n\ntwo\n\nthree\n", 10, 5, record);
+
+	sut_assert(first.size() == 1);
+
+	runTasks();
+
+	sut_assert(completed[0].size() == 2);
+}
+
+void
+test_first_screen_resolves_later_references()
+{
+	ProgressiveParser parser(queue);
+	Document first = parser.parse("[link][ref]\n\ntwo\n\n[ref]: http://example.com\n", 1, 1000, record);
+
+	sut_assert(first[0][0].getType() == LINK);
+	sut_assert(first[0][0].getAttribute("link") == "http://example.com");
+}
+
+void
+test_completion_runs_on_executor_when_done_synchronously()
+{
+	ProgressiveParser parser(queue);
+	Document first = parser.parse("only\n", 10, 1000, record);
+
+	sut_assert(first.size() == 1);
+	sut_assert(completed.empty());
+
+	runTasks();
+
+	sut_assert(completed.size() == 1);
+	sut_assert(completed[0].size() == 0);
+}
@@ -0,0 +1,167 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include "parser.h"
+#include "source_index.h"
+#include "sut_test.h"
+
+using namespace Bypass;
+
+static Parser parser;
+
+void
+test_empty_index()
+{
+	SourceIndex index;
+
+	sut_assert(index.getNodeCount() == 0);
+	sut_assert(index.getNode(0) == SourceIndex::NO_NODE);
+}
+
+void
+test_nodes_in_document_order()
+{
+	Document document = parser.parse("# Title\n\ntext *em*\n");
+	SourceIndex index(document);
+
+	sut_assert(index.getNodeCount() == 5);
+	sut_assert(index.getNodeType(0) == HEADER);
+	sut_assert(index.getNodeType(1) == TEXT);
+	sut_assert(index.getNodeParent(1) == 0);
+	sut_assert(index.getNodeType(2) == PARAGRAPH);
+	sut_assert(index.getNodeParent(2) == SourceIndex::NO_NODE);
+	sut_assert(index.getNodeType(4) == EMPHASIS);
+	sut_assert(index.getNodeParent(4) == 2);
+	sut_assert(index.getNodeBlock(4) == 1);
+	sut_assert(index.getBlockNode(1) == 2);
+	sut_assert(index.getElement(4).getType() == EMPHASIS);
+}
+
+void
+test_node_ranges_are_absolute()
+{
+	Document document = parser.parse("# Title\n\ntext *em*\n");
+	SourceIndex index(document);
+
+	sut_assert(index.getNodeOffset(2) == 9);
+	sut_assert(index.getNodeLength(2) == 9);
+	sut_assert(index.getNodeOffset(4) == 14);
+	sut_assert(index.getNodeLength(4) == 4);
+}
+
+void
+test_deepest_node_at_offset()
+{
+	std::string markdown = "# Title\n\ntext *em*\n\n> * a **b**\n";
+	Document document = parser.parse(markdown);
+	SourceIndex index(document);
+
+	sut_assert(index.getNodeType(index.getNode(2)) == TEXT);
+	sut_assert(index.getNode(0) == 0);
+	sut_assert(index.getNode(8) == SourceIndex::NO_NODE);
+	sut_assert(index.getNodeType(index.getNode(14)) == EMPHASIS);
+	sut_assert(index.getNode(17) == index.getNode(14));
+	sut_assert(index.getNode(18) == SourceIndex::NO_NODE);
+	sut_assert(index.getNodeType(index.getNode(20)) == BLOCK_QUOTE);
+	sut_assert(index.getNodeType(index.getNode(markdown.find("**"))) == DOUBLE_EMPHASIS);
+	sut_assert(index.getNode(markdown.size()) == SourceIndex::NO_NODE);
+}
+
+void
+test_node_overlapping_earlier_sibling()
+{
+	// The emphasis takes over its first child and keeps its whole range,
+	// so it overlaps the autolink and text placed after it.
+	std::string markdown = "**see <http://a.b> and more words**\n";
+	Document document = parser.parse(markdown);
+	SourceIndex index(document);
+
+	sut_assert(index.getNodeType(index.getNode(33)) == DOUBLE_EMPHASIS);
+	sut_assert(index.getNodeType(index.getNode(34)) == DOUBLE_EMPHASIS);
+	sut_assert(index.getNodeOffset(index.getNode(34)) == 0);
+	sut_assert(index.getNodeLength(index.getNode(34)) == 35);
+	sut_assert(index.getNodeType(index.getNode(markdown.find("http"))) == AUTOLINK);
+	sut_assert(index.getNode(markdown.size()) == SourceIndex::NO_NODE);
+}
+
+void
+test_nodes_clipped_to_parent()
+{
+	std::string markdown = "* one\n  two\n* three\n";
+	Document document = parser.parse(markdown);
+	SourceIndex index(document);
+
+	for (size_t node = 0; node < index.getNodeCount(); node++) {
+		size_t parent = index.getNodeParent(node);
+
+		if (parent != SourceIndex::NO_NODE && index.getNodeLength(node) > 0) {
+			sut_assert(index.getNodeOffset(node) >= index.getNodeOffset(parent));
+			sut_assert(index.getNodeOffset(node) + index.getNodeLength(node) <= index.getNodeOffset(parent) + index.getNodeLength(parent));
+		}
+	}
+
+	sut_assert(index.getNodeType(index.getNode(markdown.find("three"))) == TEXT);
+}
+
+void
+test_index_of_deferred_elements()
+{
+	ParseOptions options;
+	options.lazyInline = true;
+	Document document = parser.parse("para *em*\n", options);
+	SourceIndex index(document);
+
+	sut_assert(index.getNodeType(index.getNode(6)) == EMPHASIS);
+}
+
+void
+test_index_reuses_shared_elements()
+{
+	std::string before = "one *a*\n\ntwo *b*\n";
+	std::string after = "one *a*\n\nnew\n\ntwo *b*\n";
+	Document previous = parser.parse(before);
+	SourceIndex previousIndex(previous);
+	EditRange edit = { 9, 0, 5 };
+	Document document = parser.reparse(previous, edit, after);
+	SourceIndex index(document, previousIndex);
+	SourceIndex fresh(document);
+
+	sut_assert(index.getNodeCount() == fresh.getNodeCount());
+
+	for (size_t node = 0; node < fresh.getNodeCount(); node++) {
+		sut_assert(index.getNodeType(node) == fresh.getNodeType(node));
+		sut_assert(index.getNodeParent(node) == fresh.getNodeParent(node));
+		sut_assert(index.getNodeOffset(node) == fresh.getNodeOffset(node));
+		sut_assert(index.getNodeLength(node) == fresh.getNodeLength(node));
+	}
+
+	sut_assert(index.getNodeType(index.getNode(after.find("*b*"))) == EMPHASIS);
+	sut_assert(index.getNodeBlock(index.getNode(after.find("*b*"))) == 2);
+}
+
+void
+test_index_outlives_document()
+{
+	SourceIndex index;
+
+	{
+		Document document = parser.parse("text *em*\n");
+		index = SourceIndex(document);
+	}
+
+	sut_assert(index.getElement(index.getNode(5)).getType() == EMPHASIS);
+}
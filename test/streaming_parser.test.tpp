@@ -0,0 +1,181 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include "streaming_parser.h"
+#include "sut_test.h"
+
+using namespace Bypass;
+
+class RecordingListener : public StreamingParser::Listener {
+public:
+	std::vector<Element> finalized;
+	std::vector<Element> tail;
+	size_t tailId;
+	int finalizedEvents;
+
+	RecordingListener() : tailId(0), finalizedEvents(0) {}
+
+	void blocksFinalized(size_t firstId, const std::vector<Element>& blocks) {
+		sut_assert(firstId == finalized.size());
+		finalized.insert(finalized.end(), blocks.begin(), blocks.end());
+		finalizedEvents++;
+	}
+
+	void tailReplaced(size_t firstId, const std::vector<Element>& blocks) {
+		tailId = firstId;
+		tail = blocks;
+	}
+};
+
+void
+test_streaming_open_block_stays_in_tail()
+{
+	RecordingListener listener;
+	StreamingParser streaming(listener);
+
+	streaming.feed("hello ");
+	streaming.feed("world");
+
+	sut_assert(listener.finalized.size() == 0);
+	sut_assert(listener.tail.size() == 1);
+	sut_assert(listener.tail[0][0].getText() == "hello world");
+}
+
+void
+test_streaming_finalizes_settled_blocks_once()
+{
+	RecordingListener listener;
+	StreamingParser streaming(listener);
+
+	streaming.feed("# Title\n\nfirst para");
+	sut_assert(listener.finalized.size() == 0);
+	sut_assert(listener.tail.size() == 2);
+
+	streaming.feed("graph\n\nsecond");
+	sut_assert(listener.finalized.size() == 1);
+	sut_assert(listener.finalized[0].getType() == HEADER);
+	sut_assert(listener.tailId == 1);
+	sut_assert(listener.tail.size() == 2);
+
+	streaming.feed(" paragraph\n");
+	sut_assert(listener.finalized.size() == 2);
+	sut_assert(listener.finalized[1][0].getText() == "first paragraph");
+	sut_assert(listener.tailId == 2);
+
+	streaming.finish();
+	sut_assert(listener.finalized.size() == 3);
+	sut_assert(listener.finalized[2][0].getText() == "second paragraph");
+	sut_assert(listener.tail.size() == 0);
+	sut_assert(listener.finalizedEvents == 3);
+}
+
+void
+test_streaming_list_is_not_finalized_before_it_ends()
+{
+	RecordingListener listener;
+	StreamingParser streaming(listener);
+
+	streaming.feed("* one\n\n");
+	streaming.feed("  ");
+	sut_assert(listener.finalized.size() == 0);
+
+	streaming.feed("  continued\n\nafter\n");
+	streaming.finish();
+
+	sut_assert(listener.finalized.size() == 2);
+	sut_assert(listener.finalized[0].getType() == LIST);
+	sut_assert(listener.finalized[0].size() == 1);
+	sut_assert(listener.finalized[1].getType() == PARAGRAPH);
+}
+
+void
+test_streaming_keeps_references_from_finalized_input()
+{
+	RecordingListener listener;
+	StreamingParser streaming(listener);
+
+	streaming.feed("[id]: http://example.com\n\nfirst\n\n");
+	streaming.feed("second\n\n[link][id]");
+	streaming.finish();
+
+	sut_assert(listener.finalized.size() == 3);
+	sut_assert(listener.finalized[2][0].getType() == LINK);
+	sut_assert(listener.finalized[2][0].getAttribute("link") == "http://example.com");
+}
+
+void
+test_read_stream_resolves_references_defined_later()
+{
+	RecordingListener listener;
+	StreamingParser streaming(listener);
+	std::istringstream in("# Title\n\n[link][id]\n\n* one\n* two\n\n"
+			"[id]: http://example.com\n  \"Example\"\n");
+
+	streaming.read(in, 7);
+
+	sut_assert(listener.finalized.size() == 3);
+	sut_assert(listener.finalized[0].getType() == HEADER);
+	sut_assert(listener.finalized[1][0].getType() == LINK);
+	sut_assert(listener.finalized[1][0].getAttribute("link") == "http://example.com");
+	sut_assert(listener.finalized[1][0].getAttribute("title") == "Example");
+	sut_assert(listener.finalized[2].getType() == LIST);
+	sut_assert(listener.tail.size() == 0);
+}
+
+void
+test_read_stream_skips_the_rest_of_long_lines()
+{
+	// The scan drops the long line early, and must not take the chunk that
+	// starts in the middle of it for the start of a definition.
+
+	RecordingListener listener;
+	StreamingParser streaming(listener);
+	std::string line = std::string(70, 'a') + "[other]: http://wrong " + std::string(2000, 'a');
+	std::istringstream in("[x][other] [y][id]\n\n" + line + "\n\n[id]: http://example.com\n");
+
+	streaming.read(in, 7);
+
+	sut_assert(listener.finalized.size() == 2);
+	sut_assert(listener.finalized[0].size() == 3);
+	sut_assert(listener.finalized[0][1].getType() == TEXT);
+	sut_assert(listener.finalized[0][1].getText() == "[other] ");
+	sut_assert(listener.finalized[0][2].getType() == LINK);
+	sut_assert(listener.finalized[0][2].getAttribute("link") == "http://example.com");
+}
+
+void
+test_read_pipe_parses_every_block()
+{
+	RecordingListener listener;
+	StreamingParser streaming(listener);
+	std::string markdown = "one\n\ntwo\n\n    three\n";
+	int fds[2];
+
+	sut_assert(pipe(fds) == 0);
+	sut_assert(write(fds[1], markdown.data(), markdown.size()) == (ssize_t) markdown.size());
+	close(fds[1]);
+
+	streaming.read(fds[0], 4);
+	close(fds[0]);
+
+	sut_assert(listener.finalized.size() == 3);
+	sut_assert(listener.finalized[1][0].getText() == "two");
+	sut_assert(listener.finalized[2].getType() == BLOCK_CODE);
+}
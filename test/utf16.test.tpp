@@ -0,0 +1,183 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <stdlib.h>
+#include <string>
+#include "parser.h"
+#include "utf16.h"
+
+using namespace Bypass;
+
+// é is two bytes and one unit, € three bytes and one unit, and 😀 four
+// bytes and two units.
+static const char* PIECES[] = { "a", "b", " ", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80" };
+
+static std::string
+randomText(size_t characters, std::vector<size_t>& starts)
+{
+	std::string text;
+
+	for (size_t i = 0; i < characters; i++) {
+		starts.push_back(text.size());
+		text += PIECES[rand() % 6];
+	}
+
+	return text;
+}
+
+static size_t
+slowUtf16Length(const std::string& text, size_t end)
+{
+	size_t units = 0;
+
+	for (size_t i = 0; i < end; i++) {
+		unsigned char c = text[i];
+
+		if ((c & 0xC0) != 0x80) {
+			units += c >= 0xF0 ? 2 : 1;
+		}
+	}
+
+	return units;
+}
+
+void
+test_length()
+{
+	sut_assert(utf16Length("", 0) == 0);
+	sut_assert(utf16Length("plain ascii text", 16) == 16);
+	sut_assert(utf16Length("\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", 9) == 4);
+	srand(7);
+
+	for (int n = 0; n < 200; n++) {
+		std::vector<size_t> starts;
+		std::string text = randomText(rand() % 100, starts);
+		sut_assert(utf16Length(text.data(), text.size()) == slowUtf16Length(text, text.size()));
+	}
+}
+
+void
+test_index_round_trip()
+{
+	srand(11);
+
+	for (int n = 0; n < 50; n++) {
+		std::vector<size_t> starts;
+		std::string text = randomText(rand() % 400, starts);
+		starts.push_back(text.size());
+		Utf16Index index(text.data(), text.size());
+
+		sut_assert(index.getByteLength() == text.size());
+		sut_assert(index.getLength() == slowUtf16Length(text, text.size()));
+
+		for (size_t i = 0; i < starts.size(); i++) {
+			size_t units = index.toUtf16(text.data(), starts[i]);
+			sut_assert(units == slowUtf16Length(text, starts[i]));
+			sut_assert(index.toUtf8(text.data(), units) == starts[i]);
+		}
+	}
+}
+
+void
+test_inside_surrogate_pair()
+{
+	std::string text = "a\xf0\x9f\x98\x80" "b";
+	Utf16Index index(text.data(), text.size());
+
+	sut_assert(index.getLength() == 4);
+	sut_assert(index.toUtf8(text.data(), 2) == 5);
+	sut_assert(index.toUtf8(text.data(), 100) == text.size());
+}
+
+void
+test_append_and_truncate()
+{
+	srand(13);
+	std::vector<size_t> starts;
+	std::string text = randomText(300, starts);
+	Utf16Index whole(text.data(), text.size());
+	Utf16Index pieces;
+
+	for (size_t i = 0; i < text.size(); ) {
+		size_t length = std::min(text.size() - i, (size_t) (rand() % 90));
+		pieces.append(text.data() + i, length);
+		i += length;
+	}
+
+	sut_assert(pieces.getLength() == whole.getLength());
+	sut_assert(pieces.getFootprint() == 0 || pieces.getFootprint() >= sizeof(uint32_t));
+
+	for (size_t i = 0; i < starts.size(); i += 17) {
+		Utf16Index truncated(text.data(), text.size());
+		truncated.truncate(text.data(), starts[i]);
+		sut_assert(truncated.getByteLength() == starts[i]);
+		sut_assert(truncated.getLength() == slowUtf16Length(text, starts[i]));
+		sut_assert(truncated.toUtf16(text.data(), starts[i]) == truncated.getLength());
+
+		truncated.append(text.data() + starts[i], text.size() - starts[i]);
+		sut_assert(truncated.getLength() == whole.getLength());
+	}
+}
+
+void
+test_short_text_needs_no_checkpoints()
+{
+	Utf16Index index("short", 5);
+
+	sut_assert(index.getFootprint() == 0);
+	sut_assert(index.toUtf16("short", 3) == 3);
+}
+
+void
+test_parser_indexes_elements()
+{
+	std::string line = "caf\xc3\xa9 \xf0\x9f\x98\x80 ";
+	std::string markdown;
+
+	for (int i = 0; i < 20; i++) {
+		markdown += line;
+	}
+
+	markdown += "`\xe2\x82\xac`\n";
+
+	ParseOptions options;
+	options.utf16Offsets = true;
+	Parser parser;
+	Document document = parser.parse(markdown, options);
+	Element text = document[0][0];
+	Element code = document[0][1];
+
+	sut_assert(text.getText() == markdown.substr(0, line.size() * 20));
+	sut_assert(text.getUtf16Length() == 20 * 8);
+	sut_assert(text.getUtf16Offset(line.size()) == 8);
+	sut_assert(text.getByteOffset(8) == line.size());
+	sut_assert(text.getFootprint() > Parser().parse(markdown)[0][0].getFootprint());
+	sut_assert(code.getType() == CODE_SPAN && code.getUtf16Length() == 1);
+}
+
+void
+test_unindexed_elements_scan()
+{
+	Parser parser;
+	Element text = parser.parse("na\xc3\xafve \xf0\x9f\x98\x80\n")[0][0];
+
+	sut_assert(text.getUtf16Length() == 8);
+	sut_assert(text.getUtf16Offset(7) == 6);
+	sut_assert(text.getByteOffset(6) == 7);
+
+	text.setText("\xe2\x82\xac");
+	sut_assert(text.getUtf16Length() == 1);
+}
@@ -0,0 +1,192 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include "json_writer.h"
+#include "parser.h"
+#include "streaming_parser.h"
+#include "utf8.h"
+
+using namespace Bypass;
+
+static const char* VALID[] = {
+	"", "plain", "\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80", "\xed\x9f\xbf", "\xee\x80\x80",
+	"\xef\xbf\xbf", "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf", "caf\xc3\xa9 \xf0\x9f\x98\x80"
+};
+
+static const char* INVALID[] = {
+	"\x80", "\xbf", "\xc0\x80", "\xc1\xbf", "\xc2", "\xc2\x41", "\xe0\x80\x80", "\xe0\x9f\xbf",
+	"\xed\xa0\x80", "\xe2\x82", "\xf0\x80\x80\x80", "\xf0\x8f\xbf\xbf", "\xf4\x90\x80\x80",
+	"\xf5\x80\x80\x80", "\xff", "\xfe"
+};
+
+static void
+expectValid(const std::string& text)
+{
+	sut_assert(isValidUtf8(text.data(), text.size()));
+	sut_assert(findInvalidUtf8(text.data(), text.size()) == text.size());
+}
+
+void
+test_validation()
+{
+	for (size_t i = 0; i < sizeof(VALID) / sizeof(VALID[0]); i++) {
+		expectValid(VALID[i]);
+	}
+
+	for (size_t i = 0; i < sizeof(INVALID) / sizeof(INVALID[0]); i++) {
+		std::string text = std::string("0123456789abcdefghij") + INVALID[i] + "tail";
+		sut_assert(!isValidUtf8(text.data(), text.size()));
+		sut_assert(findInvalidUtf8(text.data(), text.size()) == 20);
+	}
+}
+
+void
+test_repair()
+{
+	std::string fffd = "\xef\xbf\xbd";
+
+	sut_assert(repairUtf8("ok", 2) == "ok");
+	sut_assert(repairUtf8("a\xff" "b", 3) == "a" + fffd + "b");
+	sut_assert(repairUtf8("\xe2\x82" "x", 3) == fffd + "x");
+	sut_assert(repairUtf8("\xf0\x9f\x98", 3) == fffd);
+	sut_assert(repairUtf8("\xc0\x80", 2) == fffd + fffd);
+	sut_assert(repairUtf8("\xed\xa0\x80", 3) == fffd + fffd + fffd);
+}
+
+void
+test_repair_is_always_valid()
+{
+	srand(3);
+
+	for (int n = 0; n < 1000; n++) {
+		std::string text;
+		size_t length = rand() % 64;
+
+		for (size_t i = 0; i < length; i++) {
+			text += (char) (rand() % 3 == 0 ? 'a' : 0x80 + rand() % 0x80);
+		}
+
+		std::string repaired = repairUtf8(text.data(), text.size());
+		expectValid(repaired);
+
+		if (isValidUtf8(text.data(), text.size())) {
+			sut_assert(repaired == text);
+		}
+	}
+}
+
+void
+test_complete_length()
+{
+	sut_assert(completeUtf8Length("abc", 3) == 3);
+	sut_assert(completeUtf8Length("ab\xe2\x82", 4) == 2);
+	sut_assert(completeUtf8Length("ab\xf0", 3) == 2);
+	sut_assert(completeUtf8Length("ab\xe2\x82\xac", 5) == 5);
+	sut_assert(completeUtf8Length("ab\xe2\x41", 4) == 4);
+	sut_assert(completeUtf8Length("ab\x80", 3) == 3);
+	sut_assert(completeUtf8Length("", 0) == 0);
+}
+
+void
+test_parser_replaces_by_default()
+{
+	Parser parser;
+	Document document = parser.parse("bad \xff byte and *\xe2\x82*\n");
+
+	sut_assert(document.getStatus() == PARSE_COMPLETE);
+	sut_assert(document[0][0].getText() == "bad \xef\xbf\xbd byte and ");
+	sut_assert(document[0][1].getText() == "\xef\xbf\xbd");
+}
+
+void
+test_parser_rejects()
+{
+	ParseOptions options;
+	options.utf8Policy = UTF8_REJECT;
+	Parser parser;
+	Document document = parser.parse("fine\n\nbad \xff\n", options);
+
+	sut_assert(document.getStatus() == PARSE_INVALID_UTF8);
+	sut_assert(document.size() == 0);
+	sut_assert(parser.parse("fine \xc3\xa9\n", options).getStatus() == PARSE_COMPLETE);
+
+	std::ostringstream json;
+	JsonWriter::write(json, document);
+	sut_assert(json.str() == "{\"status\":\"INVALID_UTF8\",\"children\":[]}");
+}
+
+void
+test_parser_passes_through()
+{
+	ParseOptions options;
+	options.utf8Policy = UTF8_PASS_THROUGH;
+	Parser parser;
+
+	sut_assert(parser.parse("bad \xff\n", options)[0][0].getText() == "bad \xff");
+}
+
+void
+test_reparse_of_invalid_input()
+{
+	Parser parser;
+	std::string markdown = "one \xff\n\ntwo\n\nthree\n";
+	Document previous = parser.parse(markdown);
+	EditRange edit;
+	edit.offset = markdown.find("two");
+	edit.removedLength = 3;
+	edit.insertedLength = 3;
+	markdown.replace(edit.offset, 3, "TWO");
+	Document document = parser.reparse(previous, edit, markdown);
+
+	sut_assert(document.size() == 3);
+	sut_assert(document[1][0].getText() == "TWO");
+	sut_assert(document.getOffset(2) == parser.parse(markdown).getOffset(2));
+}
+
+class Collector : public StreamingParser::Listener {
+public:
+	std::vector<Element> blocks;
+
+	void blocksFinalized(size_t firstId, const std::vector<Element>& finalized) {
+		blocks.insert(blocks.end(), finalized.begin(), finalized.end());
+	}
+
+	void tailReplaced(size_t firstId, const std::vector<Element>& tail) {
+
+	}
+};
+
+void
+test_streaming_keeps_split_characters()
+{
+	std::string markdown = "caf\xc3\xa9\n\n\xe2\x82\xac and \xff\n\nend\n";
+	Collector collector;
+	StreamingParser streaming(collector);
+
+	for (size_t i = 0; i < markdown.size(); i++) {
+		streaming.feed(markdown.data() + i, 1);
+	}
+
+	streaming.finish();
+
+	sut_assert(collector.blocks.size() == 3);
+	sut_assert(collector.blocks[0][0].getText() == "caf\xc3\xa9");
+	sut_assert(collector.blocks[1][0].getText() == "\xe2\x82\xac and \xef\xbf\xbd");
+	sut_assert(collector.blocks[2][0].getText() == "end");
+}
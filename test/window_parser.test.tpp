@@ -0,0 +1,144 @@
+//
+//  Copyright 2013 Uncodin, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string>
+#include <stdio.h>
+#include "window_parser.h"
+
+using namespace Bypass;
+
+static const char* MARKDOWN =
+	"# Title\n\n"
+	"A paragraph with a [reference][ref].\n"
+	"Setext\n------\n\n"
+	"* one\n* two\n\n"
+	"- - -\n\n"
+	"> quote\n> more\n\n"
+	"    code\n\n"
+	"[ref]: http://example.com\n"
+	"*last* paragraph\n";
+
+static void
+describe(std::string& out, Element element)
+{
+	char type[8];
+	snprintf(type, sizeof type, "%x(", element.getType());
+	out += type;
+	out += element.getText();
+
+	for (Element::AttributeMap::iterator it = element.attrBegin(); it != element.attrEnd(); ++it) {
+		out += " " + it->first + "=" + it->second;
+	}
+
+	for (size_t i = 0; i < element.size(); i++) {
+		describe(out, element[i]);
+	}
+
+	out += ")";
+}
+
+void
+test_block_count_matches_full_parse()
+{
+	Parser parser;
+	WindowParser window;
+	window.load(MARKDOWN);
+
+	sut_assert(window.getBlockCount() == parser.parse(MARKDOWN).size());
+}
+
+void
+test_every_window_matches_full_parse()
+{
+	Parser parser;
+	Document document = parser.parse(MARKDOWN);
+
+	for (size_t first = 0; first < document.size(); first++) {
+		for (size_t count = 1; first + count <= document.size(); count++) {
+			WindowParser window;
+			window.load(MARKDOWN);
+			std::vector<Element> blocks = window.getBlocks(first, count);
+
+			sut_assert(blocks.size() == count);
+
+			for (size_t i = 0; i < count; i++) {
+				std::string expected, actual;
+				describe(expected, document[first + i]);
+				describe(actual, blocks[i]);
+				sut_assert(actual == expected);
+				sut_assert(window.getBlockOffset(first + i) == document.getOffset(first + i));
+			}
+		}
+	}
+}
+
+void
+test_stray_elements_are_skipped()
+{
+	const char* markdown = "a &amp; b\n\nc\n";
+	Parser parser;
+	Document document = parser.parse(markdown);
+	WindowParser window;
+	window.load(markdown);
+	std::vector<Element> blocks = window.getBlocks(0, window.getBlockCount());
+
+	sut_assert(blocks.size() == 2);
+
+	for (size_t i = 0, j = 0; i < document.size(); i++) {
+		if (document[i].isBlockElement()) {
+			std::string expected, actual;
+			describe(expected, document[i]);
+			describe(actual, blocks[j++]);
+			sut_assert(actual == expected);
+		}
+	}
+}
+
+void
+test_only_requested_blocks_are_parsed()
+{
+	WindowParser window;
+	window.load(MARKDOWN);
+
+	sut_assert(!window.isParsed(0));
+	window.getBlocks(3, 2);
+
+	sut_assert(!window.isParsed(2));
+	sut_assert(window.isParsed(3));
+	sut_assert(window.isParsed(4));
+	sut_assert(!window.isParsed(5));
+}
+
+void
+test_window_is_clipped_to_the_end()
+{
+	WindowParser window;
+	window.load(MARKDOWN);
+	size_t count = window.getBlockCount();
+
+	sut_assert(window.getBlocks(count - 1, 20).size() == 1);
+	sut_assert(window.getBlocks(count, 20).empty());
+}
+
+void
+test_empty_input_has_no_blocks()
+{
+	WindowParser window;
+	window.load("");
+
+	sut_assert(window.getBlockCount() == 0);
+	sut_assert(window.getBlocks(0, 20).empty());
+}